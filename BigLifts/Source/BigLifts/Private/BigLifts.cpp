@@ -1,9 +1,12 @@
 #include "BigLifts.h"
 
 #include "BigLiftsConfigurationStruct.h"
+#include "BigLiftsSegmentation.h"
 #include "FGConveyorLiftHologram.h"
 #include "Patching/NativeHookManager.h"
 
+DEFINE_LOG_CATEGORY(LogBigLifts)
+
 void FBigLiftsModule::StartupModule()
 {
 #if !WITH_EDITOR
@@ -16,6 +19,8 @@ void FBigLiftsModule::StartupModule()
 			maxHeight = FMath::Max(maxHeight, hologram->mMinimumHeight);
 			hologram->mMaximumHeight = maxHeight;
 		});
+
+	FBigLiftsSegmentation::Install();
 #endif
 }
 
@@ -12,6 +12,9 @@ public:
     UPROPERTY(BlueprintReadWrite)
     int32 MaxHeight{};
 
+    UPROPERTY(BlueprintReadWrite)
+    int32 SegmentHeight{};
+
     /* Retrieves active configuration value and returns object of this struct containing it */
     static FBigLiftsConfigurationStruct GetActiveConfig(UObject* WorldContext) {
         FBigLiftsConfigurationStruct ConfigStruct{};
@@ -0,0 +1,287 @@
+#include "BigLiftsSegmentation.h"
+
+#include "Algo/MaxElement.h"
+#include "Algo/MinElement.h"
+#include "BigLifts.h"
+#include "BigLiftsConfigurationStruct.h"
+#include "Buildables/FGBuildableConveyorLift.h"
+#include "FGBuildableSubsystem.h"
+#include "FGConveyorChainActor.h"
+#include "FGConveyorLiftHologram.h"
+#include "FGFactoryConnectionComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Patching/NativeHookManager.h"
+#include "TimerManager.h"
+
+namespace
+{
+
+/// How long to wait after building a stack before checking its conveyor chains, which the buildable
+/// subsystem builds in its own time, in seconds.
+constexpr float SegmentChainCheckDelay = 2.0f;
+
+FAutoConsoleCommandWithWorldAndArgs BenchmarkFactoryTickCommand(
+	TEXT("BigLifts.BenchmarkFactoryTick"),
+	TEXT("Times each conveyor chain in the factory tick and logs how evenly the work is spread. Arguments: [Frames=600]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& args, UWorld* world)
+	{
+		int32 frameCount = 600;
+		for (const FString& arg : args)
+		{
+			FParse::Value(*arg, TEXT("Frames="), frameCount);
+		}
+		FBigLiftsSegmentation::StartBenchmark(world, FMath::Max(frameCount, 1));
+	}));
+
+double GetMean(const TArray<double>& values)
+{
+	double sum = 0.0;
+	for (const double value : values)
+	{
+		sum += value;
+	}
+	return values.IsEmpty() ? 0.0 : sum / values.Num();
+}
+
+} // namespace
+
+TUniquePtr<FBigLiftsSegmentation::FBenchmark> FBigLiftsSegmentation::Benchmark;
+
+void FBigLiftsSegmentation::Install()
+{
+	SUBSCRIBE_UOBJECT_METHOD(AFGConveyorLiftHologram, Construct,
+		[](auto& scope, AFGConveyorLiftHologram* hologram, TArray<AActor*>& out_children, FNetConstructionID constructionID)
+		{
+			const TArray<float> heights = GetSegmentHeights(hologram);
+			if (heights.IsEmpty())
+				return;	// Not tall enough to split.
+
+			// Build the bottom segment from the hologram, as if it was a shorter lift with nothing snapped
+			// to the top, then put the hologram back the way that it was.
+			const FTransform topTransform = hologram->mTopTransform;
+			UFGFactoryConnectionComponent* topConnection = hologram->mSnappedConnectionComponents[1];
+			hologram->mTopTransform = FTransform(FVector(0.0f, 0.0f, heights[0]));
+			hologram->mSnappedConnectionComponents[1] = nullptr;
+
+			AActor* result = scope(hologram, out_children, constructionID);
+
+			hologram->mTopTransform = topTransform;
+			hologram->mSnappedConnectionComponents[1] = topConnection;
+
+			if (auto* bottom = Cast<AFGBuildableConveyorLift>(result))
+			{
+				ConstructUpperSegments(bottom, heights, topTransform, topConnection, out_children);
+			}
+		});
+}
+
+TArray<float> FBigLiftsSegmentation::GetSegmentHeights(const AFGConveyorLiftHologram* hologram)
+{
+	const auto& config = FBigLiftsConfigurationStruct::GetActiveConfig(const_cast<AFGConveyorLiftHologram*>(hologram));
+	const float maxSegmentHeight = config.SegmentHeight * 100.0f;
+	if (maxSegmentHeight <= 0.0f)
+		return {};	// Turned off.
+	if (hologram->mSnappedPassthroughs[1] != nullptr)
+		return {};	// The floor hole would be left linked to the bottom segment.
+
+	const float height = hologram->mTopTransform.GetLocation().Z;
+	const float stepHeight = hologram->mStepHeight;
+	if (FMath::Abs(height) <= maxSegmentHeight || stepHeight <= 0.0f)
+		return {};
+
+	const int32 stepCount = FMath::FloorToInt32(FMath::Abs(height) / stepHeight);
+	const int32 maxSegmentSteps = FMath::Max(FMath::FloorToInt32(maxSegmentHeight / stepHeight), 1);
+	const int32 minSegmentSteps = FMath::Max(FMath::CeilToInt32(hologram->mMinimumHeight / stepHeight), 1);
+
+	// Don't make any segment shorter than a lift can be built.
+	const int32 segmentCount = FMath::Min(FMath::DivideAndRoundUp(stepCount, maxSegmentSteps), stepCount / minSegmentSteps);
+	if (segmentCount < 2)
+		return {};
+
+	// Share the whole steps out as evenly as possible, and put any part of a step that's left over (from
+	// snapping to an attachment) on the top segment.
+	TArray<float> heights;
+	heights.Reserve(segmentCount);
+	for (int32 i = 0; i < segmentCount; ++i)
+	{
+		const int32 segmentSteps = stepCount / segmentCount + (i < stepCount % segmentCount ? 1 : 0);
+		heights.Add(FMath::Sign(height) * segmentSteps * stepHeight);
+	}
+	heights.Last() += FMath::Sign(height) * (FMath::Abs(height) - stepCount * stepHeight);
+
+	return heights;
+}
+
+void FBigLiftsSegmentation::ConstructUpperSegments(AFGBuildableConveyorLift* bottom, const TArray<float>& heights, const FTransform& topTransform, UFGFactoryConnectionComponent* topConnection, TArray<AActor*>& out_children)
+{
+	TArray<TWeakObjectPtr<AFGBuildableConveyorLift>> segments;
+	segments.Add(bottom);
+
+	AFGBuildableConveyorLift* segment = bottom;
+	for (int32 i = 1; i < heights.Num(); ++i)
+	{
+		// Only the top segment turns, so that the stack ends up facing the same way as the lift would.
+		FTransform segmentTopTransform(FVector(0.0f, 0.0f, heights[i]));
+		if (i == heights.Num() - 1)
+		{
+			segmentTopTransform.SetRotation(topTransform.GetRotation());
+		}
+
+		segment = SpawnSegment(segment, segmentTopTransform);
+		out_children.Add(segment);
+		segments.Add(segment);
+	}
+
+	if (topConnection != nullptr && !topConnection->IsConnected())
+	{
+		segment->GetConnection1()->SetConnection(topConnection);
+	}
+
+	UE_LOG(LogBigLifts, Verbose, TEXT("Built a %.0fm lift as %i segments."), FMath::Abs(topTransform.GetLocation().Z) / 100.0f, heights.Num());
+
+	FTimerHandle timer;
+	bottom->GetWorldTimerManager().SetTimer(timer, FTimerDelegate::CreateLambda([segments] { CheckSegmentChains(segments); }), SegmentChainCheckDelay, false);
+}
+
+void FBigLiftsSegmentation::CheckSegmentChains(const TArray<TWeakObjectPtr<AFGBuildableConveyorLift>>& segments)
+{
+	TSet<const AFGConveyorChainActor*, DefaultKeyFuncs<const AFGConveyorChainActor*>, TInlineSetAllocator<8>> chains;
+	for (const TWeakObjectPtr<AFGBuildableConveyorLift>& segment : segments)
+	{
+		if (!segment.IsValid() || segment->GetConveyorChainActor() == nullptr)
+			return;	// Dismantled already, or the chains haven't been built yet.
+
+		chains.Add(segment->GetConveyorChainActor());
+	}
+
+	if (chains.Num() < segments.Num())
+	{
+		UE_LOG(LogBigLifts, Warning,
+			TEXT("The %i segments of %s share %i conveyor chains, so they still tick as one work item. SegmentHeight doesn't help here."),
+			segments.Num(), *segments[0]->GetName(), chains.Num());
+	}
+	else
+	{
+		UE_LOG(LogBigLifts, Log, TEXT("The %i segments of %s are in separate conveyor chains."), segments.Num(), *segments[0]->GetName());
+	}
+}
+
+AFGBuildableConveyorLift* FBigLiftsSegmentation::SpawnSegment(AFGBuildableConveyorLift* previous, const FTransform& topTransform)
+{
+	AFGBuildableSubsystem* subsystem = AFGBuildableSubsystem::Get(previous);
+
+	// Straight on top of (or under) the previous segment.
+	const FTransform transform = FTransform(previous->mTopTransform.GetLocation()) * previous->GetActorTransform();
+
+	auto* segment = CastChecked<AFGBuildableConveyorLift>(subsystem->BeginSpawnBuildable(previous->GetClass(), transform));
+	segment->mTopTransform = topTransform;
+	segment->mIsReversed = previous->mIsReversed;
+	segment->SetBuiltWithRecipe(previous->GetBuiltWithRecipe());
+	segment->SetCustomizationData_Native(previous->GetCustomizationData_Native());
+	segment->FinishSpawning(transform);
+
+	// Connected once it's spawned, the same as the hologram does it.
+	previous->GetConnection1()->SetConnection(segment->GetConnection0());
+
+	return segment;
+}
+
+void FBigLiftsSegmentation::StartBenchmark(UWorld* world, int32 frameCount)
+{
+	if (Benchmark)
+	{
+		UE_LOG(LogBigLifts, Error, TEXT("A factory tick benchmark is already running."));
+		return;
+	}
+
+	InstallBenchmarkHooks();
+
+	Benchmark = MakeUnique<FBenchmark>();
+	Benchmark->FrameCount = frameCount;
+	Benchmark->SegmentHeight = FBigLiftsConfigurationStruct::GetActiveConfig(world).SegmentHeight;
+	// The game thread works through chains too while it waits for the others.
+	Benchmark->WorkerCount = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+
+	UE_LOG(LogBigLifts, Display, TEXT("Timing the conveyor chains for %i factory ticks."), frameCount);
+}
+
+void FBigLiftsSegmentation::InstallBenchmarkHooks()
+{
+	static bool isInstalled = false;
+	if (isInstalled)
+		return;
+	isInstalled = true;
+
+	// Both hooks do nothing unless a benchmark is running.
+	SUBSCRIBE_METHOD(AFGConveyorChainActor::Factory_Tick,
+		[](auto& scope, AFGConveyorChainActor* chain, float deltaTime)
+		{
+			if (LIKELY(!Benchmark))
+				return;
+
+			const uint64 startCycles = FPlatformTime::Cycles64();
+			scope(chain, deltaTime);
+			OnChainTicked(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles));
+		});
+
+	SUBSCRIBE_UOBJECT_METHOD(AFGBuildableSubsystem, Tick,
+		[](auto& scope, AFGBuildableSubsystem* subsystem, float deltaTime)
+		{
+			if (LIKELY(!Benchmark))
+				return;
+
+			scope(subsystem, deltaTime);
+			OnFactoryTickFinished();
+		});
+}
+
+void FBigLiftsSegmentation::OnChainTicked(double milliseconds)
+{
+	FScopeLock lock(&Benchmark->FrameLock);
+	Benchmark->FrameChainTimes.Add(milliseconds);
+}
+
+void FBigLiftsSegmentation::OnFactoryTickFinished()
+{
+	FBenchmark& benchmark = *Benchmark;
+
+	// The factory tick is over, so nothing else is adding to this now.
+	TArray<double>& chainTimes = benchmark.FrameChainTimes;
+	if (chainTimes.IsEmpty())
+		return;	// No factory tick this frame.
+
+	// Hand out the longest chains first, each to whichever worker has the least to do so far, which is
+	// about as well as the parallel tick can do. However many workers there are, the tick can't finish
+	// before the longest chain does.
+	chainTimes.Sort(TGreater<double>());
+
+	TArray<double> workerTimes;
+	workerTimes.SetNumZeroed(benchmark.WorkerCount);
+	double totalTime = 0.0;
+	for (const double chainTime : chainTimes)
+	{
+		*Algo::MinElement(workerTimes) += chainTime;
+		totalTime += chainTime;
+	}
+
+	benchmark.TotalTimes.Add(totalTime);
+	benchmark.LargestTimes.Add(chainTimes[0]);
+	benchmark.ScheduledTimes.Add(*Algo::MaxElement(workerTimes));
+	benchmark.ChainCount = chainTimes.Num();
+	chainTimes.Reset();
+
+	if (benchmark.TotalTimes.Num() < benchmark.FrameCount)
+		return;	// Not done yet.
+
+	const double totalMean = GetMean(benchmark.TotalTimes);
+	const double largestMean = GetMean(benchmark.LargestTimes);
+	const double scheduledMean = GetMean(benchmark.ScheduledTimes);
+	const double idealMean = totalMean / benchmark.WorkerCount;
+
+	UE_LOG(LogBigLifts, Display,
+		TEXT("Conveyor chains over %i frames with SegmentHeight=%i: %i chains taking %.3fms in total, %.3fms for the largest, %.3fms for the busiest of %i workers (%.2fx an even split)."),
+		benchmark.FrameCount, benchmark.SegmentHeight, benchmark.ChainCount,
+		totalMean, largestMean, scheduledMean, benchmark.WorkerCount, idealMean > 0.0 ? scheduledMean / idealMean : 1.0);
+
+	Benchmark.Reset();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class AFGBuildableConveyorLift;
+class AFGConveyorLiftHologram;
+class UFGFactoryConnectionComponent;
+class UWorld;
+
+/// Builds very tall lifts as a stack of shorter lifts.
+///
+/// A single lift can be as tall as MaxHeight, which makes it one long conveyor that carries a lot of
+/// items and ends up as one big work item in the parallel conveyor tick. When SegmentHeight is set in
+/// the mod's config, a lift hologram taller than that builds the same lift as a stack of lifts of about equal
+/// height instead, each one connected straight to the next, so that items are handed over between
+/// them like between any two lifts. The player still places a single lift and pays for its whole
+/// height; any twist between the ends goes to the top segment.
+///
+/// Lifts that end in a floor hole at the top are left alone, since the floor hole only knows about
+/// the lift that it was built with.
+///
+/// Splitting only helps if the game puts the segments in separate conveyor chains, so once the chains
+/// have been built for a new stack, it logs which chain each segment ended up in.
+class FBigLiftsSegmentation
+{
+public:
+	static void Install();
+
+	/// Times every conveyor chain in the factory tick for the given number of frames, then logs how
+	/// evenly the work was spread.
+	static void StartBenchmark(UWorld* world, int32 frameCount);
+
+private:
+	/// The heights of the segments to build the hologram's lift from, bottom first, or nothing if it
+	/// should be built as it is. Negative for lifts that go down.
+	static TArray<float> GetSegmentHeights(const AFGConveyorLiftHologram* hologram);
+	static void ConstructUpperSegments(AFGBuildableConveyorLift* bottom, const TArray<float>& heights, const FTransform& topTransform, UFGFactoryConnectionComponent* topConnection, TArray<AActor*>& out_children);
+	static AFGBuildableConveyorLift* SpawnSegment(AFGBuildableConveyorLift* previous, const FTransform& topTransform);
+	static void CheckSegmentChains(const TArray<TWeakObjectPtr<AFGBuildableConveyorLift>>& segments);
+
+	static void InstallBenchmarkHooks();
+	static void OnChainTicked(double milliseconds);
+	static void OnFactoryTickFinished();
+
+	struct FBenchmark
+	{
+		int32 FrameCount = 0;
+		int32 WorkerCount = 1;
+		int32 SegmentHeight = 0;
+
+		/// Times for the current frame, added to from the factory tick threads.
+		FCriticalSection FrameLock;
+		TArray<double> FrameChainTimes;
+
+		TArray<double> TotalTimes;
+		TArray<double> LargestTimes;
+		TArray<double> ScheduledTimes;
+		int32 ChainCount = 0;
+	};
+
+	static TUniquePtr<FBenchmark> Benchmark;
+};
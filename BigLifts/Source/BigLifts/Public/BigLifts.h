@@ -3,6 +3,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogBigLifts, Log, All)
+
 class FBigLiftsModule : public IModuleInterface
 {
 public:
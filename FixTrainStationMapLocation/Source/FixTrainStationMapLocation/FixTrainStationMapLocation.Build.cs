@@ -66,7 +66,8 @@ public class FixTrainStationMapLocation : ModuleRules
 		});
 
 		PrivateIncludePaths.AddRange(new string[] {
-			// ... add private include paths required here ...
+			// Header-only code shared between our mods, compiled into each of them.
+			Path.Combine(PluginDirectory, "..", "Shared"),
 		});
 
 		PublicDependencyModuleNames.AddRange(new string[] {
@@ -0,0 +1,158 @@
+#include "FGModTrainStationLocationComponent.h"
+
+#include "Buildables/FGBuildableRailroadStation.h"
+#include "FGActorRepresentationManager.h"
+#include "FGModTrainStationRepresentation.h"
+#include "FGTrainStationIdentifier.h"
+#include "FixTrainStationMapLocation.h"
+#include "Net/UnrealNetwork.h"
+
+void FFGModPackedTrainStation::PreReplicatedRemove(const FFGModPackedTrainStationArray& serializer)
+{
+	if (serializer.Owner != nullptr)
+	{
+		serializer.Owner->RemoveClientRepresentation(*this);
+	}
+}
+
+void FFGModPackedTrainStation::PostReplicatedAdd(const FFGModPackedTrainStationArray& serializer)
+{
+	if (serializer.Owner != nullptr)
+	{
+		serializer.Owner->CreateClientRepresentation(*this);
+	}
+}
+
+void FFGModPackedTrainStation::PostReplicatedChange(const FFGModPackedTrainStationArray& serializer)
+{
+	// Also called when the station identifier finishes replicating, if it wasn't available when the
+	// item was added.
+	if (serializer.Owner != nullptr)
+	{
+		serializer.Owner->UpdateClientRepresentation(*this);
+	}
+}
+
+UFGModTrainStationLocationComponent::UFGModTrainStationLocationComponent()
+{
+	SetIsReplicatedByDefault(true);
+	mStations.Owner = this;
+}
+
+UFGModTrainStationLocationComponent* UFGModTrainStationLocationComponent::Get(const AFGActorRepresentationManager* manager)
+{
+	return manager != nullptr ? manager->FindComponentByClass<UFGModTrainStationLocationComponent>() : nullptr;
+}
+
+UFGModTrainStationLocationComponent* UFGModTrainStationLocationComponent::FindOrCreate(AFGActorRepresentationManager* manager)
+{
+	if (manager == nullptr || !manager->HasAuthority())
+		return nullptr;
+
+	if (auto* component = Get(manager))
+		return component;
+
+	// Created dynamically on the server, the client will get its own copy through replication.
+	auto* component = NewObject<UFGModTrainStationLocationComponent>(manager, TEXT("FGModTrainStationLocations"));
+	component->RegisterComponent();
+	return component;
+}
+
+void UFGModTrainStationLocationComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UFGModTrainStationLocationComponent, mStations);
+}
+
+void UFGModTrainStationLocationComponent::AddStation(AFGTrainStationIdentifier* station)
+{
+	check(GetOwnerRole() == ROLE_Authority);
+	LLM_SCOPE_BYTAG(FixTrainStationMapLocation);
+
+	const AFGBuildableRailroadStation* stationBuildable = station ? station->GetStation() : nullptr;
+	if (stationBuildable == nullptr)
+		return;
+
+	FFGModPackedTrainStation* item = mStations.Items.FindByPredicate(
+		[station](const FFGModPackedTrainStation& item) { return item.Station == station; });
+
+	if (item == nullptr)
+	{
+		item = &mStations.Items.AddDefaulted_GetRef();
+		item->Station = station;
+	}
+
+	item->Location = stationBuildable->GetActorLocation();
+	item->Name = station->GetStationName().ToString();
+	mStations.MarkItemDirty(*item);
+}
+
+void UFGModTrainStationLocationComponent::RemoveStation(AFGTrainStationIdentifier* station)
+{
+	check(GetOwnerRole() == ROLE_Authority);
+
+	const int32 index = mStations.Items.IndexOfByPredicate(
+		[station](const FFGModPackedTrainStation& item) { return item.Station == station; });
+
+	if (index != INDEX_NONE)
+	{
+		mStations.Items.RemoveAtSwap(index);
+		mStations.MarkArrayDirty();
+	}
+}
+
+const FFGModPackedTrainStation* UFGModTrainStationLocationComponent::FindStation(const AFGTrainStationIdentifier* station) const
+{
+	return mStations.Items.FindByPredicate(
+		[station](const FFGModPackedTrainStation& item) { return item.Station == station; });
+}
+
+SIZE_T UFGModTrainStationLocationComponent::GetAllocatedSize() const
+{
+	SIZE_T size = mStations.Items.GetAllocatedSize();
+	for (const FFGModPackedTrainStation& item : mStations.Items)
+	{
+		size += item.Name.GetAllocatedSize();
+	}
+	return size;
+}
+
+AFGActorRepresentationManager* UFGModTrainStationLocationComponent::GetManager() const
+{
+	return Cast<AFGActorRepresentationManager>(GetOwner());
+}
+
+void UFGModTrainStationLocationComponent::CreateClientRepresentation(FFGModPackedTrainStation& item)
+{
+	if (item.HasClientRepresentation || item.Station == nullptr)
+		return;
+
+	LLM_SCOPE_BYTAG(FixTrainStationMapLocation);
+	if (AFGActorRepresentationManager* manager = GetManager())
+	{
+		// The representation picks up its location from us, see UFGModTrainStationRepresentation.
+		item.HasClientRepresentation = manager->CreateAndAddNewRepresentation(
+			item.Station, true, UFGModTrainStationRepresentation::StaticClass());
+	}
+}
+
+void UFGModTrainStationLocationComponent::UpdateClientRepresentation(FFGModPackedTrainStation& item)
+{
+	// Stations never move, so this only happens when they're renamed. That's rare enough that it's
+	// simplest to just start again.
+	RemoveClientRepresentation(item);
+	CreateClientRepresentation(item);
+}
+
+void UFGModTrainStationLocationComponent::RemoveClientRepresentation(FFGModPackedTrainStation& item)
+{
+	if (!item.HasClientRepresentation || item.Station == nullptr)
+		return;
+
+	if (AFGActorRepresentationManager* manager = GetManager())
+	{
+		manager->RemoveRepresentationOfActor(item.Station);
+	}
+	item.HasClientRepresentation = false;
+}
@@ -0,0 +1,129 @@
+#include "FGModTrainStationMapCache.h"
+
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "FGGameState.h"
+#include "FixTrainStationMapLocation.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+FString FFGModTrainStationMapCache::MakeKey(const UWorld* world)
+{
+	if (world == nullptr || world->GetNetMode() != NM_Client)
+		return FString();	// The server always has all of the stations.
+
+	const auto* gameState = world->GetGameState<AFGGameState>();
+	const FString sessionName = gameState ? gameState->GetSessionName() : FString();
+
+	return FString::Printf(TEXT("%s:%i/%s"), *world->URL.Host, world->URL.Port, *sessionName);
+}
+
+FIntVector FFGModTrainStationMapCache::GetStationId(const FVector& location)
+{
+	// Rounded to the nearest metre. The replicated locations are quantized, so they can round to the
+	// metre next to the cached one, which UFGModTrainStationMapSubsystem::FindCachedStation allows for.
+	return FIntVector(
+		FMath::RoundToInt32(location.X / 100.0),
+		FMath::RoundToInt32(location.Y / 100.0),
+		FMath::RoundToInt32(location.Z / 100.0));
+}
+
+FString FFGModTrainStationMapCache::GetFilePath() const
+{
+	const FString fileName = FString::Printf(TEXT("%08x.json"), FCrc::StrCrc32(*Key));
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("FixTrainStationMapLocation"), TEXT("StationCache"), fileName);
+}
+
+bool FFGModTrainStationMapCache::Load()
+{
+	Stations.Reset();
+
+	FString json;
+	if (!FFileHelper::LoadFileToString(json, *GetFilePath()))
+		return false;	// Haven't been here before.
+
+	TSharedPtr<FJsonObject> root;
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(json), root) || !root.IsValid())
+	{
+		UE_LOG(LogFixTrainStationMapLocation, Warning, TEXT("Failed to parse %s, ignoring it."), *GetFilePath());
+		return false;
+	}
+
+	int32 fileVersion = 0;
+	if (!root->TryGetNumberField(TEXT("Version"), fileVersion) || fileVersion != Version)
+		return false;
+
+	FString fileKey;
+	if (!root->TryGetStringField(TEXT("Key"), fileKey) || fileKey != Key)
+		return false;
+
+	const TArray<TSharedPtr<FJsonValue>>* entries = nullptr;
+	if (root->TryGetArrayField(TEXT("Stations"), entries))
+	{
+		Stations.Reserve(entries->Num());
+		for (const TSharedPtr<FJsonValue>& value : *entries)
+		{
+			const TSharedPtr<FJsonObject>* entry = nullptr;
+			if (!value->TryGetObject(entry))
+				continue;
+
+			FStation station;
+			if ((*entry)->TryGetStringField(TEXT("Name"), station.Name)
+				&& (*entry)->TryGetNumberField(TEXT("X"), station.Location.X)
+				&& (*entry)->TryGetNumberField(TEXT("Y"), station.Location.Y)
+				&& (*entry)->TryGetNumberField(TEXT("Z"), station.Location.Z))
+			{
+				// The icon is optional, the map falls back to the default for the representation type.
+				FString texture, color;
+				if ((*entry)->TryGetStringField(TEXT("Texture"), texture))
+				{
+					station.Texture.SetPath(texture);
+				}
+				if ((*entry)->TryGetStringField(TEXT("Color"), color))
+				{
+					station.Color.InitFromString(color);
+				}
+				Stations.Add(MoveTemp(station));
+			}
+		}
+	}
+
+	return true;
+}
+
+bool FFGModTrainStationMapCache::Save() const
+{
+	TArray<TSharedPtr<FJsonValue>> entries;
+	entries.Reserve(Stations.Num());
+	for (const FStation& station : Stations)
+	{
+		auto entry = MakeShared<FJsonObject>();
+		entry->SetStringField(TEXT("Name"), station.Name);
+		entry->SetNumberField(TEXT("X"), station.Location.X);
+		entry->SetNumberField(TEXT("Y"), station.Location.Y);
+		entry->SetNumberField(TEXT("Z"), station.Location.Z);
+		entry->SetStringField(TEXT("Texture"), station.Texture.ToString());
+		entry->SetStringField(TEXT("Color"), station.Color.ToString());
+		entries.Add(MakeShared<FJsonValueObject>(MoveTemp(entry)));
+	}
+
+	auto root = MakeShared<FJsonObject>();
+	root->SetNumberField(TEXT("Version"), Version);
+	root->SetStringField(TEXT("Key"), Key);
+	root->SetArrayField(TEXT("Stations"), MoveTemp(entries));
+
+	FString json;
+	if (!FJsonSerializer::Serialize(root, TJsonWriterFactory<>::Create(&json)))
+		return false;
+
+	if (!FFileHelper::SaveStringToFile(json, *GetFilePath()))
+	{
+		UE_LOG(LogFixTrainStationMapLocation, Warning, TEXT("Failed to write %s."), *GetFilePath());
+		return false;
+	}
+
+	return true;
+}
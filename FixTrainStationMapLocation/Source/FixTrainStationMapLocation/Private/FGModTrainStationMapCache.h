@@ -0,0 +1,41 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+/// On-disk cache of the train stations that a client last saw on a server, so that the map can show
+/// them as soon as the client joins rather than waiting for them all to replicate.
+///
+/// There's one file per server and session, since one server can host more than one save. The
+/// stations don't have an ID that survives reconnecting, so they're matched up by location instead;
+/// stations can't be moved, and they're far too big to be built in the same place as each other.
+struct FFGModTrainStationMapCache
+{
+	/// Bump this whenever the file format changes.
+	static constexpr int32 Version = 2;
+
+	struct FStation
+	{
+		FString Name;
+		FVector Location = FVector::ZeroVector;
+		/// The map icon, so that the stand-in looks the same as the real station.
+		FSoftObjectPath Texture;
+		FLinearColor Color = FLinearColor::White;
+	};
+
+	/// The server address and session name that the stations came from.
+	FString Key;
+
+	TArray<FStation> Stations;
+
+	/// Returns an empty key if the world isn't connected to a server.
+	static FString MakeKey(const UWorld* world);
+	static FIntVector GetStationId(const FVector& location);
+	FString GetFilePath() const;
+
+	/// Returns false if the cache doesn't exist, was written by a different version or is for a
+	/// different key that happens to have the same file name.
+	bool Load();
+	bool Save() const;
+};
@@ -0,0 +1,567 @@
+#include "FGModTrainStationMapSubsystem.h"
+
+#include "Algo/BinarySearch.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "FGActorRepresentation.h"
+#include "FGActorRepresentationManager.h"
+#include "FGModTrainStationMapCache.h"
+#include "FGModTrainStationRepresentation.h"
+#include "FGModTrainStationSearch.h"
+#include "FixTrainStationMapLocation.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "ModMemoryTally.h"
+#include "TimerManager.h"
+
+namespace
+{
+
+TAutoConsoleVariable<bool> CVarStationMapCache(
+	TEXT("FTSML.StationMapCache"),
+	true,
+	TEXT("Remember the train stations on each server, and show them on the map straight away when joining it again."));
+
+} // namespace
+
+UFGModTrainStationMapSubsystem* UFGModTrainStationMapSubsystem::Get(const UObject* worldContext)
+{
+	const UWorld* world = worldContext ? worldContext->GetWorld() : nullptr;
+	return world ? world->GetSubsystem<UFGModTrainStationMapSubsystem>() : nullptr;
+}
+
+bool UFGModTrainStationMapSubsystem::ShouldCreateSubsystem(UObject* outer) const
+{
+	// Nobody looks at the map on a dedicated server.
+	return Super::ShouldCreateSubsystem(outer) && !IsRunningDedicatedServer();
+}
+
+void UFGModTrainStationMapSubsystem::Deinitialize()
+{
+	CloseStationSearch();
+	SaveCachedStations();
+
+	if (UWorld* world = GetWorld())
+	{
+		world->GetTimerManager().ClearTimer(mStaleCachedStationsTimer);
+	}
+
+	if (AFGActorRepresentationManager* manager = mManager.Get())
+	{
+		manager->OnActorRepresentationAdded.RemoveAll(this);
+		manager->OnActorRepresentationUpdated.RemoveAll(this);
+		manager->OnActorRepresentationRemoved.RemoveAll(this);
+	}
+
+	Super::Deinitialize();
+}
+
+void UFGModTrainStationMapSubsystem::BindToManager(AFGActorRepresentationManager* manager)
+{
+	if (manager == nullptr || mManager == manager)
+		return;
+
+	mManager = manager;
+	manager->OnActorRepresentationAdded.AddDynamic(this, &UFGModTrainStationMapSubsystem::OnRepresentationAdded);
+	manager->OnActorRepresentationUpdated.AddDynamic(this, &UFGModTrainStationMapSubsystem::OnRepresentationUpdated);
+	manager->OnActorRepresentationRemoved.AddDynamic(this, &UFGModTrainStationMapSubsystem::OnRepresentationRemoved);
+
+	LoadCachedStations();
+
+	// Pick up anything that was added before we got here.
+	for (UFGActorRepresentation* representation : manager->GetAllActorRepresentations())
+	{
+		OnRepresentationAdded(representation);
+	}
+}
+
+void UFGModTrainStationMapSubsystem::GetStationClusters(const FBox2D& visibleBounds, float iconSpacing, TArray<FFGModTrainStationCluster>& out_clusters) const
+{
+	out_clusters.Reset();
+	if (!visibleBounds.bIsValid)
+		return;
+
+	// Use the smallest cells that are at least as big as the spacing.
+	int32 level = 0;
+	while (level < NumLevels - 1 && BaseCellSize * (1 << level) < iconSpacing)
+	{
+		++level;
+	}
+
+	const auto addCluster = [&out_clusters](const FCell& cell)
+	{
+		FFGModTrainStationCluster& cluster = out_clusters.AddDefaulted_GetRef();
+		cluster.Location = cell.SumLocation / cell.Stations.Num();
+		cluster.NumStations = cell.Stations.Num();
+		cluster.Station = cell.Stations.Num() == 1 ? cell.Stations[0].Get() : nullptr;
+	};
+
+	const FLevel& cells = mLevels[level];
+	const FIntPoint minCell = GetCell(FVector(visibleBounds.Min, 0.0), level);
+	const FIntPoint maxCell = GetCell(FVector(visibleBounds.Max, 0.0), level);
+	const int64 numVisibleCells = int64(maxCell.X - minCell.X + 1) * int64(maxCell.Y - minCell.Y + 1);
+
+	// Zoomed in, it's cheaper to look up the handful of visible cells; zoomed out, it's cheaper to go
+	// through the cells that actually have stations in them.
+	if (numVisibleCells < cells.Num())
+	{
+		for (int32 y = minCell.Y; y <= maxCell.Y; ++y)
+		{
+			for (int32 x = minCell.X; x <= maxCell.X; ++x)
+			{
+				if (const FCell* cell = cells.Find(FIntPoint(x, y)))
+				{
+					addCluster(*cell);
+				}
+			}
+		}
+	}
+	else
+	{
+		for (const auto& [key, cell] : cells)
+		{
+			if (key.X >= minCell.X && key.X <= maxCell.X && key.Y >= minCell.Y && key.Y <= maxCell.Y)
+			{
+				addCluster(cell);
+			}
+		}
+	}
+}
+
+void UFGModTrainStationMapSubsystem::SearchStations(const FString& query, int32 maxResults, TArray<UFGActorRepresentation*>& out_stations) const
+{
+	out_stations.Reset();
+
+	const FString normalizedQuery = NormalizeName(query);
+	if (normalizedQuery.IsEmpty() || maxResults <= 0)
+		return;
+
+	SortNames();
+
+	// Names starting with the query are all next to each other in the sorted list.
+	const auto byName = [](const FNamedStation& station) -> const FString& { return station.Name; };
+	for (int32 index = Algo::LowerBoundBy(mSortedNames, normalizedQuery, byName); index < mSortedNames.Num(); ++index)
+	{
+		const FNamedStation& station = mSortedNames[index];
+		if (!station.Name.StartsWith(normalizedQuery, ESearchCase::CaseSensitive))
+			break;
+
+		if (UFGActorRepresentation* representation = station.Station.Get())
+		{
+			out_stations.Add(representation);
+			if (out_stations.Num() >= maxResults)
+				return;
+		}
+	}
+
+	if (normalizedQuery.Len() < 3)
+		return;	// Too short for a trigram, so only prefixes are matched.
+
+	// Every station containing the query contains all of its trigrams, so the rarest trigram gives the
+	// smallest set of candidates to check.
+	const TArray<TWeakObjectPtr<UFGActorRepresentation>>* candidates = nullptr;
+	for (int32 index = 0; index + 3 <= normalizedQuery.Len(); ++index)
+	{
+		const auto* stations = mTrigrams.Find(GetTrigram(normalizedQuery, index));
+		if (stations == nullptr)
+			return;	// Nothing has this trigram.
+		if (candidates == nullptr || stations->Num() < candidates->Num())
+		{
+			candidates = stations;
+		}
+	}
+
+	for (const TWeakObjectPtr<UFGActorRepresentation>& candidate : *candidates)
+	{
+		const FString* name = mStationNames.Find(candidate);
+		if (name == nullptr || !name->Contains(normalizedQuery, ESearchCase::CaseSensitive))
+			continue;
+		if (name->StartsWith(normalizedQuery, ESearchCase::CaseSensitive))
+			continue;	// Already found by the prefix search.
+
+		// Names with the trigram more than once are in the list more than once.
+		if (UFGActorRepresentation* representation = candidate.Get(); representation && !out_stations.Contains(representation))
+		{
+			out_stations.Add(representation);
+			if (out_stations.Num() >= maxResults)
+				return;
+		}
+	}
+}
+
+void UFGModTrainStationMapSubsystem::OnRepresentationAdded(UFGActorRepresentation* representation)
+{
+	if (IsStation(representation))
+	{
+		AddStation(representation);
+		ReconcileCachedStation(representation);
+	}
+}
+
+void UFGModTrainStationMapSubsystem::OnRepresentationUpdated(UFGActorRepresentation* representation)
+{
+	if (IsStation(representation))
+	{
+		RemoveStation(representation);
+		AddStation(representation);
+		ReconcileCachedStation(representation);
+	}
+}
+
+void UFGModTrainStationMapSubsystem::OnRepresentationRemoved(UFGActorRepresentation* representation)
+{
+	if (IsStation(representation))
+	{
+		RemoveStation(representation);
+	}
+}
+
+void UFGModTrainStationMapSubsystem::AddStation(UFGActorRepresentation* representation)
+{
+	if (mStationLocations.Contains(representation))
+		return;	// Already added.
+
+	LLM_SCOPE_BYTAG(FixTrainStationMapLocation);
+	const FVector location = representation->GetActorLocation();
+	mStationLocations.Add(representation, location);
+
+	for (int32 level = 0; level < NumLevels; ++level)
+	{
+		FCell& cell = mLevels[level].FindOrAdd(GetCell(location, level));
+		cell.SumLocation += location;
+		cell.Stations.Add(representation);
+	}
+
+	AddStationName(representation);
+}
+
+void UFGModTrainStationMapSubsystem::RemoveStation(UFGActorRepresentation* representation)
+{
+	FVector location;
+	if (!mStationLocations.RemoveAndCopyValue(representation, location))
+		return;	// Never added.
+
+	for (int32 level = 0; level < NumLevels; ++level)
+	{
+		const FIntPoint key = GetCell(location, level);
+		if (FCell* cell = mLevels[level].Find(key))
+		{
+			cell->SumLocation -= location;
+			cell->Stations.RemoveSingleSwap(representation);
+			if (cell->Stations.IsEmpty())
+			{
+				mLevels[level].Remove(key);
+			}
+		}
+	}
+
+	RemoveStationName(representation);
+}
+
+void UFGModTrainStationMapSubsystem::AddStationName(UFGActorRepresentation* representation)
+{
+	const FString name = NormalizeName(representation->GetRepresentationText().ToString());
+	mStationNames.Add(representation, name);
+
+	mSortedNames.Add({ name, representation });
+	mAreNamesSorted = false;
+
+	// Added once per appearance rather than with AddUnique, which would make every station added
+	// slower than the last one for the common trigrams.
+	for (int32 index = 0; index + 3 <= name.Len(); ++index)
+	{
+		mTrigrams.FindOrAdd(GetTrigram(name, index)).Add(representation);
+	}
+}
+
+void UFGModTrainStationMapSubsystem::RemoveStationName(UFGActorRepresentation* representation)
+{
+	FString name;
+	if (!mStationNames.RemoveAndCopyValue(representation, name))
+		return;	// Never added.
+
+	if (mAreNamesSorted)
+	{
+		const auto byName = [](const FNamedStation& station) -> const FString& { return station.Name; };
+		for (int32 index = Algo::LowerBoundBy(mSortedNames, name, byName); index < mSortedNames.Num() && mSortedNames[index].Name == name; ++index)
+		{
+			if (mSortedNames[index].Station == representation)
+			{
+				mSortedNames.RemoveAt(index);
+				break;
+			}
+		}
+	}
+	else
+	{
+		// The order doesn't matter until it's sorted anyway.
+		const int32 index = mSortedNames.IndexOfByPredicate([representation](const FNamedStation& station) { return station.Station == representation; });
+		if (index != INDEX_NONE)
+		{
+			mSortedNames.RemoveAtSwap(index);
+		}
+	}
+
+	for (int32 index = 0; index + 3 <= name.Len(); ++index)
+	{
+		const uint64 trigram = GetTrigram(name, index);
+		if (auto* stations = mTrigrams.Find(trigram))
+		{
+			stations->RemoveSingleSwap(representation);
+			if (stations->IsEmpty())
+			{
+				mTrigrams.Remove(trigram);
+			}
+		}
+	}
+}
+
+void UFGModTrainStationMapSubsystem::LoadCachedStations()
+{
+	if (!CVarStationMapCache.GetValueOnGameThread())
+		return;
+
+	FFGModTrainStationMapCache cache;
+	cache.Key = FFGModTrainStationMapCache::MakeKey(GetWorld());
+	if (cache.Key.IsEmpty())
+		return;	// Not a client.
+
+	LLM_SCOPE_BYTAG(FixTrainStationMapLocation);
+	mCacheKey = cache.Key;
+	if (!cache.Load())
+		return;
+
+	AFGActorRepresentationManager* manager = mManager.Get();
+	for (const FFGModTrainStationMapCache::FStation& station : cache.Stations)
+	{
+		const FIntVector id = FFGModTrainStationMapCache::GetStationId(station.Location);
+		if (mCachedStations.Contains(id))
+			continue;
+
+		auto* representation = NewObject<UFGModTrainStationRepresentation>(manager);
+		representation->SetupCachedStation(station.Location, station.Name, Cast<UTexture2D>(station.Texture.TryLoad()), station.Color);
+
+		// The map only knows about the representations in the manager, and picks them up from this
+		// delegate. That also adds the stand-in to our own index through OnRepresentationAdded.
+		mCachedStations.Add(id, representation);
+		manager->mLocalRepresentations.Add(representation);
+		manager->OnActorRepresentationAdded.Broadcast(representation);
+	}
+
+	if (!mCachedStations.IsEmpty())
+	{
+		UE_LOG(LogFixTrainStationMapLocation, Log, TEXT("Showing %i cached stations until the server sends them."), mCachedStations.Num());
+		GetWorld()->GetTimerManager().SetTimer(mStaleCachedStationsTimer, this, &UFGModTrainStationMapSubsystem::RemoveStaleCachedStations, FirstStationDelay);
+	}
+}
+
+void UFGModTrainStationMapSubsystem::SaveCachedStations() const
+{
+	if (mCacheKey.IsEmpty())
+		return;
+
+	// Any cached stations that haven't been matched yet are kept, since there's no reason to think that
+	// they've gone.
+	FFGModTrainStationMapCache cache;
+	cache.Key = mCacheKey;
+	cache.Stations.Reserve(mStationLocations.Num());
+	for (const auto& [station, location] : mStationLocations)
+	{
+		if (const UFGActorRepresentation* representation = station.Get())
+		{
+			cache.Stations.Add({
+				representation->GetRepresentationText().ToString(),
+				location,
+				FSoftObjectPath(representation->GetRepresentationTexture()),
+				representation->GetRepresentationColor() });
+		}
+	}
+
+	cache.Save();
+}
+
+void UFGModTrainStationMapSubsystem::ReconcileCachedStation(UFGActorRepresentation* representation)
+{
+	if (mCachedStations.IsEmpty())
+		return;
+
+	FIntVector id;
+	if (UFGActorRepresentation* staleStation = FindCachedStation(representation->GetActorLocation(), id))
+	{
+		if (staleStation == representation)
+			return;	// It's one of the stand-ins.
+
+		mCachedStations.Remove(id);
+		RemoveCachedStation(staleStation);
+	}
+
+	// The real stations arrive in bursts, so give the rest a little longer.
+	if (!mCachedStations.IsEmpty())
+	{
+		GetWorld()->GetTimerManager().SetTimer(mStaleCachedStationsTimer, this, &UFGModTrainStationMapSubsystem::RemoveStaleCachedStations, StaleCachedStationDelay);
+	}
+}
+
+UFGActorRepresentation* UFGModTrainStationMapSubsystem::FindCachedStation(const FVector& location, FIntVector& out_id) const
+{
+	// The replicated location is quantized, so a station that's close to half a metre out can round to
+	// a different metre to the one that was cached.
+	const FIntVector centre = FFGModTrainStationMapCache::GetStationId(location);
+	UFGActorRepresentation* nearestStation = nullptr;
+	double nearestDistanceSquared = FMath::Square(CachedStationTolerance);
+
+	for (int32 x = -1; x <= 1; ++x)
+	{
+		for (int32 y = -1; y <= 1; ++y)
+		{
+			for (int32 z = -1; z <= 1; ++z)
+			{
+				const FIntVector id = centre + FIntVector(x, y, z);
+				UFGActorRepresentation* const* cachedStation = mCachedStations.Find(id);
+				if (cachedStation == nullptr)
+					continue;
+
+				const double distanceSquared = FVector::DistSquared((*cachedStation)->GetActorLocation(), location);
+				if (distanceSquared <= nearestDistanceSquared)
+				{
+					nearestStation = *cachedStation;
+					nearestDistanceSquared = distanceSquared;
+					out_id = id;
+				}
+			}
+		}
+	}
+
+	return nearestStation;
+}
+
+void UFGModTrainStationMapSubsystem::RemoveStaleCachedStations()
+{
+	if (mCachedStations.IsEmpty())
+		return;
+
+	UE_LOG(LogFixTrainStationMapLocation, Log, TEXT("Removing %i cached stations that the server didn't send."), mCachedStations.Num());
+
+	for (const auto& [id, cachedStation] : mCachedStations)
+	{
+		RemoveCachedStation(cachedStation);
+	}
+	mCachedStations.Empty();
+}
+
+void UFGModTrainStationMapSubsystem::RemoveCachedStation(UFGActorRepresentation* representation)
+{
+	// Removed through the manager so that the map drops its icon, which also removes it from our
+	// index through OnRepresentationRemoved.
+	if (AFGActorRepresentationManager* manager = mManager.Get())
+	{
+		manager->mLocalRepresentations.Remove(representation);
+		manager->OnActorRepresentationRemoved.Broadcast(representation);
+	}
+
+	RemoveStation(representation);	// In case the manager has already gone.
+}
+
+void UFGModTrainStationMapSubsystem::ToggleStationSearch(APlayerController* playerController)
+{
+	if (mStationSearch.IsValid())
+	{
+		CloseStationSearch();
+		return;
+	}
+
+	UGameViewportClient* viewport = GetWorld()->GetGameViewport();
+	if (viewport == nullptr || playerController == nullptr)
+		return;
+
+	mStationSearch = SNew(SFGModTrainStationSearch)
+		.Subsystem(this)
+		.PlayerController(playerController)
+		.OnClosed(FSimpleDelegate::CreateUObject(this, &UFGModTrainStationMapSubsystem::CloseStationSearch));
+	mStationSearchPlayer = playerController;
+
+	viewport->AddViewportWidgetContent(mStationSearch.ToSharedRef(), 100);
+	playerController->SetInputMode(FInputModeUIOnly().SetWidgetToFocus(mStationSearch->GetSearchBox()));
+	playerController->SetShowMouseCursor(true);
+}
+
+void UFGModTrainStationMapSubsystem::CloseStationSearch()
+{
+	if (!mStationSearch.IsValid())
+		return;
+
+	if (UGameViewportClient* viewport = GetWorld() ? GetWorld()->GetGameViewport() : nullptr)
+	{
+		viewport->RemoveViewportWidgetContent(mStationSearch.ToSharedRef());
+	}
+	if (APlayerController* playerController = mStationSearchPlayer.Get())
+	{
+		playerController->SetInputMode(FInputModeGameOnly());
+		playerController->SetShowMouseCursor(false);
+	}
+
+	mStationSearch.Reset();
+	mStationSearchPlayer.Reset();
+}
+
+void UFGModTrainStationMapSubsystem::DumpMemoryReport(FOutputDevice& ar) const
+{
+	SIZE_T indexBytes = mStationNames.GetAllocatedSize() + mSortedNames.GetAllocatedSize() + mTrigrams.GetAllocatedSize();
+	for (auto&& [station, name] : mStationNames)
+	{
+		// Each name is kept again in mSortedNames.
+		indexBytes += name.GetAllocatedSize() * 2;
+	}
+	for (auto&& [trigram, stations] : mTrigrams)
+	{
+		indexBytes += stations.GetAllocatedSize();
+	}
+
+	SIZE_T clusterBytes = mStationLocations.GetAllocatedSize();
+	int32 cellCount = 0;
+	for (const FLevel& cells : mLevels)
+	{
+		clusterBytes += cells.GetAllocatedSize();
+		cellCount += cells.Num();
+		for (auto&& [key, cell] : cells)
+		{
+			clusterBytes += cell.Stations.GetAllocatedSize();
+		}
+	}
+
+	FModMemoryTally::PrintEntries(ar, TEXT("Station cluster cells"), cellCount, clusterBytes);
+	FModMemoryTally::PrintEntries(ar, TEXT("Station search index"), mStationNames.Num(), indexBytes);
+	FModMemoryTally::PrintEntries(ar, TEXT("Cached stations"), mCachedStations.Num(), mCachedStations.GetAllocatedSize());
+}
+
+void UFGModTrainStationMapSubsystem::SortNames() const
+{
+	if (mAreNamesSorted)
+		return;
+
+	mSortedNames.Sort([](const FNamedStation& a, const FNamedStation& b) { return a.Name < b.Name; });
+	mAreNamesSorted = true;
+}
+
+bool UFGModTrainStationMapSubsystem::IsStation(const UFGActorRepresentation* representation)
+{
+	return representation != nullptr && representation->IsA<UFGModTrainStationRepresentation>();
+}
+
+FIntPoint UFGModTrainStationMapSubsystem::GetCell(const FVector& location, int32 level)
+{
+	const double cellSize = BaseCellSize * (1 << level);
+	return FIntPoint(FMath::FloorToInt32(location.X / cellSize), FMath::FloorToInt32(location.Y / cellSize));
+}
+
+FString UFGModTrainStationMapSubsystem::NormalizeName(const FString& name)
+{
+	return name.TrimStartAndEnd().ToLower();
+}
+
+uint64 UFGModTrainStationMapSubsystem::GetTrigram(const FString& name, int32 index)
+{
+	// 21 bits is enough for any code point.
+	return (uint64(name[index]) << 42) | (uint64(name[index + 1]) << 21) | uint64(name[index + 2]);
+}
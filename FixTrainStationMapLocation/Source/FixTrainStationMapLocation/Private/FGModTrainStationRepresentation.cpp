@@ -1,5 +1,9 @@
 #include "FGModTrainStationRepresentation.h"
 
+#include "FGActorRepresentationManager.h"
+#include "FGModTrainStationLocationComponent.h"
+#include "FGTrainStationIdentifier.h"
+
 UFGModTrainStationRepresentation::UFGModTrainStationRepresentation()
 {
 	// The real actor (AFGTrainStationIdentifier) is always available on all clients, but the station
@@ -7,3 +11,31 @@ UFGModTrainStationRepresentation::UFGModTrainStationRepresentation()
 	// because that will try to ask the (potentially non-existent) station for its transform.
 	mAllowRealActorLocationOnClient = false;
 }
+
+void UFGModTrainStationRepresentation::SetupActorRepresentation(AActor* realActor, bool isLocal, float lifeSpan)
+{
+	Super::SetupActorRepresentation(realActor, isLocal, lifeSpan);
+
+	if (!isLocal || realActor == nullptr || realActor->HasAuthority())
+		return;	// Not created from the packed station locations.
+
+	// Same problem as above, but this time there's no server copy of the representation to get the
+	// location from, so take it from the packed stations instead.
+	const auto* stations = UFGModTrainStationLocationComponent::Get(AFGActorRepresentationManager::Get(realActor));
+	if (const FFGModPackedTrainStation* station = stations ? stations->FindStation(Cast<AFGTrainStationIdentifier>(realActor)) : nullptr)
+	{
+		mActorLocation = station->Location;
+		mRepresentationText = FText::FromString(station->Name);
+	}
+}
+
+void UFGModTrainStationRepresentation::SetupCachedStation(const FVector& location, const FString& name, UTexture2D* texture, const FLinearColor& color)
+{
+	mIsLocal = true;
+	mRepresentationType = ERepresentationType::RT_TrainStation;
+	mActorLocation = location;
+	mRepresentationText = FText::FromString(name);
+	mRepresentationTexture = texture;
+	mRepresentationColor = color;
+	mShouldShowOnMap = true;
+}
@@ -0,0 +1,143 @@
+#include "FGModTrainStationSearch.h"
+
+#include "FGActorRepresentation.h"
+#include "FGModTrainStationMapSubsystem.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Styling/AppStyle.h"
+#include "Widgets/Input/SSearchBox.h"
+#include "Widgets/Layout/SBorder.h"
+#include "Widgets/Layout/SBox.h"
+#include "Widgets/SBoxPanel.h"
+#include "Widgets/Text/STextBlock.h"
+#include "Widgets/Views/STableRow.h"
+
+#define LOCTEXT_NAMESPACE "FixTrainStationMapLocation"
+
+void SFGModTrainStationSearch::Construct(const FArguments& args)
+{
+	Subsystem = args._Subsystem;
+	PlayerController = args._PlayerController;
+	OnClosed = args._OnClosed;
+
+	ChildSlot
+	.HAlign(HAlign_Center)
+	.VAlign(VAlign_Top)
+	.Padding(0.0f, 120.0f, 0.0f, 0.0f)
+	[
+		SNew(SBox)
+		.WidthOverride(480.0f)
+		[
+			SNew(SBorder)
+			.BorderImage(FAppStyle::GetBrush("ToolPanel.DarkGroupBorder"))
+			.Padding(8.0f)
+			[
+				SNew(SVerticalBox)
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				[
+					SAssignNew(SearchBox, SSearchBox)
+					.HintText(LOCTEXT("StationSearchHint", "Find a train station"))
+					.OnTextChanged(this, &SFGModTrainStationSearch::OnQueryChanged)
+					.OnTextCommitted(this, &SFGModTrainStationSearch::OnQueryCommitted)
+				]
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.MaxHeight(480.0f)
+				.Padding(0.0f, 4.0f, 0.0f, 0.0f)
+				[
+					SAssignNew(ResultList, SListView<FResultPtr>)
+					.ListItemsSource(&Results)
+					.SelectionMode(ESelectionMode::Single)
+					.OnGenerateRow(this, &SFGModTrainStationSearch::MakeResultRow)
+					.OnMouseButtonClick(this, &SFGModTrainStationSearch::Pick)
+				]
+			]
+		]
+	];
+}
+
+TSharedPtr<SWidget> SFGModTrainStationSearch::GetSearchBox() const
+{
+	return SearchBox;
+}
+
+FReply SFGModTrainStationSearch::OnKeyDown(const FGeometry& geometry, const FKeyEvent& keyEvent)
+{
+	if (keyEvent.GetKey() == EKeys::Escape)
+	{
+		OnClosed.ExecuteIfBound();
+		return FReply::Handled();
+	}
+	return SCompoundWidget::OnKeyDown(geometry, keyEvent);
+}
+
+void SFGModTrainStationSearch::OnQueryChanged(const FText& query)
+{
+	Results.Reset();
+
+	if (const UFGModTrainStationMapSubsystem* subsystem = Subsystem.Get())
+	{
+		TArray<UFGActorRepresentation*> stations;
+		subsystem->SearchStations(query.ToString(), MaxResults, stations);
+
+		for (const UFGActorRepresentation* station : stations)
+		{
+			Results.Add(MakeShared<FResult>(FResult{ station->GetRepresentationText(), station->GetActorLocation() }));
+		}
+	}
+
+	ResultList->RequestListRefresh();
+}
+
+void SFGModTrainStationSearch::OnQueryCommitted(const FText& query, ETextCommit::Type commitType)
+{
+	if (commitType == ETextCommit::OnEnter && !Results.IsEmpty())
+	{
+		Pick(Results[0]);	// Enter picks the best match.
+	}
+}
+
+TSharedRef<ITableRow> SFGModTrainStationSearch::MakeResultRow(FResultPtr result, const TSharedRef<STableViewBase>& owner) const
+{
+	return SNew(STableRow<FResultPtr>, owner)
+		.Padding(4.0f)
+		[
+			SNew(SHorizontalBox)
+			+ SHorizontalBox::Slot()
+			.FillWidth(1.0f)
+			[
+				SNew(STextBlock)
+				.Text(result->Name)
+			]
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			[
+				SNew(STextBlock)
+				.Text(GetDistanceText(result->Location))
+			]
+		];
+}
+
+void SFGModTrainStationSearch::Pick(const FResultPtr& result)
+{
+	const APawn* pawn = PlayerController.IsValid() ? PlayerController->GetPawn() : nullptr;
+	if (result.IsValid() && pawn != nullptr)
+	{
+		PlayerController->SetControlRotation((result->Location - pawn->GetPawnViewLocation()).Rotation());
+	}
+
+	OnClosed.ExecuteIfBound();
+}
+
+FText SFGModTrainStationSearch::GetDistanceText(const FVector& location) const
+{
+	const APawn* pawn = PlayerController.IsValid() ? PlayerController->GetPawn() : nullptr;
+	if (pawn == nullptr)
+		return FText::GetEmpty();
+
+	const int32 metres = FMath::RoundToInt32(FVector::Dist(pawn->GetActorLocation(), location) / 100.0);
+	return FText::Format(LOCTEXT("StationDistance", "{0} m"), FText::AsNumber(metres));
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SCompoundWidget.h"
+#include "Widgets/Views/SListView.h"
+
+class APlayerController;
+class ITableRow;
+class SSearchBox;
+class STableViewBase;
+class UFGActorRepresentation;
+class UFGModTrainStationMapSubsystem;
+
+/// A search box for finding a train station by name, opened with FTSML.FindStation.
+///
+/// Results come from UFGModTrainStationMapSubsystem's name index as each character is typed, with
+/// how far away each station is. Picking one turns the player to face it and closes the box.
+class SFGModTrainStationSearch : public SCompoundWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SFGModTrainStationSearch) {}
+		SLATE_ARGUMENT(TWeakObjectPtr<UFGModTrainStationMapSubsystem>, Subsystem)
+		SLATE_ARGUMENT(TWeakObjectPtr<APlayerController>, PlayerController)
+		SLATE_EVENT(FSimpleDelegate, OnClosed)
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& args);
+
+	TSharedPtr<SWidget> GetSearchBox() const;
+
+	// SWidget
+	virtual FReply OnKeyDown(const FGeometry& geometry, const FKeyEvent& keyEvent) override;
+	virtual bool SupportsKeyboardFocus() const override { return true; }
+
+private:
+	struct FResult
+	{
+		FText Name;
+		FVector Location = FVector::ZeroVector;
+	};
+
+	using FResultPtr = TSharedPtr<FResult>;
+
+	static constexpr int32 MaxResults = 20;
+
+	void OnQueryChanged(const FText& query);
+	void OnQueryCommitted(const FText& query, ETextCommit::Type commitType);
+	TSharedRef<ITableRow> MakeResultRow(FResultPtr result, const TSharedRef<STableViewBase>& owner) const;
+	void Pick(const FResultPtr& result);
+	FText GetDistanceText(const FVector& location) const;
+
+	TWeakObjectPtr<UFGModTrainStationMapSubsystem> Subsystem;
+	TWeakObjectPtr<APlayerController> PlayerController;
+	FSimpleDelegate OnClosed;
+
+	TSharedPtr<SSearchBox> SearchBox;
+	TSharedPtr<SListView<FResultPtr>> ResultList;
+	TArray<FResultPtr> Results;
+};
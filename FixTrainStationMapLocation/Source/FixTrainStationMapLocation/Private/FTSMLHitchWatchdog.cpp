@@ -0,0 +1,28 @@
+#include "FTSMLHitchWatchdog.h"
+
+#include "FixTrainStationMapLocation.h"
+#include "HAL/IConsoleManager.h"
+
+const TCHAR* const FFTSMLHitchWatchdogTraits::HookNames[] =
+{
+	TEXT("CreateAndAddNewRepresentation"),
+	TEXT("Representation manager BeginPlay"),
+	TEXT("UpdateRepresentationOfActor"),
+	TEXT("RemoveRepresentationOfActor"),
+};
+static_assert(UE_ARRAY_COUNT(FFTSMLHitchWatchdogTraits::HookNames) == static_cast<int32>(FFTSMLHitchWatchdogTraits::EHook::Count));
+
+void FFTSMLHitchWatchdogTraits::LogHitch(const FString& message)
+{
+	UE_LOG(LogFixTrainStationMapLocation, Warning, TEXT("%s"), *message);
+}
+
+namespace
+{
+
+FAutoConsoleCommandWithOutputDevice HitchReportCommand(
+	TEXT("FTSML.HitchReport"),
+	TEXT("Prints how long the last few frames took and which of our hooks ran in them, see FTSML.HitchBudgetMs."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateStatic(&FFTSMLHitchWatchdog::DumpRecentFrames));
+
+} // namespace
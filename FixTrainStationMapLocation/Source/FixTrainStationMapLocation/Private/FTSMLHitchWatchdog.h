@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ModHitchWatchdog.h"
+
+/// The hooks that FFTSMLHitchWatchdog times, and where it reports them.
+struct FFTSMLHitchWatchdogTraits
+{
+	enum class EHook : uint8
+	{
+		CreateAndAddNewRepresentation,
+		ManagerBeginPlay,
+		UpdateRepresentationOfActor,
+		RemoveRepresentationOfActor,
+		Count
+	};
+
+	static constexpr const TCHAR* BudgetVariableName = TEXT("FTSML.HitchBudgetMs");
+	/// Indexed by EHook.
+	static const TCHAR* const HookNames[];
+
+	static void LogHitch(const FString& message);
+};
+
+/// Logs the time spent in our representation manager hooks during any game thread frame that takes
+/// longer than FTSML.HitchBudgetMs. Representations arrive in bursts when a save loads or a client
+/// joins, which is exactly when a long frame is most likely to be blamed on the wrong thing.
+///
+/// Hooks are timed with an FScope on the game thread, and the times include the game's function when
+/// the hook calls it. The last few frames stay in a fixed ring for FTSML.HitchReport.
+using FFTSMLHitchWatchdog = TModHitchWatchdog<FFTSMLHitchWatchdogTraits>;
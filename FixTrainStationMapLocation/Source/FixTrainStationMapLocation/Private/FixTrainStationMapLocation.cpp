@@ -1,27 +1,246 @@
 #include "FixTrainStationMapLocation.h"
 
 #include "FGActorRepresentationManager.h"
+#include "FGModTrainStationLocationComponent.h"
+#include "FGModTrainStationMapSubsystem.h"
 #include "FGModTrainStationRepresentation.h"
 #include "FGTrainStationIdentifier.h"
+#include "FTSMLHitchWatchdog.h"
+#include "HAL/IConsoleManager.h"
+#include "ModMemoryTally.h"
 #include "Patching/NativeHookManager.h"
+#include "UObject/UObjectIterator.h"
+
+DEFINE_LOG_CATEGORY(LogFixTrainStationMapLocation)
+LLM_DEFINE_TAG(FixTrainStationMapLocation);
+
+namespace
+{
+
+TAutoConsoleVariable<bool> CVarPackedStationReplication(
+	TEXT("FTSML.PackedStationReplication"),
+	true,
+	TEXT("Replicate train station map locations as a single packed array instead of one representation per station. Only affects stations created after it's changed."));
+
+/// Whether the representation being created is for a train station and should use our representation.
+/// This is called for every representation that the game creates, so it needs to be cheap. IsA is a
+/// lookup in the class's base chain rather than a walk up the hierarchy, so it's one pointer compare
+/// on top of the representation class check.
+bool ShouldUseStationRepresentation(const AActor* realActor, TSubclassOf<UFGActorRepresentation> representationClass)
+{
+	if (representationClass != nullptr || realActor == nullptr)
+		return false;	// The representation has already been picked.
+
+	return realActor->IsA<AFGTrainStationIdentifier>();
+}
+
+/// Times the check in the CreateAndAddNewRepresentation hook for a burst of synthetic representations,
+/// against an empty check so that only the hook's own cost is left. The real actors are the class
+/// defaults of every loaded actor class, picked at random with a tenth of them being stations, so it
+/// doesn't need a populated save and works on a dedicated server with -ExecCmds.
+FAutoConsoleCommandWithArgs BenchmarkRepresentationHookCommand(
+	TEXT("FTSML.BenchmarkRepresentationHook"),
+	TEXT("Times the train station check for [Count=50000] synthetic representations."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& args)
+	{
+		const int32 count = args.Num() > 0 ? FCString::Atoi(*args[0]) : 50000;
+		if (count <= 0)
+			return;
+
+		TArray<const AActor*> otherActors;
+		for (TObjectIterator<UClass> it; it; ++it)
+		{
+			if (it->IsChildOf<AActor>() && !it->IsChildOf<AFGTrainStationIdentifier>() && !it->HasAnyClassFlags(CLASS_Abstract))
+			{
+				otherActors.Add(it->GetDefaultObject<AActor>());
+			}
+		}
+		const AActor* stationActor = GetDefault<AFGTrainStationIdentifier>();
+		if (otherActors.IsEmpty())
+			return;	// Nothing loaded yet.
+
+		// Shuffled rather than grouped by class, and some with the class already picked by the caller,
+		// like the other mods and the game's own representations.
+		struct FRepresentation
+		{
+			const AActor* RealActor;
+			TSubclassOf<UFGActorRepresentation> RepresentationClass;
+		};
+		FRandomStream random(count);
+		TArray<FRepresentation> representations;
+		representations.Reserve(count);
+		for (int32 index = 0; index < count; ++index)
+		{
+			const float roll = random.FRand();
+			representations.Add(
+			{
+				roll < 0.1f ? stationActor : otherActors[random.RandHelper(otherActors.Num())],
+				roll > 0.9f ? UFGActorRepresentation::StaticClass() : nullptr,
+			});
+		}
+
+		const auto time = [&](auto&& isStation)
+		{
+			int32 numStations = 0;
+			const double startTime = FPlatformTime::Seconds();
+			for (const FRepresentation& representation : representations)
+			{
+				numStations += isStation(representation) ? 1 : 0;
+			}
+			const double elapsed = FPlatformTime::Seconds() - startTime;
+			return TPair<double, int32>(elapsed, numStations);
+		};
+
+		const auto [hookTime, hookStations] = time([](const FRepresentation& representation)
+		{
+			return ShouldUseStationRepresentation(representation.RealActor, representation.RepresentationClass);
+		});
+		const double baselineTime = time([](const FRepresentation& representation)
+		{
+			// Touches the same memory, so what's left over is the class check itself.
+			return representation.RepresentationClass == nullptr && representation.RealActor->GetClass() == nullptr;
+		}).Key;
+
+		UE_LOG(LogFixTrainStationMapLocation, Display,
+			TEXT("%i representations (%i stations, %i actor classes): hook check %.3fms (%.1fns each), baseline %.3fms (%.1fns each)."),
+			count, hookStations, otherActors.Num() + 1,
+			hookTime * 1000.0, hookTime * 1e9 / count,
+			baselineTime * 1000.0, baselineTime * 1e9 / count);
+	}));
+
+FAutoConsoleCommandWithWorld FindStationCommand(
+	TEXT("FTSML.FindStation"),
+	TEXT("Opens or closes a search box for finding a train station by name."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* world)
+	{
+		UFGModTrainStationMapSubsystem* subsystem = UFGModTrainStationMapSubsystem::Get(world);
+		if (subsystem == nullptr)
+			return;	// Not in a game world.
+
+		subsystem->ToggleStationSearch(world->GetFirstPlayerController());
+	}));
+
+FAutoConsoleCommandWithWorldArgsAndOutputDevice MemoryReportCommand(
+	TEXT("FTSML.MemoryReport"),
+	TEXT("Prints the classes, objects and memory that the mod is keeping resident."),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+		[](const TArray<FString>& args, UWorld* world, FOutputDevice& ar)
+		{
+			FModMemoryTally nativeTally;
+			FModMemoryTally representationTally;
+
+			for (TObjectIterator<UObject> it; it; ++it)
+			{
+				const UObject* object = *it;
+				if (object->GetPackage()->GetName().StartsWith(TEXT("/Script/FixTrainStationMapLocation")))
+				{
+					nativeTally.Add(object);
+				}
+				else if (object->IsA<UFGModTrainStationRepresentation>())
+				{
+					// Includes the stand-ins for cached stations.
+					representationTally.Add(object);
+				}
+			}
+
+			ar.Log(TEXT("FixTrainStationMapLocation memory:"));
+			nativeTally.Print(ar, TEXT("Native classes"));
+			representationTally.Print(ar, TEXT("Station representations"));
+
+			if (const auto* locations = UFGModTrainStationLocationComponent::Get(AFGActorRepresentationManager::Get(world)))
+			{
+				FModMemoryTally::PrintEntries(ar, TEXT("Packed station locations"), locations->GetStationCount(), locations->GetAllocatedSize());
+			}
+
+			// Only on clients.
+			if (const UFGModTrainStationMapSubsystem* subsystem = UFGModTrainStationMapSubsystem::Get(world))
+			{
+				subsystem->DumpMemoryReport(ar);
+			}
+
+			FModMemoryTally::PrintLLMTag(ar, TEXT("FixTrainStationMapLocation"));
+		}));
+
+} // namespace
 
 void FFixTrainStationMapLocationModule::StartupModule()
 {
 #if !WITH_EDITOR
+	FFTSMLHitchWatchdog::Install();
+
 	SUBSCRIBE_METHOD(AFGActorRepresentationManager::CreateAndAddNewRepresentation,
 		[](auto& scope, AFGActorRepresentationManager* manager, AActor* realActor, bool isLocal, TSubclassOf<UFGActorRepresentation> representationClass)
 		{
+			const FFTSMLHitchWatchdog::FScope watchdogScope(FFTSMLHitchWatchdog::EHook::CreateAndAddNewRepresentation);
+
 			// Use our custom representation for train stations.
-			if (realActor != nullptr && representationClass == nullptr && realActor->IsA<AFGTrainStationIdentifier>())
+			if (ShouldUseStationRepresentation(realActor, representationClass))
 			{
+				LLM_SCOPE_BYTAG(FixTrainStationMapLocation);
+				if (!isLocal && CVarPackedStationReplication.GetValueOnGameThread())
+				{
+					if (auto* locations = UFGModTrainStationLocationComponent::FindOrCreate(manager))
+					{
+						// Keep the representation on the server, the clients will create their own from
+						// the packed locations.
+						const bool result = scope(manager, realActor, true, UFGModTrainStationRepresentation::StaticClass());
+						if (result)
+						{
+							locations->AddStation(static_cast<AFGTrainStationIdentifier*>(realActor));
+						}
+						return;
+					}
+				}
+
 				scope(manager, realActor, isLocal, UFGModTrainStationRepresentation::StaticClass());
 			}
 		});
+
+	SUBSCRIBE_UOBJECT_METHOD_AFTER(AFGActorRepresentationManager, BeginPlay,
+		[](AFGActorRepresentationManager* manager)
+		{
+			const FFTSMLHitchWatchdog::FScope watchdogScope(FFTSMLHitchWatchdog::EHook::ManagerBeginPlay);
+
+			if (auto* map = UFGModTrainStationMapSubsystem::Get(manager))
+			{
+				map->BindToManager(manager);
+			}
+		});
+
+	SUBSCRIBE_METHOD(AFGActorRepresentationManager::UpdateRepresentationOfActor,
+		[](auto& scope, AFGActorRepresentationManager* manager, AActor* realActor)
+		{
+			const FFTSMLHitchWatchdog::FScope watchdogScope(FFTSMLHitchWatchdog::EHook::UpdateRepresentationOfActor);
+
+			if (realActor == nullptr || !manager->HasAuthority() || !realActor->IsA<AFGTrainStationIdentifier>())
+				return;	// Not one of the packed stations.
+
+			// Renamed, send the new name to the clients.
+			if (auto* locations = UFGModTrainStationLocationComponent::Get(manager); locations && locations->FindStation(static_cast<AFGTrainStationIdentifier*>(realActor)))
+			{
+				locations->AddStation(static_cast<AFGTrainStationIdentifier*>(realActor));
+			}
+		});
+
+	SUBSCRIBE_METHOD(AFGActorRepresentationManager::RemoveRepresentationOfActor,
+		[](auto& scope, AFGActorRepresentationManager* manager, AActor* realActor)
+		{
+			const FFTSMLHitchWatchdog::FScope watchdogScope(FFTSMLHitchWatchdog::EHook::RemoveRepresentationOfActor);
+
+			if (realActor == nullptr || !manager->HasAuthority() || !realActor->IsA<AFGTrainStationIdentifier>())
+				return;	// Not one of the packed stations.
+
+			if (auto* locations = UFGModTrainStationLocationComponent::Get(manager))
+			{
+				locations->RemoveStation(static_cast<AFGTrainStationIdentifier*>(realActor));
+			}
+		});
 #endif
 }
 
 void FFixTrainStationMapLocationModule::ShutdownModule()
 {
+	FFTSMLHitchWatchdog::Uninstall();
 }
 
 IMPLEMENT_MODULE(FFixTrainStationMapLocationModule, FixTrainStationMapLocation)
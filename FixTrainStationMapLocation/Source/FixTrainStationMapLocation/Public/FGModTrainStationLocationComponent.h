@@ -0,0 +1,105 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/NetSerialization.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "FGModTrainStationLocationComponent.generated.h"
+
+class AFGActorRepresentationManager;
+class AFGTrainStationIdentifier;
+struct FFGModPackedTrainStationArray;
+class UFGModTrainStationLocationComponent;
+
+/// Map location and name of a single train station.
+USTRUCT()
+struct FFGModPackedTrainStation : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/// The station identifier doubles as the station's ID; it's always replicated to every client.
+	UPROPERTY()
+	AFGTrainStationIdentifier* Station = nullptr;
+
+	UPROPERTY()
+	FVector_NetQuantize Location;
+
+	UPROPERTY()
+	FString Name;
+
+	/// Whether the client has created a representation for this station yet.
+	bool HasClientRepresentation = false;
+
+	void PreReplicatedRemove(const FFGModPackedTrainStationArray& serializer);
+	void PostReplicatedAdd(const FFGModPackedTrainStationArray& serializer);
+	void PostReplicatedChange(const FFGModPackedTrainStationArray& serializer);
+};
+
+USTRUCT()
+struct FFGModPackedTrainStationArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FFGModPackedTrainStation> Items;
+
+	UPROPERTY(NotReplicated)
+	UFGModTrainStationLocationComponent* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& deltaParams)
+	{
+		return FastArrayDeltaSerialize<FFGModPackedTrainStation, FFGModPackedTrainStationArray>(Items, deltaParams, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FFGModPackedTrainStationArray> : public TStructOpsTypeTraitsBase2<FFGModPackedTrainStationArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/// Replicates the locations of all train stations as a single packed array.
+///
+/// By default every train station has its own replicated representation, which adds up to a lot of
+/// replicated objects on servers with lots of stations. When this component is present, the server
+/// keeps the station representations local and only sends the station locations, then each client
+/// creates its own local representations from those.
+UCLASS()
+class FIXTRAINSTATIONMAPLOCATION_API UFGModTrainStationLocationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFGModTrainStationLocationComponent();
+
+	static UFGModTrainStationLocationComponent* Get(const AFGActorRepresentationManager* manager);
+	static UFGModTrainStationLocationComponent* FindOrCreate(AFGActorRepresentationManager* manager);
+
+	// UActorComponent
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/// Server only. Adding a station that's already been added updates it instead.
+	void AddStation(AFGTrainStationIdentifier* station);
+	void RemoveStation(AFGTrainStationIdentifier* station);
+
+	/// Gets the packed data for the station, if we have any.
+	const FFGModPackedTrainStation* FindStation(const AFGTrainStationIdentifier* station) const;
+
+	int32 GetStationCount() const { return mStations.Items.Num(); }
+	/// The memory used by the packed stations, including their names.
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	friend FFGModPackedTrainStation;
+
+	AFGActorRepresentationManager* GetManager() const;
+	void CreateClientRepresentation(FFGModPackedTrainStation& item);
+	void UpdateClientRepresentation(FFGModPackedTrainStation& item);
+	void RemoveClientRepresentation(FFGModPackedTrainStation& item);
+
+	UPROPERTY(Replicated)
+	FFGModPackedTrainStationArray mStations;
+};
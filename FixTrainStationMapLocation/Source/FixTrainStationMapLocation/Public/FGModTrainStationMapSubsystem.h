@@ -0,0 +1,167 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FGModTrainStationMapSubsystem.generated.h"
+
+class AFGActorRepresentationManager;
+class APlayerController;
+class SFGModTrainStationSearch;
+class UFGActorRepresentation;
+
+/// A group of train stations that are close enough together to share a single icon on the map.
+USTRUCT(BlueprintType)
+struct FFGModTrainStationCluster
+{
+	GENERATED_BODY()
+
+	/// Average location of the stations in the cluster.
+	UPROPERTY(BlueprintReadOnly, Category = "Map")
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Map")
+	int32 NumStations = 0;
+
+	/// The station's representation, if the cluster only contains one station.
+	UPROPERTY(BlueprintReadOnly, Category = "Map")
+	UFGActorRepresentation* Station = nullptr;
+};
+
+/// Keeps track of the train stations on the client so that the map can draw and search them efficiently.
+///
+/// The stations are kept in a grid pyramid: each level is a sparse grid with cells twice the size of
+/// the level below it, and each cell knows how many stations it contains and where their centre is.
+/// Picking the level whose cells are about the size of an icon gives one cluster per icon-sized area
+/// without having to look at any of the individual stations. Stations are added to and removed from it
+/// one at a time as their representations come and go, so it's never rebuilt.
+///
+/// The station names are indexed both sorted for prefix searches and by trigram for searching
+/// anywhere in the name. Stations tend to arrive hundreds at a time when joining, so the sorted list
+/// is only sorted when it's next searched rather than kept in order as each one arrives. The search
+/// box that uses the index is SFGModTrainStationSearch.
+///
+/// Clients also remember the stations on disk when they leave (see FFGModTrainStationMapCache), and
+/// show them straight away the next time that they join until the real ones have replicated. These
+/// stand-in representations have no real actor, and are added to the representation manager as local
+/// representations so that the map picks them up. Each is swapped for the real station when it
+/// arrives, and any that are left once the stations stop arriving are assumed to have been dismantled.
+UCLASS()
+class FIXTRAINSTATIONMAPLOCATION_API UFGModTrainStationMapSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UFGModTrainStationMapSubsystem* Get(const UObject* worldContext);
+
+	// UWorldSubsystem
+	virtual bool ShouldCreateSubsystem(UObject* outer) const override;
+	virtual void Deinitialize() override;
+
+	/// Starts tracking the stations from the representation manager.
+	void BindToManager(AFGActorRepresentationManager* manager);
+
+	/// Gets the clusters that overlap the visible part of the map, merging any stations that are closer
+	/// together than iconSpacing (in world units). Stations outside of the visible area are culled.
+	UFUNCTION(BlueprintCallable, Category = "Map")
+	void GetStationClusters(const FBox2D& visibleBounds, float iconSpacing, TArray<FFGModTrainStationCluster>& out_clusters) const;
+
+	/// Finds the stations with names that contain the query, ignoring case. Stations with names that
+	/// start with the query come first, in alphabetical order.
+	UFUNCTION(BlueprintCallable, Category = "Map")
+	void SearchStations(const FString& query, int32 maxResults, TArray<UFGActorRepresentation*>& out_stations) const;
+
+	/// Opens the station search box for the player, or closes it if it's already open.
+	void ToggleStationSearch(APlayerController* playerController);
+	void CloseStationSearch();
+
+	/// Prints the memory used by the search index and the cached stations, for FTSML.MemoryReport.
+	void DumpMemoryReport(FOutputDevice& ar) const;
+
+private:
+	struct FCell
+	{
+		FVector SumLocation = FVector::ZeroVector;
+		TArray<TWeakObjectPtr<UFGActorRepresentation>, TInlineAllocator<1>> Stations;
+	};
+
+	using FLevel = TMap<FIntPoint, FCell>;
+
+	struct FNamedStation
+	{
+		FString Name;
+		TWeakObjectPtr<UFGActorRepresentation> Station;
+	};
+
+	/// Size of the cells in the lowest level of the pyramid, and how many levels there are. The top
+	/// level is bigger than the whole map.
+	static constexpr double BaseCellSize = 5000.0;
+	static constexpr int32 NumLevels = 9;
+
+	/// How long to wait for more stations to arrive before removing the cached stations that haven't
+	/// been matched, in seconds, and how long to wait if none arrive at all.
+	static constexpr float StaleCachedStationDelay = 5.0f;
+	static constexpr float FirstStationDelay = 30.0f;
+
+	/// How far a real station can be from a cached one and still be matched with it. This can't be more
+	/// than the metre that station IDs are rounded to, so that a match is always in a neighbouring ID.
+	static constexpr double CachedStationTolerance = 100.0;
+
+	UFUNCTION()
+	void OnRepresentationAdded(UFGActorRepresentation* representation);
+	UFUNCTION()
+	void OnRepresentationUpdated(UFGActorRepresentation* representation);
+	UFUNCTION()
+	void OnRepresentationRemoved(UFGActorRepresentation* representation);
+
+	void AddStation(UFGActorRepresentation* representation);
+	void RemoveStation(UFGActorRepresentation* representation);
+	void AddStationName(UFGActorRepresentation* representation);
+	void RemoveStationName(UFGActorRepresentation* representation);
+
+	void LoadCachedStations();
+	void SaveCachedStations() const;
+	/// Replaces the cached station in the same place as the real one, if there is one.
+	void ReconcileCachedStation(UFGActorRepresentation* representation);
+	/// Returns the nearest cached station within CachedStationTolerance of the location, which can have
+	/// any of the IDs next to the location's own if it's near the edge of a metre.
+	UFGActorRepresentation* FindCachedStation(const FVector& location, FIntVector& out_id) const;
+	void RemoveStaleCachedStations();
+	void RemoveCachedStation(UFGActorRepresentation* representation);
+
+	void SortNames() const;
+
+	static bool IsStation(const UFGActorRepresentation* representation);
+	static FIntPoint GetCell(const FVector& location, int32 level);
+	static FString NormalizeName(const FString& name);
+	static uint64 GetTrigram(const FString& name, int32 index);
+
+	TWeakObjectPtr<AFGActorRepresentationManager> mManager;
+
+	/// Identifies the server and session in the station cache, or empty if the cache isn't in use.
+	FString mCacheKey;
+
+	/// The stand-ins for cached stations that haven't been matched up with a real station yet, by
+	/// station ID.
+	UPROPERTY()
+	TMap<FIntVector, UFGActorRepresentation*> mCachedStations;
+
+	FTimerHandle mStaleCachedStationsTimer;
+
+	/// Where each station was when it was added, so that it can be found again when it's removed.
+	TMap<TWeakObjectPtr<UFGActorRepresentation>, FVector> mStationLocations;
+
+	FLevel mLevels[NumLevels];
+
+	/// The normalized name of each station when it was added.
+	TMap<TWeakObjectPtr<UFGActorRepresentation>, FString> mStationNames;
+
+	/// Normalized names of all of the stations, sorted whenever mAreNamesSorted is set.
+	mutable TArray<FNamedStation> mSortedNames;
+	mutable bool mAreNamesSorted = true;
+
+	/// The stations with each trigram in their normalized name, once for every time that it appears.
+	TMap<uint64, TArray<TWeakObjectPtr<UFGActorRepresentation>>> mTrigrams;
+
+	TSharedPtr<SFGModTrainStationSearch> mStationSearch;
+	TWeakObjectPtr<APlayerController> mStationSearchPlayer;
+};
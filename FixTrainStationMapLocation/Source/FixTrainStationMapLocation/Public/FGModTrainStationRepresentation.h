@@ -11,4 +11,12 @@ class FIXTRAINSTATIONMAPLOCATION_API UFGModTrainStationRepresentation : public U
 
 public:
 	UFGModTrainStationRepresentation();
+
+	// UFGActorRepresentation
+	virtual void SetupActorRepresentation(AActor* realActor, bool isLocal, float lifeSpan = 0.0f) override;
+
+	/// Sets up a stand-in for a station that the client remembers from last time, which has no real
+	/// actor. UFGModTrainStationMapSubsystem adds it to the representation manager as a local
+	/// representation so that the map shows it.
+	void SetupCachedStation(const FVector& location, const FString& name, UTexture2D* texture, const FLinearColor& color);
 };
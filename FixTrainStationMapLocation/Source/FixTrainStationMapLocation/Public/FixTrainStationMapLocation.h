@@ -1,8 +1,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
 #include "Modules/ModuleManager.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogFixTrainStationMapLocation, Log, All)
+LLM_DECLARE_TAG_API(FixTrainStationMapLocation, FIXTRAINSTATIONMAPLOCATION_API);
+
 class FFixTrainStationMapLocationModule : public IModuleInterface
 {
 public:
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""Runs a dedicated server benchmark once for each set of mods, and collects the results.
+
+Each mod set is a label and the mods that are enabled for it, in a JSON file such as
+
+    {
+        "baseline": [],
+        "vlqol": ["VerticalLogisticsQoL"],
+        "all": ["VerticalLogisticsQoL", "PowerPolesOnBuildings", "FixTrainStationMapLocation", "BigLifts"]
+    }
+
+For every run, each mod that's named in any of the sets but isn't in the current one is moved out of
+the server's Mods folder. The server is then started with -nullrhi -ModBenchmark -ModBenchmarkQuit,
+so ModBenchmarks and SML have to be installed on the server as well. All of the mods are put back
+once every set has been run, even if something fails.
+
+    run_benchmarks.py --server ~/SatisfactoryDedicatedServer --sets sets.json --runs 3
+
+The JSON files that the runs write are kept in the output folder, and summary.json there has the
+median of each run's means for every label, along with the mods that were enabled.
+"""
+
+import argparse
+import json
+import shutil
+import statistics
+import subprocess
+import sys
+from pathlib import Path
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--server", type=Path, required=True, help="dedicated server install folder")
+    parser.add_argument("--sets", type=Path, required=True, help="JSON file of mod sets, see above")
+    parser.add_argument("--runs", type=int, default=3, help="runs per mod set")
+    parser.add_argument("--output", type=Path, default=Path("benchmark-results"), help="folder for the results")
+    parser.add_argument("--frames", type=int, default=1800, help="frames to measure in each run")
+    parser.add_argument("--warmup-frames", type=int, default=300, help="frames to skip before measuring")
+    parser.add_argument("--timeout", type=float, default=3600.0, help="seconds before a run is given up on")
+    parser.add_argument("server_args", nargs="*", help="extra arguments for the server, after --")
+    return parser.parse_args()
+
+
+def get_server_executable(server):
+    for name in ("FactoryServer.sh", "FactoryServer.exe"):
+        if (server / name).exists():
+            return server / name
+    sys.exit(f"Couldn't find FactoryServer.sh or FactoryServer.exe in {server}.")
+
+
+def set_enabled_mods(mods_dir, disabled_dir, all_mods, enabled_mods):
+    """Moves the mods in and out of the Mods folder, so that only the enabled ones are loaded."""
+    disabled_dir.mkdir(exist_ok=True)
+    for mod in all_mods:
+        enabled_path = mods_dir / mod
+        disabled_path = disabled_dir / mod
+        if mod in enabled_mods and disabled_path.exists():
+            shutil.move(str(disabled_path), str(enabled_path))
+        elif mod not in enabled_mods and enabled_path.exists():
+            shutil.move(str(enabled_path), str(disabled_path))
+
+    missing = [mod for mod in enabled_mods if not (mods_dir / mod).exists()]
+    if missing:
+        sys.exit(f"Mods not installed on the server: {', '.join(missing)}")
+
+
+def run_server(args, executable, label, output_path):
+    command = [
+        str(executable),
+        "-nullrhi",
+        "-ModBenchmark",
+        "-ModBenchmarkQuit",
+        f"-ModBenchmarkLabel={label}",
+        f"-ModBenchmarkOutput={output_path.resolve()}",
+        f"-ModBenchmarkFrames={args.frames}",
+        f"-ModBenchmarkWarmupFrames={args.warmup_frames}",
+        *args.server_args,
+    ]
+    print(f"Running {label}: {' '.join(command)}", flush=True)
+    try:
+        subprocess.run(command, cwd=args.server, timeout=args.timeout, check=False)
+    except subprocess.TimeoutExpired:
+        print(f"{label} timed out after {args.timeout:.0f}s.", file=sys.stderr)
+        return None
+
+    if not output_path.exists():
+        print(f"{label} didn't write any results.", file=sys.stderr)
+        return None
+
+    with output_path.open() as file:
+        return json.load(file)
+
+
+def summarize(results):
+    """The median of each timing's mean, since a single run can be thrown off by the machine."""
+    def median_of(get):
+        values = [get(result) for result in results]
+        return statistics.median(values) if values else None
+
+    return {
+        "Runs": len(results),
+        "Mods": results[0]["Mods"] if results else [],
+        "LoadSeconds": median_of(lambda result: result["LoadSeconds"]),
+        "PostInitializationSeconds": median_of(lambda result: result["PostInitializationSeconds"]),
+        "FrameMsMean": median_of(lambda result: result["FrameMs"]["Mean"]),
+        "WorldTickMsMean": median_of(lambda result: result["WorldTickMs"]["Mean"]),
+        "WorldTickMsP99": median_of(lambda result: result["WorldTickMs"]["P99"]),
+        "PeakMB": median_of(lambda result: result["Memory"]["PeakMB"]),
+    }
+
+
+def main():
+    args = parse_args()
+    args.server = args.server.resolve()
+    executable = get_server_executable(args.server)
+    mods_dir = args.server / "FactoryGame" / "Mods"
+    disabled_dir = args.server / "FactoryGame" / "Mods.disabled"
+
+    with args.sets.open() as file:
+        mod_sets = json.load(file)
+    all_mods = sorted({mod for mods in mod_sets.values() for mod in mods})
+
+    args.output.mkdir(parents=True, exist_ok=True)
+    summary = {}
+
+    try:
+        for label, enabled_mods in mod_sets.items():
+            set_enabled_mods(mods_dir, disabled_dir, all_mods, set(enabled_mods))
+
+            results = []
+            for run in range(args.runs):
+                run_label = f"{label}-{run + 1}"
+                result = run_server(args, executable, run_label, args.output / f"{run_label}.json")
+                if result is not None:
+                    results.append(result)
+
+            summary[label] = summarize(results)
+            print(f"{label}: {json.dumps(summary[label])}", flush=True)
+    finally:
+        # Leave the server with everything enabled, the way that it was found.
+        set_enabled_mods(mods_dir, disabled_dir, all_mods, set(all_mods))
+
+    with (args.output / "summary.json").open("w") as file:
+        json.dump(summary, file, indent=4)
+    print(f"Wrote {args.output / 'summary.json'}.")
+
+
+if __name__ == "__main__":
+    main()
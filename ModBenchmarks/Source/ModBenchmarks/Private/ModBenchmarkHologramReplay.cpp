@@ -0,0 +1,495 @@
+#include "ModBenchmarkHologramReplay.h"
+
+#include "Dom/JsonObject.h"
+#include "Equipment/FGBuildGun.h"
+#include "Equipment/FGBuildGunBuild.h"
+#include "FGCharacterPlayer.h"
+#include "FGRecipe.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Hologram/FGConveyorLiftHologram.h"
+#include "Hologram/FGHologram.h"
+#include "Hologram/FGHologramBuildModeDescriptor.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ModBenchmarks.h"
+#include "Patching/NativeHookManager.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+TWeakObjectPtr<UWorld> FModBenchmarkHologramReplay::RecordingWorld;
+FString FModBenchmarkHologramReplay::RecordingPath;
+TArray<FModBenchmarkHologramReplay::FSegment> FModBenchmarkHologramReplay::RecordedSegments;
+FTSTicker::FDelegateHandle FModBenchmarkHologramReplay::TickerHandle;
+FModBenchmarkHologramReplay::FTimings* FModBenchmarkHologramReplay::ActiveTimings = nullptr;
+
+namespace
+{
+
+FString GetRecordingPath(const TArray<FString>& args, const TCHAR* prefix)
+{
+	FString fileName;
+	for (const FString& arg : args)
+	{
+		FParse::Value(*arg, TEXT("File="), fileName);
+	}
+	if (fileName.IsEmpty())
+	{
+		fileName = FString::Printf(TEXT("%s-%s"), prefix, *FDateTime::Now().ToString());
+	}
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("ModBenchmarks"), fileName + TEXT(".json"));
+}
+
+FAutoConsoleCommandWithWorldAndArgs RecordHologramCommand(
+	TEXT("ModBenchmark.RecordHologram"),
+	TEXT("Starts recording the local player's build gun input to File=Name, or stops and saves it if given Stop."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& args, UWorld* world)
+	{
+		if (args.Contains(TEXT("Stop")))
+		{
+			FModBenchmarkHologramReplay::StopRecording();
+		}
+		else
+		{
+			FModBenchmarkHologramReplay::StartRecording(world, GetRecordingPath(args, TEXT("Hologram")));
+		}
+	}));
+
+FAutoConsoleCommandWithWorldAndArgs ReplayHologramCommand(
+	TEXT("ModBenchmark.ReplayHologram"),
+	TEXT("Replays a hologram recording and writes the timings next to it. Arguments: File=Name [Iterations=N]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& args, UWorld* world)
+	{
+		int32 iterations = 1;
+		for (const FString& arg : args)
+		{
+			FParse::Value(*arg, TEXT("Iterations="), iterations);
+		}
+		FModBenchmarkHologramReplay::Replay(world, GetRecordingPath(args, TEXT("Hologram")), FMath::Max(iterations, 1));
+	}));
+
+TArray<TSharedPtr<FJsonValue>> SaveVector(const FVector& vector)
+{
+	return
+	{
+		MakeShared<FJsonValueNumber>(vector.X),
+		MakeShared<FJsonValueNumber>(vector.Y),
+		MakeShared<FJsonValueNumber>(vector.Z),
+	};
+}
+
+FVector LoadVector(const FJsonObject& object, const TCHAR* field)
+{
+	const TArray<TSharedPtr<FJsonValue>>* values;
+	if (!object.TryGetArrayField(field, values) || values->Num() != 3)
+		return FVector::ZeroVector;
+	return FVector((*values)[0]->AsNumber(), (*values)[1]->AsNumber(), (*values)[2]->AsNumber());
+}
+
+TSharedRef<FJsonObject> MakeTimingObject(TArray<float> values)
+{
+	values.Sort();
+
+	auto getPercentile = [&](double percentile)
+	{
+		const int32 index = FMath::Clamp(FMath::CeilToInt32(percentile / 100.0 * values.Num()) - 1, 0, values.Num() - 1);
+		return values.IsEmpty() ? 0.0f : values[index];
+	};
+
+	double sum = 0.0;
+	for (const float value : values)
+	{
+		sum += value;
+	}
+
+	auto object = MakeShared<FJsonObject>();
+	object->SetNumberField(TEXT("Calls"), values.Num());
+	object->SetNumberField(TEXT("MeanMs"), values.IsEmpty() ? 0.0 : sum / values.Num());
+	object->SetNumberField(TEXT("P50Ms"), getPercentile(50.0));
+	object->SetNumberField(TEXT("P99Ms"), getPercentile(99.0));
+	object->SetNumberField(TEXT("MaxMs"), values.IsEmpty() ? 0.0f : values.Last());
+	return object;
+}
+
+/// Runs the function, adding the time that it took in milliseconds to the timings.
+template<class TFunction>
+auto TimeCall(TArray<float>& timings, TFunction&& function)
+{
+	const uint64 startCycles = FPlatformTime::Cycles64();
+	ON_SCOPE_EXIT
+	{
+		timings.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles));
+	};
+	return function();
+}
+
+} // namespace
+
+void FModBenchmarkHologramReplay::StartRecording(UWorld* world, const FString& path)
+{
+	if (TickerHandle.IsValid())
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Already recording to %s."), *RecordingPath);
+		return;
+	}
+
+	InstallRecordingHooks();
+
+	RecordingWorld = world;
+	RecordingPath = path;
+	RecordedSegments.Reset();
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&FModBenchmarkHologramReplay::Tick));
+
+	UE_LOG(LogModBenchmarks, Display, TEXT("Recording build gun input to %s."), *RecordingPath);
+}
+
+void FModBenchmarkHologramReplay::StopRecording()
+{
+	if (!TickerHandle.IsValid())
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Nothing is being recorded."));
+		return;
+	}
+
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	TickerHandle.Reset();
+
+	TArray<TSharedPtr<FJsonValue>> segments;
+	int32 frameCount = 0;
+	for (const FSegment& segment : RecordedSegments)
+	{
+		TArray<TSharedPtr<FJsonValue>> frames;
+		for (const FFrame& frame : segment.Frames)
+		{
+			frames.Add(MakeShared<FJsonValueObject>(SaveFrame(frame)));
+		}
+		frameCount += frames.Num();
+
+		auto segmentObject = MakeShared<FJsonObject>();
+		segmentObject->SetStringField(TEXT("Recipe"), GetPathNameSafe(segment.Recipe));
+		segmentObject->SetArrayField(TEXT("Frames"), MoveTemp(frames));
+		segments.Add(MakeShared<FJsonValueObject>(MoveTemp(segmentObject)));
+	}
+
+	auto root = MakeShared<FJsonObject>();
+	root->SetStringField(TEXT("Map"), RecordingWorld.IsValid() ? RecordingWorld->GetMapName() : FString());
+	root->SetArrayField(TEXT("Segments"), MoveTemp(segments));
+
+	FString json;
+	FJsonSerializer::Serialize(root, TJsonWriterFactory<>::Create(&json));
+
+	if (FFileHelper::SaveStringToFile(json, *RecordingPath))
+	{
+		UE_LOG(LogModBenchmarks, Display, TEXT("Wrote %i holograms and %i frames to %s."), RecordedSegments.Num(), frameCount, *RecordingPath);
+	}
+	else
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Failed to write %s."), *RecordingPath);
+	}
+
+	RecordedSegments.Empty();
+}
+
+bool FModBenchmarkHologramReplay::Tick(float deltaTime)
+{
+	FHitResult hitResult;
+	const AFGHologram* hologram = GetBuildGunHologram(RecordingWorld.Get(), &hitResult);
+	if (hologram == nullptr)
+		return true;	// Not building anything right now.
+
+	// A new segment starts whenever the recipe changes, so that the replay spawns a new hologram at the
+	// same point.
+	if (RecordedSegments.IsEmpty() || RecordedSegments.Last().Recipe != hologram->GetRecipe())
+	{
+		RecordedSegments.AddDefaulted_GetRef().Recipe = hologram->GetRecipe();
+	}
+
+	RecordedSegments.Last().Frames.Add(
+	{
+		.HitResult = hitResult,
+		.BuildMode = hologram->GetCurrentBuildMode(),
+		.ScrollValue = hologram->GetScrollRotateValue(),
+	});
+	return true;
+}
+
+void FModBenchmarkHologramReplay::InstallRecordingHooks()
+{
+	static bool isInstalled = false;
+	if (isInstalled)
+		return;
+	isInstalled = true;
+
+	// The build gun passes these on to the hologram's DoMultiStepPlacement, which is where each step of
+	// the placement happens. They do nothing unless a recording is running.
+	SUBSCRIBE_UOBJECT_METHOD(UFGBuildGunStateBuild, PrimaryFire_Implementation,
+		[](auto& scope, UFGBuildGunStateBuild* state)
+		{
+			if (UNLIKELY(TickerHandle.IsValid()))
+			{
+				RecordFire(false);
+			}
+		});
+
+	SUBSCRIBE_UOBJECT_METHOD(UFGBuildGunStateBuild, PrimaryFireRelease_Implementation,
+		[](auto& scope, UFGBuildGunStateBuild* state)
+		{
+			if (UNLIKELY(TickerHandle.IsValid()))
+			{
+				RecordFire(true);
+			}
+		});
+}
+
+void FModBenchmarkHologramReplay::RecordFire(bool isRelease)
+{
+	// Goes on the frame that was last recorded, which is where the hologram was when the button went.
+	if (RecordedSegments.IsEmpty() || RecordedSegments.Last().Frames.IsEmpty())
+		return;	// Not building anything yet.
+
+	FFrame& frame = RecordedSegments.Last().Frames.Last();
+	(isRelease ? frame.Released : frame.Pressed) = true;
+}
+
+AFGHologram* FModBenchmarkHologramReplay::GetBuildGunHologram(UWorld* world, FHitResult* out_hitResult)
+{
+	const APlayerController* controller = world ? world->GetFirstPlayerController() : nullptr;
+	const auto* character = controller ? Cast<AFGCharacterPlayer>(controller->GetPawn()) : nullptr;
+	const AFGBuildGun* buildGun = character ? character->GetBuildGun() : nullptr;
+	if (buildGun == nullptr || buildGun->mBuildState == nullptr)
+		return nullptr;
+
+	if (out_hitResult != nullptr)
+	{
+		*out_hitResult = buildGun->mHitResult;
+	}
+	return buildGun->mBuildState->mHologram;
+}
+
+void FModBenchmarkHologramReplay::InstallTimingHooks()
+{
+	static bool isInstalled = false;
+	if (isInstalled)
+		return;
+	isInstalled = true;
+
+	// UpdateTopTransform is only called from inside the lift hologram, so it can only be timed by hooking
+	// it. The hook does nothing unless a replay is running.
+	SUBSCRIBE_UOBJECT_METHOD(AFGConveyorLiftHologram, UpdateTopTransform,
+		[](auto& scope, AFGConveyorLiftHologram* hologram, auto&&... args)
+		{
+			if (LIKELY(ActiveTimings == nullptr))
+				return;
+
+			TimeCall(ActiveTimings->UpdateTopTransform, [&] { scope(hologram, args...); });
+		});
+}
+
+void FModBenchmarkHologramReplay::Replay(UWorld* world, const FString& path, int32 iterations)
+{
+	FString json;
+	TSharedPtr<FJsonObject> root;
+	if (!FFileHelper::LoadFileToString(json, *path) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(json), root))
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Failed to read %s."), *path);
+		return;
+	}
+
+	if (world == nullptr || GetBuildGunHologram(world) != nullptr || world->GetFirstPlayerController() == nullptr)
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Replaying needs a local player with the build gun put away."));
+		return;
+	}
+
+	TArray<FSegment> segments;
+	for (const TSharedPtr<FJsonValue>& segmentValue : root->GetArrayField(TEXT("Segments")))
+	{
+		const FJsonObject& segmentObject = *segmentValue->AsObject();
+
+		FSegment& segment = segments.AddDefaulted_GetRef();
+		segment.Recipe = LoadClass<UFGRecipe>(nullptr, *segmentObject.GetStringField(TEXT("Recipe")));
+		for (const TSharedPtr<FJsonValue>& frameValue : segmentObject.GetArrayField(TEXT("Frames")))
+		{
+			if (!LoadFrame(*frameValue->AsObject(), segment.Frames.AddDefaulted_GetRef()))
+			{
+				UE_LOG(LogModBenchmarks, Warning, TEXT("%s refers to actors that don't exist, is this the right save?"), *path);
+			}
+		}
+	}
+
+	InstallTimingHooks();
+
+	FTimings timings;
+	ActiveTimings = &timings;
+	for (int32 iteration = 0; iteration < iterations; ++iteration)
+	{
+		for (const FSegment& segment : segments)
+		{
+			ReplaySegment(world, segment);
+		}
+	}
+	ActiveTimings = nullptr;
+
+	auto results = MakeShared<FJsonObject>();
+	results->SetStringField(TEXT("Recording"), path);
+	results->SetNumberField(TEXT("Iterations"), iterations);
+	results->SetObjectField(TEXT("TrySnapToActor"), MakeTimingObject(timings.TrySnapToActor));
+	results->SetObjectField(TEXT("SetHologramLocationAndRotation"), MakeTimingObject(timings.SetHologramLocationAndRotation));
+	results->SetObjectField(TEXT("PostHologramPlacement"), MakeTimingObject(timings.PostHologramPlacement));
+	results->SetObjectField(TEXT("OnBuildModeChanged"), MakeTimingObject(timings.OnBuildModeChanged));
+	results->SetObjectField(TEXT("DoMultiStepPlacement"), MakeTimingObject(timings.DoMultiStepPlacement));
+	results->SetObjectField(TEXT("UpdateTopTransform"), MakeTimingObject(timings.UpdateTopTransform));
+
+	FString resultsJson;
+	FJsonSerializer::Serialize(results, TJsonWriterFactory<>::Create(&resultsJson));
+
+	const FString resultsPath = FPaths::Combine(FPaths::GetPath(path), FPaths::GetBaseFilename(path) + TEXT("-Replay.json"));
+	if (FFileHelper::SaveStringToFile(resultsJson, *resultsPath))
+	{
+		UE_LOG(LogModBenchmarks, Display, TEXT("Wrote hologram replay timings to %s."), *resultsPath);
+	}
+	else
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Failed to write %s."), *resultsPath);
+	}
+}
+
+void FModBenchmarkHologramReplay::ReplaySegment(UWorld* world, const FSegment& segment)
+{
+	if (segment.Recipe == nullptr || segment.Frames.IsEmpty())
+		return;
+
+	const APlayerController* controller = world->GetFirstPlayerController();
+	auto* character = Cast<AFGCharacterPlayer>(controller->GetPawn());
+	AFGBuildGun* buildGun = character ? character->GetBuildGun() : nullptr;
+
+	const auto spawnHologram = [&](const FFrame& frame)
+	{
+		AFGHologram* hologram = AFGHologram::SpawnHologramFromRecipe(segment.Recipe, buildGun, frame.HitResult.Location, character);
+		if (hologram == nullptr)
+		{
+			UE_LOG(LogModBenchmarks, Warning, TEXT("Failed to spawn a hologram for %s."), *GetNameSafe(segment.Recipe));
+		}
+		return hologram;
+	};
+
+	AFGHologram* hologram = spawnHologram(segment.Frames[0]);
+	if (hologram == nullptr)
+		return;
+
+	FTimings& timings = *ActiveTimings;
+
+	// Same order of calls that the build gun makes each frame.
+	for (const FFrame& frame : segment.Frames)
+	{
+		if (hologram == nullptr)
+		{
+			// The last placement finished, and the build gun would have started a new one.
+			hologram = spawnHologram(frame);
+			if (hologram == nullptr)
+				return;
+		}
+
+		if (frame.BuildMode != nullptr && frame.BuildMode != hologram->GetCurrentBuildMode())
+		{
+			// OnBuildModeChanged is virtual and protected, and this is how the build gun gets to it.
+			TimeCall(timings.OnBuildModeChanged, [&] { hologram->SetBuildMode(frame.BuildMode); });
+		}
+		if (frame.ScrollValue != hologram->GetScrollRotateValue())
+		{
+			hologram->SetScrollRotateValue(frame.ScrollValue);
+		}
+
+		const bool snapped = TimeCall(timings.TrySnapToActor, [&] { return hologram->TrySnapToActor(frame.HitResult); });
+		if (!snapped)
+		{
+			TimeCall(timings.SetHologramLocationAndRotation, [&] { hologram->SetHologramLocationAndRotation(frame.HitResult); });
+		}
+		TimeCall(timings.PostHologramPlacement, [&] { hologram->PostHologramPlacement(frame.HitResult, true); });
+
+		// The build gun would construct the hologram once the last step is done, but the replay leaves
+		// the save as it was and just moves on to a new hologram.
+		bool isPlacementDone = false;
+		if (frame.Pressed)
+		{
+			isPlacementDone = TimeCall(timings.DoMultiStepPlacement, [&] { return hologram->DoMultiStepPlacement(false); });
+		}
+		if (frame.Released && !isPlacementDone)
+		{
+			isPlacementDone = TimeCall(timings.DoMultiStepPlacement, [&] { return hologram->DoMultiStepPlacement(true); });
+		}
+		if (isPlacementDone)
+		{
+			hologram->Destroy();
+			hologram = nullptr;
+		}
+	}
+
+	if (hologram != nullptr)
+	{
+		hologram->Destroy();
+	}
+}
+
+TSharedRef<FJsonObject> FModBenchmarkHologramReplay::SaveFrame(const FFrame& frame)
+{
+	const FHitResult& hitResult = frame.HitResult;
+
+	auto object = MakeShared<FJsonObject>();
+	object->SetBoolField(TEXT("BlockingHit"), hitResult.bBlockingHit);
+	object->SetArrayField(TEXT("Location"), SaveVector(hitResult.Location));
+	object->SetArrayField(TEXT("ImpactPoint"), SaveVector(hitResult.ImpactPoint));
+	object->SetArrayField(TEXT("Normal"), SaveVector(hitResult.Normal));
+	object->SetArrayField(TEXT("ImpactNormal"), SaveVector(hitResult.ImpactNormal));
+	object->SetArrayField(TEXT("TraceStart"), SaveVector(hitResult.TraceStart));
+	object->SetArrayField(TEXT("TraceEnd"), SaveVector(hitResult.TraceEnd));
+	object->SetNumberField(TEXT("Distance"), hitResult.Distance);
+	object->SetStringField(TEXT("Actor"), GetPathNameSafe(hitResult.GetActor()));
+	object->SetStringField(TEXT("Component"), GetPathNameSafe(hitResult.GetComponent()));
+	object->SetNumberField(TEXT("Item"), hitResult.Item);
+	object->SetStringField(TEXT("BuildMode"), GetPathNameSafe(frame.BuildMode));
+	object->SetNumberField(TEXT("Scroll"), frame.ScrollValue);
+	object->SetBoolField(TEXT("Pressed"), frame.Pressed);
+	object->SetBoolField(TEXT("Released"), frame.Released);
+	return object;
+}
+
+bool FModBenchmarkHologramReplay::LoadFrame(const FJsonObject& object, FFrame& out_frame)
+{
+	FHitResult& hitResult = out_frame.HitResult;
+	hitResult.bBlockingHit = object.GetBoolField(TEXT("BlockingHit"));
+	hitResult.Location = LoadVector(object, TEXT("Location"));
+	hitResult.ImpactPoint = LoadVector(object, TEXT("ImpactPoint"));
+	hitResult.Normal = LoadVector(object, TEXT("Normal"));
+	hitResult.ImpactNormal = LoadVector(object, TEXT("ImpactNormal"));
+	hitResult.TraceStart = LoadVector(object, TEXT("TraceStart"));
+	hitResult.TraceEnd = LoadVector(object, TEXT("TraceEnd"));
+	hitResult.Distance = object.GetNumberField(TEXT("Distance"));
+	hitResult.Item = object.GetIntegerField(TEXT("Item"));
+
+	const FString buildModePath = object.GetStringField(TEXT("BuildMode"));
+	if (!buildModePath.IsEmpty() && buildModePath != TEXT("None"))
+	{
+		out_frame.BuildMode = LoadClass<UFGHologramBuildModeDescriptor>(nullptr, *buildModePath);
+	}
+	out_frame.ScrollValue = object.GetIntegerField(TEXT("Scroll"));
+
+	// Older recordings don't have these, and only ever placed the first step.
+	object.TryGetBoolField(TEXT("Pressed"), out_frame.Pressed);
+	object.TryGetBoolField(TEXT("Released"), out_frame.Released);
+
+	// Actors loaded from a save keep their names, so they can be found again in the same save.
+	const FString actorPath = object.GetStringField(TEXT("Actor"));
+	if (actorPath.IsEmpty() || actorPath == TEXT("None"))
+		return true;	// Didn't hit anything.
+
+	auto* actor = FindObject<AActor>(nullptr, *actorPath);
+	if (actor == nullptr)
+		return false;
+
+	hitResult.HitObjectHandle = FActorInstanceHandle(actor);
+	hitResult.Component = FindObject<UPrimitiveComponent>(nullptr, *object.GetStringField(TEXT("Component")));
+	return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+class AFGHologram;
+class FJsonObject;
+class UFGHologramBuildModeDescriptor;
+class UFGRecipe;
+class UWorld;
+
+/// Records what the build gun feeds to a hologram during a real session, and replays it to time the
+/// hologram code on its own.
+///
+/// ModBenchmark.RecordHologram samples the local player's build gun every frame, storing the hit
+/// result, the build mode and the scroll value along with the recipe, and notes on the latest frame
+/// whenever the fire button is pressed or released. ModBenchmark.ReplayHologram loads the same save,
+/// spawns a hologram for each recorded recipe and pushes the recorded frames through it as fast as it
+/// can, in the same order that the build gun would make the calls, then writes the time that each
+/// call took. The presses and releases are replayed through DoMultiStepPlacement, so holograms that
+/// are placed in more than one step (like a lift's bottom and then its top) get to every step, and a
+/// fresh hologram is spawned whenever one finishes, the same as the build gun would. Nothing is
+/// actually built. Lift holograms also get UpdateTopTransform timed.
+///
+/// The hit results refer to actors by path name, so the replay has to be done in the same save
+/// that the recording was made in, without anything built or dismantled in between.
+class FModBenchmarkHologramReplay
+{
+public:
+	static void StartRecording(UWorld* world, const FString& path);
+	static void StopRecording();
+
+	static void Replay(UWorld* world, const FString& path, int32 iterations);
+
+private:
+	struct FFrame
+	{
+		FHitResult HitResult;
+		TSubclassOf<UFGHologramBuildModeDescriptor> BuildMode;
+		int32 ScrollValue = 0;
+		/// Whether the fire button was pressed or released after this frame's placement.
+		bool Pressed = false;
+		bool Released = false;
+	};
+
+	struct FSegment
+	{
+		TSubclassOf<UFGRecipe> Recipe;
+		TArray<FFrame> Frames;
+	};
+
+	struct FTimings
+	{
+		TArray<float> TrySnapToActor;
+		TArray<float> SetHologramLocationAndRotation;
+		TArray<float> PostHologramPlacement;
+		TArray<float> OnBuildModeChanged;
+		TArray<float> DoMultiStepPlacement;
+		TArray<float> UpdateTopTransform;
+	};
+
+	static bool Tick(float deltaTime);
+	static AFGHologram* GetBuildGunHologram(UWorld* world, FHitResult* out_hitResult = nullptr);
+	static void InstallRecordingHooks();
+	static void RecordFire(bool isRelease);
+	static void InstallTimingHooks();
+	static void ReplaySegment(UWorld* world, const FSegment& segment);
+
+	static TSharedRef<FJsonObject> SaveFrame(const FFrame& frame);
+	static bool LoadFrame(const FJsonObject& object, FFrame& out_frame);
+
+	static TWeakObjectPtr<UWorld> RecordingWorld;
+	static FString RecordingPath;
+	static TArray<FSegment> RecordedSegments;
+	static FTSTicker::FDelegateHandle TickerHandle;
+
+	/// Only set while replaying, so that the timing hooks don't record anything from normal play.
+	static FTimings* ActiveTimings;
+};
@@ -0,0 +1,257 @@
+#include "ModBenchmarkReplication.h"
+
+#include "Buildables/FGBuildableConveyorAttachment.h"
+#include "Buildables/FGBuildableConveyorLift.h"
+#include "Dom/JsonObject.h"
+#include "Engine/ActorChannel.h"
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "FGFactoryConnectionComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ModBenchmarks.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+namespace
+{
+
+FString GetDefaultPath(const TCHAR* prefix)
+{
+	const FString fileName = FString::Printf(TEXT("%s-%s.json"), prefix, *FDateTime::Now().ToString());
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("ModBenchmarks"), fileName);
+}
+
+bool WriteJson(const TSharedRef<FJsonObject>& root, const FString& path)
+{
+	FString json;
+	FJsonSerializer::Serialize(root, TJsonWriterFactory<>::Create(&json));
+
+	if (!FFileHelper::SaveStringToFile(json, *path))
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Failed to write %s."), *path);
+		return false;
+	}
+
+	UE_LOG(LogModBenchmarks, Display, TEXT("Wrote %s."), *path);
+	return true;
+}
+
+TSharedPtr<FJsonObject> ReadJson(const FString& path)
+{
+	FString json;
+	TSharedPtr<FJsonObject> root;
+	if (!FFileHelper::LoadFileToString(json, *path) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(json), root))
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Failed to read %s."), *path);
+		return nullptr;
+	}
+	return root;
+}
+
+/// Actors are matched up between the server and the clients by their location, rounded to the nearest
+/// centimetre.
+FString GetActorKey(const AActor* actor)
+{
+	const FIntVector location(actor->GetActorLocation().GridSnap(1.0));
+	return FString::Printf(TEXT("%s@%i,%i,%i"), *actor->GetClass()->GetName(), location.X, location.Y, location.Z);
+}
+
+FAutoConsoleCommand WriteReplicationReportCommand(
+	TEXT("ModBenchmark.WriteReplicationReport"),
+	TEXT("Writes the replication bytes per actor class to [File]. Needs -ModBenchmarkReplication."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& args)
+	{
+		if (FModBenchmarkReplication* replication = FModBenchmarkReplication::Get())
+		{
+			replication->WriteReport(args.Num() > 0 ? args[0] : GetDefaultPath(TEXT("Replication")));
+		}
+		else
+		{
+			UE_LOG(LogModBenchmarks, Error, TEXT("Replication isn't being recorded, start the server with -ModBenchmarkReplication."));
+		}
+	}));
+
+FAutoConsoleCommandWithWorldAndArgs DumpVerticalStateCommand(
+	TEXT("ModBenchmark.DumpVerticalState"),
+	TEXT("Writes the vertical connection directions and lift rotation flags to [File]."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& args, UWorld* world)
+	{
+		FModBenchmarkReplication::DumpVerticalState(world, args.Num() > 0 ? args[0] : GetDefaultPath(TEXT("VerticalState")));
+	}));
+
+FAutoConsoleCommand CompareVerticalStateCommand(
+	TEXT("ModBenchmark.CompareVerticalState"),
+	TEXT("Checks that the vertical state dumped on a client (second file) matches the server (first file)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& args)
+	{
+		if (args.Num() != 2)
+		{
+			UE_LOG(LogModBenchmarks, Error, TEXT("Expected two files."));
+			return;
+		}
+		FModBenchmarkReplication::CompareVerticalState(args[0], args[1]);
+	}));
+
+} // namespace
+
+FModBenchmarkReplication* FModBenchmarkReplication::Instance = nullptr;
+
+FModBenchmarkReplication::FModBenchmarkReplication()
+{
+	check(Instance == nullptr);
+	Instance = this;
+
+	PostLoginHandle = FGameModeEvents::GameModePostLoginEvent.AddRaw(this, &FModBenchmarkReplication::OnPostLogin);
+}
+
+FModBenchmarkReplication::~FModBenchmarkReplication()
+{
+	FGameModeEvents::GameModePostLoginEvent.Remove(PostLoginHandle);
+	Instance = nullptr;
+}
+
+void FModBenchmarkReplication::OnPostLogin(AGameModeBase* gameMode, APlayerController* newPlayer)
+{
+	if (UNetConnection* connection = newPlayer ? newPlayer->GetNetConnection() : nullptr)
+	{
+		FConnectionStats& stats = ConnectionStats.FindOrAdd(connection);
+		stats.JoinTime = FPlatformTime::Seconds();
+	}
+}
+
+void FModBenchmarkReplication::OnReplicateActor(UActorChannel* channel, int64 numBits)
+{
+	if (channel == nullptr || channel->Actor == nullptr || numBits <= 0)
+		return;
+
+	FClassStats& classStats = ClassStats.FindOrAdd(channel->Actor->GetClass());
+	classStats.TotalBits += numBits;
+
+	FConnectionStats* connectionStats = ConnectionStats.Find(channel->Connection.Get());
+	if (connectionStats == nullptr)
+		return;	// Not a connection that we saw join.
+
+	// The first time that something is sent on a channel is the actor's initial replication.
+	bool alreadySeen;
+	connectionStats->SeenChannels.Add(channel, &alreadySeen);
+	if (!alreadySeen)
+	{
+		++classStats.NumActors;
+		classStats.InitialBits += numBits;
+		connectionStats->InitialBits += numBits;
+		connectionStats->LastInitialReplicationTime = FPlatformTime::Seconds();
+	}
+}
+
+void FModBenchmarkReplication::WriteReport(const FString& path)
+{
+	TArray<TSharedPtr<FJsonValue>> classes;
+	for (const auto& [actorClass, stats] : ClassStats)
+	{
+		auto classObject = MakeShared<FJsonObject>();
+		classObject->SetStringField(TEXT("Class"), actorClass->GetPathName());
+		classObject->SetNumberField(TEXT("InitialActors"), stats.NumActors);
+		classObject->SetNumberField(TEXT("InitialBytes"), stats.InitialBits / 8.0);
+		classObject->SetNumberField(TEXT("InitialBytesPerActor"), stats.NumActors > 0 ? stats.InitialBits / 8.0 / stats.NumActors : 0.0);
+		classObject->SetNumberField(TEXT("TotalBytes"), stats.TotalBits / 8.0);
+		classes.Add(MakeShared<FJsonValueObject>(MoveTemp(classObject)));
+	}
+
+	TArray<TSharedPtr<FJsonValue>> connections;
+	for (const auto& [connection, stats] : ConnectionStats)
+	{
+		auto connectionObject = MakeShared<FJsonObject>();
+		connectionObject->SetNumberField(TEXT("InitialBytes"), stats.InitialBits / 8.0);
+		connectionObject->SetNumberField(TEXT("InitialActors"), stats.SeenChannels.Num());
+		connectionObject->SetNumberField(TEXT("InitialReplicationSeconds"), FMath::Max(stats.LastInitialReplicationTime - stats.JoinTime, 0.0));
+		connections.Add(MakeShared<FJsonValueObject>(MoveTemp(connectionObject)));
+	}
+
+	auto root = MakeShared<FJsonObject>();
+	root->SetArrayField(TEXT("Classes"), MoveTemp(classes));
+	root->SetArrayField(TEXT("Connections"), MoveTemp(connections));
+	WriteJson(root, path);
+}
+
+bool FModBenchmarkReplication::DumpVerticalState(UWorld* world, const FString& path)
+{
+	if (world == nullptr)
+		return false;
+
+	auto attachments = MakeShared<FJsonObject>();
+	for (TActorIterator<AFGBuildableConveyorAttachment> it(world); it; ++it)
+	{
+		auto directions = MakeShared<FJsonObject>();
+		for (const auto* connection : TInlineComponentArray<UFGFactoryConnectionComponent*>(*it))
+		{
+			directions->SetNumberField(connection->GetName(), static_cast<int32>(connection->GetDirection()));
+		}
+		attachments->SetObjectField(GetActorKey(*it), directions);
+	}
+
+	auto lifts = MakeShared<FJsonObject>();
+	for (TActorIterator<AFGBuildableConveyorLift> it(world); it; ++it)
+	{
+		lifts->SetBoolField(GetActorKey(*it), it->mIsBeltUsingInputRotation);
+	}
+
+	auto root = MakeShared<FJsonObject>();
+	root->SetBoolField(TEXT("Authority"), world->GetNetMode() != NM_Client);
+	root->SetObjectField(TEXT("Attachments"), attachments);
+	root->SetObjectField(TEXT("Lifts"), lifts);
+	return WriteJson(root, path);
+}
+
+bool FModBenchmarkReplication::CompareVerticalState(const FString& expectedPath, const FString& actualPath)
+{
+	const TSharedPtr<FJsonObject> expected = ReadJson(expectedPath);
+	const TSharedPtr<FJsonObject> actual = ReadJson(actualPath);
+	if (!expected || !actual)
+		return false;
+
+	int32 numCompared = 0;
+	int32 numMismatches = 0;
+
+	// Anything that the client doesn't have at all is skipped, since it might just not be relevant to
+	// that client; it's only differences in what both sides have that are a problem.
+	const auto compare = [&](const TCHAR* field)
+	{
+		const TSharedPtr<FJsonObject>* expectedObject;
+		const TSharedPtr<FJsonObject>* actualObject;
+		if (!expected->TryGetObjectField(field, expectedObject) || !actual->TryGetObjectField(field, actualObject))
+			return;
+
+		for (const auto& [key, expectedValue] : (*expectedObject)->Values)
+		{
+			const TSharedPtr<FJsonValue> actualValue = (*actualObject)->TryGetField(key);
+			if (!actualValue.IsValid())
+				continue;
+
+			++numCompared;
+			if (!FJsonValue::CompareEqual(*expectedValue, *actualValue))
+			{
+				++numMismatches;
+				UE_LOG(LogModBenchmarks, Error, TEXT("%s doesn't match the server."), *key);
+			}
+		}
+	};
+
+	compare(TEXT("Attachments"));
+	compare(TEXT("Lifts"));
+
+	if (numMismatches != 0)
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Vertical state check FAILED: %i of %i actors don't match."), numMismatches, numCompared);
+		return false;
+	}
+
+	UE_LOG(LogModBenchmarks, Display, TEXT("Vertical state check passed: %i actors match."), numCompared);
+	return true;
+}
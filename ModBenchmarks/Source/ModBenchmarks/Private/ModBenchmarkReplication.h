@@ -0,0 +1,62 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AGameModeBase;
+class APlayerController;
+class UActorChannel;
+class UNetConnection;
+class UWorld;
+
+/// Tools for measuring what the vertical logistics buildables cost to replicate, and for checking that
+/// the clients end up with the same state as the server.
+///
+/// Start a dedicated server with -ModBenchmarkReplication and connect one or more clients to it
+/// (e.g. headless clients on localhost with -nullrhi). The server records the initial replication of
+/// every actor to every connection, and ModBenchmark.WriteReplicationReport writes the bytes and time
+/// per actor class to a JSON file.
+///
+/// ModBenchmark.DumpVerticalState writes the vertical connection directions and lift rotation flags
+/// seen by whoever runs it; run it on the server and each client, then use
+/// ModBenchmark.CompareVerticalState to check that they match.
+class FModBenchmarkReplication
+{
+public:
+	FModBenchmarkReplication();
+	~FModBenchmarkReplication();
+
+	UE_NONCOPYABLE(FModBenchmarkReplication);
+
+	void OnPostLogin(AGameModeBase* gameMode, APlayerController* newPlayer);
+	void OnReplicateActor(UActorChannel* channel, int64 numBits);
+
+	void WriteReport(const FString& path);
+
+	static bool DumpVerticalState(UWorld* world, const FString& path);
+	static bool CompareVerticalState(const FString& expectedPath, const FString& actualPath);
+
+	static FModBenchmarkReplication* Get() { return Instance; }
+
+private:
+	struct FClassStats
+	{
+		int32 NumActors = 0;
+		int64 InitialBits = 0;
+		int64 TotalBits = 0;
+	};
+
+	struct FConnectionStats
+	{
+		double JoinTime = 0.0;
+		double LastInitialReplicationTime = 0.0;
+		int64 InitialBits = 0;
+		TSet<TWeakObjectPtr<UActorChannel>> SeenChannels;
+	};
+
+	static FModBenchmarkReplication* Instance;
+
+	TMap<const UClass*, FClassStats> ClassStats;
+	TMap<TWeakObjectPtr<UNetConnection>, FConnectionStats> ConnectionStats;
+
+	FDelegateHandle PostLoginHandle;
+};
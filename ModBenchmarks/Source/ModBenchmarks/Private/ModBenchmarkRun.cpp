@@ -0,0 +1,229 @@
+#include "ModBenchmarkRun.h"
+
+#include "Buildables/FGBuildableConveyorAttachment.h"
+#include "Buildables/FGBuildableConveyorLift.h"
+#include "Buildables/FGBuildablePassthrough.h"
+#include "Buildables/FGBuildablePowerPole.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "FGTrainStationIdentifier.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ModBenchmarks.h"
+#include "ModLoading/ModLoadingLibrary.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+
+/// Nearest-rank percentile of an already sorted array.
+double GetPercentile(const TArray<double>& sortedValues, double percentile)
+{
+	if (sortedValues.IsEmpty())
+		return 0.0;
+
+	const int32 index = FMath::Clamp(FMath::CeilToInt32(percentile / 100.0 * sortedValues.Num()) - 1, 0, sortedValues.Num() - 1);
+	return sortedValues[index];
+}
+
+TSharedRef<FJsonObject> MakeTimingObject(TArray<double> values)
+{
+	values.Sort();
+
+	double sum = 0.0;
+	for (const double value : values)
+	{
+		sum += value;
+	}
+
+	auto object = MakeShared<FJsonObject>();
+	object->SetNumberField(TEXT("Mean"), values.IsEmpty() ? 0.0 : sum / values.Num());
+	object->SetNumberField(TEXT("P50"), GetPercentile(values, 50.0));
+	object->SetNumberField(TEXT("P90"), GetPercentile(values, 90.0));
+	object->SetNumberField(TEXT("P99"), GetPercentile(values, 99.0));
+	object->SetNumberField(TEXT("Max"), values.IsEmpty() ? 0.0 : values.Last());
+	return object;
+}
+
+template<class T>
+int32 CountActors(UWorld* world)
+{
+	int32 count = 0;
+	for (TActorIterator<T> it(world); it; ++it)
+	{
+		++count;
+	}
+	return count;
+}
+
+} // namespace
+
+FModBenchmarkRun::FModBenchmarkRun()
+	: StartTime(FPlatformTime::Seconds())
+{
+	const TCHAR* commandLine = FCommandLine::Get();
+	FParse::Value(commandLine, TEXT("ModBenchmarkLabel="), Label);
+	FParse::Value(commandLine, TEXT("ModBenchmarkOutput="), OutputPath);
+	FParse::Value(commandLine, TEXT("ModBenchmarkWarmupFrames="), WarmupFrames);
+	FParse::Value(commandLine, TEXT("ModBenchmarkFrames="), MeasuredFrames);
+	QuitWhenDone = FParse::Param(commandLine, TEXT("ModBenchmarkQuit"));
+
+	FrameTimes.Reserve(MeasuredFrames);
+	WorldTickTimes.Reserve(MeasuredFrames);
+
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddRaw(this, &FModBenchmarkRun::OnPostLoadMap);
+
+	UE_LOG(LogModBenchmarks, Display, TEXT("Benchmark '%s' started."), *Label);
+}
+
+FModBenchmarkRun::~FModBenchmarkRun()
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+	FWorldDelegates::OnWorldPostActorTick.Remove(WorldPostActorTickHandle);
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+}
+
+void FModBenchmarkRun::OnPostInitialization()
+{
+	// Game instance modules are initialized once when the game instance starts, before any map loads,
+	// but only the first one counts in case that ever changes.
+	if (PostInitializationTime < 0.0)
+	{
+		PostInitializationTime = FPlatformTime::Seconds();
+	}
+}
+
+void FModBenchmarkRun::OnPostLoadMap(UWorld* world)
+{
+	if (world == nullptr || !world->IsGameWorld() || world->GetMapName().Contains(TEXT("MenuScene")))
+		return;	// Not the save.
+
+	MapLoadedTime = FPlatformTime::Seconds();
+	MapLoadedMemory = FPlatformMemory::GetStats().UsedPhysical;
+	World = world;
+
+	UE_LOG(LogModBenchmarks, Display, TEXT("Loaded %s after %.3fs, measuring %i frames."),
+		*world->GetMapName(), MapLoadedTime - StartTime, MeasuredFrames);
+
+	WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddRaw(this, &FModBenchmarkRun::OnWorldTickStart);
+	WorldPostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddRaw(this, &FModBenchmarkRun::OnWorldPostActorTick);
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FModBenchmarkRun::OnEndFrame);
+}
+
+void FModBenchmarkRun::OnWorldTickStart(UWorld* world, ELevelTick tickType, float deltaTime)
+{
+	if (world == World)
+	{
+		WorldTickStartTime = FPlatformTime::Seconds();
+	}
+}
+
+void FModBenchmarkRun::OnWorldPostActorTick(UWorld* world, ELevelTick tickType, float deltaTime)
+{
+	// The frame time on a server mostly measures how long it sleeps for to hit its tick rate, so the
+	// time spent ticking the world is recorded separately.
+	if (world == World && NumFrames >= WarmupFrames && !Finished)
+	{
+		WorldTickTimes.Add((FPlatformTime::Seconds() - WorldTickStartTime) * 1000.0);
+	}
+}
+
+void FModBenchmarkRun::OnEndFrame()
+{
+	if (Finished)
+		return;
+
+	if (NumFrames++ >= WarmupFrames)
+	{
+		FrameTimes.Add(FApp::GetDeltaTime() * 1000.0);
+	}
+
+	if (FrameTimes.Num() < MeasuredFrames)
+		return;	// Not done yet.
+
+	Finished = true;
+	WriteResults();
+
+	if (QuitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void FModBenchmarkRun::WriteResults() const
+{
+	UWorld* world = World.Get();
+
+	TArray<TSharedPtr<FJsonValue>> mods;
+	if (const auto* modLoading = GEngine ? GEngine->GetEngineSubsystem<UModLoadingLibrary>() : nullptr)
+	{
+		for (const FModInfo& mod : modLoading->GetLoadedMods())
+		{
+			auto modObject = MakeShared<FJsonObject>();
+			modObject->SetStringField(TEXT("Name"), mod.Name);
+			modObject->SetStringField(TEXT("Version"), mod.Version.ToString());
+			mods.Add(MakeShared<FJsonValueObject>(MoveTemp(modObject)));
+		}
+	}
+
+	auto actors = MakeShared<FJsonObject>();
+	if (world != nullptr)
+	{
+		actors->SetNumberField(TEXT("Lifts"), CountActors<AFGBuildableConveyorLift>(world));
+		actors->SetNumberField(TEXT("Passthroughs"), CountActors<AFGBuildablePassthrough>(world));
+		actors->SetNumberField(TEXT("ConveyorAttachments"), CountActors<AFGBuildableConveyorAttachment>(world));
+		actors->SetNumberField(TEXT("PowerPoles"), CountActors<AFGBuildablePowerPole>(world));
+		actors->SetNumberField(TEXT("TrainStations"), CountActors<AFGTrainStationIdentifier>(world));
+	}
+
+	const FPlatformMemoryStats memory = FPlatformMemory::GetStats();
+	auto memoryObject = MakeShared<FJsonObject>();
+	memoryObject->SetNumberField(TEXT("AfterLoadMB"), MapLoadedMemory / (1024.0 * 1024.0));
+	memoryObject->SetNumberField(TEXT("EndMB"), memory.UsedPhysical / (1024.0 * 1024.0));
+	memoryObject->SetNumberField(TEXT("PeakMB"), memory.PeakUsedPhysical / (1024.0 * 1024.0));
+
+	auto root = MakeShared<FJsonObject>();
+	root->SetStringField(TEXT("Label"), Label);
+	root->SetStringField(TEXT("Map"), world ? world->GetMapName() : FString());
+	root->SetBoolField(TEXT("DedicatedServer"), IsRunningDedicatedServer());
+	root->SetArrayField(TEXT("Mods"), MoveTemp(mods));
+	root->SetObjectField(TEXT("Actors"), actors);
+	root->SetNumberField(TEXT("LoadSeconds"), MapLoadedTime - StartTime);
+	root->SetNumberField(TEXT("PostInitializationSeconds"), PostInitializationTime >= 0.0 ? PostInitializationTime - StartTime : -1.0);
+	root->SetObjectField(TEXT("FrameMs"), MakeTimingObject(FrameTimes));
+	root->SetObjectField(TEXT("WorldTickMs"), MakeTimingObject(WorldTickTimes));
+	root->SetObjectField(TEXT("Memory"), memoryObject);
+
+	FString json;
+	FJsonSerializer::Serialize(root, TJsonWriterFactory<>::Create(&json));
+
+	const FString path = GetOutputPath();
+	if (FFileHelper::SaveStringToFile(json, *path))
+	{
+		UE_LOG(LogModBenchmarks, Display, TEXT("Wrote benchmark results to %s."), *path);
+	}
+	else
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Failed to write %s."), *path);
+	}
+}
+
+FString FModBenchmarkRun::GetOutputPath() const
+{
+	if (!OutputPath.IsEmpty())
+		return OutputPath;
+
+	const FString fileName = FString::Printf(TEXT("%s%s%s.json"),
+		*Label, Label.IsEmpty() ? TEXT("") : TEXT("-"), *FDateTime::Now().ToString());
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("ModBenchmarks"), fileName);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+/// Records how long a save takes to load and how well it runs afterwards, then writes the results to
+/// a JSON file. Enabled by starting the game or dedicated server with -ModBenchmark, e.g.
+///
+///     FactoryServer.sh -nullrhi -ModBenchmark -ModBenchmarkQuit -ModBenchmarkLabel=vlqol-off
+///
+/// Other options are -ModBenchmarkWarmupFrames=N, -ModBenchmarkFrames=N and
+/// -ModBenchmarkOutput=<file>. The save to load is picked the same way as normal (e.g. the server's
+/// autoload session). Comparing the mods with and without a plugin is done by running the server again
+/// with a different set of mods enabled; the enabled mods are recorded in each result file.
+/// Scripts/run_benchmarks.py does that for a list of mod sets and summarizes the results.
+class FModBenchmarkRun
+{
+public:
+	FModBenchmarkRun();
+	~FModBenchmarkRun();
+
+	UE_NONCOPYABLE(FModBenchmarkRun);
+
+	void OnPostInitialization();
+
+private:
+	void OnPostLoadMap(UWorld* world);
+	void OnWorldTickStart(UWorld* world, ELevelTick tickType, float deltaTime);
+	void OnWorldPostActorTick(UWorld* world, ELevelTick tickType, float deltaTime);
+	void OnEndFrame();
+
+	void WriteResults() const;
+	FString GetOutputPath() const;
+
+	/// Command line options.
+	FString Label;
+	FString OutputPath;
+	int32 WarmupFrames = 300;
+	int32 MeasuredFrames = 1800;
+	bool QuitWhenDone = false;
+
+	double StartTime;
+	double PostInitializationTime = -1.0;
+	double MapLoadedTime = -1.0;
+	uint64 MapLoadedMemory = 0;
+
+	TWeakObjectPtr<UWorld> World;
+	int32 NumFrames = 0;
+	double WorldTickStartTime = 0.0;
+	TArray<double> FrameTimes;
+	TArray<double> WorldTickTimes;
+	bool Finished = false;
+
+	FDelegateHandle PostLoadMapHandle;
+	FDelegateHandle WorldTickStartHandle;
+	FDelegateHandle WorldPostActorTickHandle;
+	FDelegateHandle EndFrameHandle;
+};
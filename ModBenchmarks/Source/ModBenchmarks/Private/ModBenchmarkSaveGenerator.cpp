@@ -0,0 +1,417 @@
+#include "ModBenchmarkSaveGenerator.h"
+
+#include "AssetRegistry/IAssetRegistry.h"
+#include "Buildables/FGBuildableConveyorAttachment.h"
+#include "Buildables/FGBuildableConveyorLift.h"
+#include "Buildables/FGBuildablePassthrough.h"
+#include "Buildables/FGBuildablePowerPole.h"
+#include "Buildables/FGBuildableRailroadStation.h"
+#include "Buildables/FGBuildableWire.h"
+#include "FGBuildableSubsystem.h"
+#include "FGCircuitConnectionComponent.h"
+#include "FGClearanceInterface.h"
+#include "FGFactoryConnectionComponent.h"
+#include "FGHologramOverride.h"
+#include "FGSaveSession.h"
+#include "FGTrainStationIdentifier.h"
+#include "HAL/IConsoleManager.h"
+#include "Hologram/FGConveyorAttachmentHologram.h"
+#include "ModBenchmarks.h"
+
+namespace
+{
+
+FAutoConsoleCommandWithWorldAndArgs GenerateVerticalLogisticsCommand(
+	TEXT("ModBenchmark.GenerateVerticalLogistics"),
+	TEXT("Builds lift columns for stress testing and saves the game. Arguments (all optional): Columns=N Floors=N AttachmentsPerColumn=N DownwardFraction=F PowerPoles=N TrainStations=N Seed=N X=F Y=F Z=F Save=Name LiftClass=Path PassthroughClass=Path BuildingClass=Path PowerPoleClass=Path WireClass=Path TrainStationClass=Path"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& args, UWorld* world)
+	{
+		const FString argString = FString::Join(args, TEXT(" "));
+		const TCHAR* argText = *argString;
+
+		FModBenchmarkSaveGenerator::FSettings settings;
+		FParse::Value(argText, TEXT("Columns="), settings.Columns);
+		FParse::Value(argText, TEXT("Floors="), settings.Floors);
+		FParse::Value(argText, TEXT("AttachmentsPerColumn="), settings.AttachmentsPerColumn);
+		FParse::Value(argText, TEXT("DownwardFraction="), settings.DownwardFraction);
+		FParse::Value(argText, TEXT("PowerPoles="), settings.PowerPoles);
+		FParse::Value(argText, TEXT("TrainStations="), settings.TrainStations);
+		FParse::Value(argText, TEXT("Seed="), settings.Seed);
+		FParse::Value(argText, TEXT("X="), settings.Origin.X);
+		FParse::Value(argText, TEXT("Y="), settings.Origin.Y);
+		FParse::Value(argText, TEXT("Z="), settings.Origin.Z);
+
+		settings.SaveName = FString::Printf(TEXT("VerticalLogistics_%ix%ix%i_%i"),
+			settings.Columns, settings.Floors, settings.AttachmentsPerColumn, settings.Seed);
+		if (settings.PowerPoles > 0 || settings.TrainStations > 0)
+		{
+			settings.SaveName += FString::Printf(TEXT("_%ipoles_%istations"), settings.PowerPoles, settings.TrainStations);
+		}
+		FParse::Value(argText, TEXT("Save="), settings.SaveName);
+
+		FString classPath = TEXT("/Game/FactoryGame/Buildable/Factory/ConveyorLiftMk1/Build_ConveyorLiftMk1.Build_ConveyorLiftMk1_C");
+		FParse::Value(argText, TEXT("LiftClass="), classPath);
+		settings.LiftClass = FSoftClassPath(classPath);
+
+		classPath = TEXT("/Game/FactoryGame/Buildable/Factory/FoundationPassthrough/Build_FoundationPassthrough_Lift.Build_FoundationPassthrough_Lift_C");
+		FParse::Value(argText, TEXT("PassthroughClass="), classPath);
+		settings.PassthroughClass = FSoftClassPath(classPath);
+
+		classPath = TEXT("/Game/FactoryGame/Buildable/Factory/ConstructorMk1/Build_ConstructorMk1.Build_ConstructorMk1_C");
+		FParse::Value(argText, TEXT("BuildingClass="), classPath);
+		settings.BuildingClass = FSoftClassPath(classPath);
+
+		classPath = TEXT("/Game/FactoryGame/Buildable/Factory/PowerPoleMk1/Build_PowerPoleMk1.Build_PowerPoleMk1_C");
+		FParse::Value(argText, TEXT("PowerPoleClass="), classPath);
+		settings.PowerPoleClass = FSoftClassPath(classPath);
+
+		classPath = TEXT("/Game/FactoryGame/Buildable/Factory/PowerLine/Build_PowerLine.Build_PowerLine_C");
+		FParse::Value(argText, TEXT("WireClass="), classPath);
+		settings.WireClass = FSoftClassPath(classPath);
+
+		classPath = TEXT("/Game/FactoryGame/Buildable/Factory/Train/Station/Build_TrainStation.Build_TrainStation_C");
+		FParse::Value(argText, TEXT("TrainStationClass="), classPath);
+		settings.TrainStationClass = FSoftClassPath(classPath);
+
+		FModBenchmarkSaveGenerator::Generate(world, settings);
+	}));
+
+} // namespace
+
+void FModBenchmarkSaveGenerator::Generate(UWorld* world, const FSettings& settings)
+{
+	if (world == nullptr || world->GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("The save generator has to be run on the server."));
+		return;
+	}
+
+	FModBenchmarkSaveGenerator generator(world, settings);
+	if (!generator.LoadClasses())
+		return;
+
+	const double startTime = FPlatformTime::Seconds();
+	const int32 gridSize = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(settings.Columns)));
+
+	for (int32 column = 0; column < settings.Columns; ++column)
+	{
+		const FVector base = settings.Origin + FVector((column % gridSize) * ColumnSpacing, (column / gridSize) * ColumnSpacing, 0.0);
+		generator.BuildColumn(base, generator.Random.FRand() < settings.DownwardFraction);
+	}
+
+	// The buildings go on one side of the lift columns and the stations on the other.
+	generator.BuildPowerPoles(settings.Origin - FVector(0.0, AreaSpacing, 0.0));
+	generator.BuildTrainStations(settings.Origin + FVector(0.0, AreaSpacing + gridSize * ColumnSpacing, 0.0));
+
+	UE_LOG(LogModBenchmarks, Display,
+		TEXT("Generated %i lifts, %i passthroughs, %i vertical attachments, %i building-mounted power poles with %i wires and %i train stations in %.3fs, saving as %s."),
+		generator.NumLifts, generator.NumPassthroughs, generator.NumAttachments, generator.NumPowerPoles, generator.NumWires, generator.NumTrainStations,
+		FPlatformTime::Seconds() - startTime, *settings.SaveName);
+
+	if (UFGSaveSession* saveSession = UFGSaveSession::Get(world))
+	{
+		saveSession->SaveGame(settings.SaveName);
+	}
+}
+
+FModBenchmarkSaveGenerator::FModBenchmarkSaveGenerator(UWorld* world, const FSettings& settings)
+	: World(world)
+	, Settings(settings)
+	, Random(settings.Seed)
+	, BuildableSubsystem(AFGBuildableSubsystem::Get(world))
+{
+}
+
+bool FModBenchmarkSaveGenerator::LoadClasses()
+{
+	LiftClass = Settings.LiftClass.TryLoadClass<AFGBuildableConveyorLift>();
+	PassthroughClass = Settings.PassthroughClass.TryLoadClass<AFGBuildablePassthrough>();
+
+	// The vertical attachments are found the same way that VerticalLogisticsQoL finds them, sorted so
+	// that the seed picks the same ones every time.
+	{
+		TSet<FTopLevelAssetPath> classNames;
+		IAssetRegistry::Get()->GetDerivedClassNames({ AFGBuildableConveyorAttachment::StaticClass()->GetClassPathName() }, {}, classNames);
+
+		TArray<FString> classPaths;
+		for (const FTopLevelAssetPath& className : classNames)
+		{
+			classPaths.Add(className.ToString());
+		}
+		classPaths.Sort();
+
+		for (const FString& classPath : classPaths)
+		{
+			UClass* attachmentClass = FSoftClassPath(classPath).TryLoadClass<AFGBuildableConveyorAttachment>();
+			if (attachmentClass != nullptr && IsVerticalAttachment(attachmentClass->GetDefaultObject<AFGBuildableConveyorAttachment>()))
+			{
+				VerticalAttachmentClasses.Add(attachmentClass);
+			}
+		}
+	}
+
+	if (BuildableSubsystem == nullptr || LiftClass == nullptr || PassthroughClass == nullptr)
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Failed to load %s or %s."),
+			*Settings.LiftClass.ToString(), *Settings.PassthroughClass.ToString());
+		return false;
+	}
+	if (Settings.AttachmentsPerColumn > 0 && VerticalAttachmentClasses.IsEmpty())
+	{
+		UE_LOG(LogModBenchmarks, Error, TEXT("Failed to find any vertical conveyor attachments."));
+		return false;
+	}
+
+	if (Settings.PowerPoles > 0)
+	{
+		BuildingClass = Settings.BuildingClass.TryLoadClass<AFGBuildable>();
+		PowerPoleClass = Settings.PowerPoleClass.TryLoadClass<AFGBuildablePowerPole>();
+		WireClass = Settings.WireClass.TryLoadClass<AFGBuildableWire>();
+		if (BuildingClass == nullptr || PowerPoleClass == nullptr || WireClass == nullptr)
+		{
+			UE_LOG(LogModBenchmarks, Error, TEXT("Failed to load %s, %s or %s."),
+				*Settings.BuildingClass.ToString(), *Settings.PowerPoleClass.ToString(), *Settings.WireClass.ToString());
+			return false;
+		}
+	}
+
+	if (Settings.TrainStations > 0)
+	{
+		TrainStationClass = Settings.TrainStationClass.TryLoadClass<AFGBuildableRailroadStation>();
+		if (TrainStationClass == nullptr)
+		{
+			UE_LOG(LogModBenchmarks, Error, TEXT("Failed to load %s."), *Settings.TrainStationClass.ToString());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FModBenchmarkSaveGenerator::BuildColumn(const FVector& base, bool flowsDown)
+{
+	const int32 numFloors = FMath::Max(Settings.Floors, 2);
+	const int32 numGaps = numFloors - 1;
+
+	// Pick which gaps get an attachment.
+	TArray<bool, TInlineAllocator<64>> gapHasAttachment;
+	gapHasAttachment.Init(false, numGaps);
+	for (int32 remaining = FMath::Min(Settings.AttachmentsPerColumn, numGaps), gap = 0; gap < numGaps; ++gap)
+	{
+		// Selection sampling, so that exactly the right number get picked.
+		if (Random.FRand() * (numGaps - gap) < remaining)
+		{
+			gapHasAttachment[gap] = true;
+			--remaining;
+		}
+	}
+
+	TArray<AFGBuildablePassthrough*, TInlineAllocator<64>> passthroughs;
+	for (int32 floor = 0; floor < numFloors; ++floor)
+	{
+		passthroughs.Add(SpawnPassthrough(base + FVector(0.0, 0.0, floor * FloorHeight)));
+	}
+
+	// Build the lifts in the direction of flow so that each one can be connected to the previous one.
+	UFGFactoryConnectionComponent* previousOutput = nullptr;
+	for (int32 step = 0; step < numGaps; ++step)
+	{
+		const int32 gap = flowsDown ? numGaps - 1 - step : step;
+		AFGBuildablePassthrough* fromPassthrough = passthroughs[flowsDown ? gap + 1 : gap];
+		AFGBuildablePassthrough* toPassthrough = passthroughs[flowsDown ? gap : gap + 1];
+		const FVector from = fromPassthrough->GetActorLocation();
+		const FVector to = toPassthrough->GetActorLocation();
+
+		AFGBuildableConveyorLift* lift;
+		if (gapHasAttachment[gap])
+		{
+			UFGFactoryConnectionComponent* attachmentInput;
+			UFGFactoryConnectionComponent* attachmentOutput;
+			const FVector middle = FVector(from.X, from.Y, FMath::GridSnap((from.Z + to.Z) * 0.5, 100.0));
+			SpawnAttachment(middle, flowsDown, attachmentInput, attachmentOutput);
+
+			SpawnLift(from, attachmentInput->GetComponentLocation(), fromPassthrough, nullptr, previousOutput, attachmentInput);
+			lift = SpawnLift(attachmentOutput->GetComponentLocation(), to, nullptr, toPassthrough, attachmentOutput, nullptr);
+		}
+		else
+		{
+			lift = SpawnLift(from, to, fromPassthrough, toPassthrough, previousOutput, nullptr);
+		}
+
+		previousOutput = lift->GetConnection1();
+	}
+}
+
+void FModBenchmarkSaveGenerator::BuildPowerPoles(const FVector& origin)
+{
+	if (Settings.PowerPoles <= 0)
+		return;
+
+	const int32 gridSize = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(Settings.PowerPoles)));
+	UFGCircuitConnectionComponent* previousPole = nullptr;
+
+	for (int32 index = 0; index < Settings.PowerPoles; ++index)
+	{
+		const int32 column = index % gridSize;
+		const FTransform transform(FRotator(0.0, Random.RandHelper(4) * 90.0, 0.0), origin + FVector(column * BuildingSpacing, -(index / gridSize) * BuildingSpacing, 0.0));
+		AFGBuildable* building = BuildableSubsystem->BeginSpawnBuildable(BuildingClass, transform);
+		building->FinishSpawning(transform);
+
+		// Each row of poles is wired together, the same as a row of buildings powered from their roofs.
+		UFGCircuitConnectionComponent* pole = SpawnPowerPole(GetRoofLocation(building));
+		if (column > 0 && previousPole != nullptr && pole != nullptr)
+		{
+			SpawnWire(previousPole, pole);
+		}
+		previousPole = pole;
+	}
+}
+
+void FModBenchmarkSaveGenerator::BuildTrainStations(const FVector& origin)
+{
+	if (Settings.TrainStations <= 0)
+		return;
+
+	const int32 gridSize = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(Settings.TrainStations)));
+
+	for (int32 index = 0; index < Settings.TrainStations; ++index)
+	{
+		const FTransform transform(origin + FVector((index % gridSize) * TrainStationSpacing, (index / gridSize) * TrainStationSpacing, 0.0));
+		auto* station = CastChecked<AFGBuildableRailroadStation>(BuildableSubsystem->BeginSpawnBuildable(TrainStationClass, transform));
+		station->FinishSpawning(transform);
+
+		// The station identifier is made by the railroad subsystem as the station begins play. Give each
+		// one a different name so that the map's station search has something to do.
+		if (AFGTrainStationIdentifier* identifier = station->GetStationIdentifier())
+		{
+			identifier->SetStationName(FText::FromString(FString::Printf(TEXT("Benchmark Station %05i"), index)));
+		}
+
+		++NumTrainStations;
+	}
+}
+
+UFGCircuitConnectionComponent* FModBenchmarkSaveGenerator::SpawnPowerPole(const FVector& location)
+{
+	const FTransform transform(location);
+	AFGBuildable* pole = BuildableSubsystem->BeginSpawnBuildable(PowerPoleClass, transform);
+	pole->FinishSpawning(transform);
+	++NumPowerPoles;
+	return pole->FindComponentByClass<UFGCircuitConnectionComponent>();
+}
+
+void FModBenchmarkSaveGenerator::SpawnWire(UFGCircuitConnectionComponent* from, UFGCircuitConnectionComponent* to)
+{
+	const FTransform transform(from->GetComponentLocation());
+	auto* wire = CastChecked<AFGBuildableWire>(BuildableSubsystem->BeginSpawnBuildable(WireClass, transform));
+	wire->Connect(from, to);
+	wire->FinishSpawning(transform);
+	++NumWires;
+}
+
+FVector FModBenchmarkSaveGenerator::GetRoofLocation(AFGBuildable* building)
+{
+	// The same as PowerPolesOnBuildings' automatic attachment points: the middle of the top of the
+	// clearance boxes, which wrap the building's meshes without needing the meshes themselves.
+	TArray<FFGClearanceData> clearanceData;
+	IFGClearanceInterface::Execute_GetClearanceData(building, clearanceData);
+
+	FBox bounds(ForceInit);
+	for (const FFGClearanceData& clearance : clearanceData)
+	{
+		bounds += clearance.ClearanceBox.TransformBy(clearance.RelativeTransform);
+	}
+
+	const FVector offset = bounds.IsValid ? FVector(bounds.GetCenter().X, bounds.GetCenter().Y, bounds.Max.Z) : FVector::ZeroVector;
+	return building->GetActorTransform().TransformPosition(offset);
+}
+
+bool FModBenchmarkSaveGenerator::IsVerticalAttachment(const AFGBuildableConveyorAttachment* attachment)
+{
+	for (const UFGHologramOverride* override : attachment->mHologramOverrides)
+	{
+		if (override && override->IsA<UFGHologramOverride_ConveyorAttachment_LiftToFloor>())
+			return true;
+	}
+	return false;
+}
+
+AFGBuildablePassthrough* FModBenchmarkSaveGenerator::SpawnPassthrough(const FVector& location)
+{
+	const FTransform transform(location);
+	auto* passthrough = CastChecked<AFGBuildablePassthrough>(BuildableSubsystem->BeginSpawnBuildable(PassthroughClass, transform));
+	passthrough->mSnappedBuildingThickness = 100.0f;
+	passthrough->FinishSpawning(transform);
+	++NumPassthroughs;
+	return passthrough;
+}
+
+AFGBuildableConveyorAttachment* FModBenchmarkSaveGenerator::SpawnAttachment(const FVector& location, bool flowsDown, UFGFactoryConnectionComponent*& out_input, UFGFactoryConnectionComponent*& out_output)
+{
+	UClass* attachmentClass = VerticalAttachmentClasses[Random.RandHelper(VerticalAttachmentClasses.Num())];
+
+	const FTransform transform(location);
+	auto* attachment = CastChecked<AFGBuildableConveyorAttachment>(BuildableSubsystem->BeginSpawnBuildable(attachmentClass, transform));
+
+	UFGFactoryConnectionComponent* bottom = nullptr;
+	UFGFactoryConnectionComponent* top = nullptr;
+	for (auto* connection : TInlineComponentArray<UFGFactoryConnectionComponent*>(attachment))
+	{
+		const FName name = connection->GetFName();
+		if (name == AFGConveyorAttachmentHologram::mLiftConnection_Bottom)
+			bottom = connection;
+		else if (name == AFGConveyorAttachmentHologram::mLiftConnection_Top)
+			top = connection;
+	}
+	check(bottom && top);
+
+	// The direction of the vertical connections is normally set up by the hologram.
+	out_input = flowsDown ? top : bottom;
+	out_output = flowsDown ? bottom : top;
+	out_input->SetDirection(EFactoryConnectionDirection::FCD_INPUT);
+	out_output->SetDirection(EFactoryConnectionDirection::FCD_OUTPUT);
+
+	attachment->FinishSpawning(transform);
+	++NumAttachments;
+	return attachment;
+}
+
+AFGBuildableConveyorLift* FModBenchmarkSaveGenerator::SpawnLift(const FVector& from, const FVector& to, AFGBuildablePassthrough* fromPassthrough, AFGBuildablePassthrough* toPassthrough, UFGFactoryConnectionComponent* input, UFGFactoryConnectionComponent* output)
+{
+	// Lifts always go from their input to their output, so the top transform is below the lift when
+	// it's flowing downwards.
+	const FTransform transform(from);
+	auto* lift = CastChecked<AFGBuildableConveyorLift>(BuildableSubsystem->BeginSpawnBuildable(LiftClass, transform));
+	lift->mTopTransform = FTransform(to - from);
+	lift->mSnappedPassthroughs = { fromPassthrough, toPassthrough };
+
+	if (input != nullptr)
+	{
+		lift->GetConnection0()->SetConnection(input);
+	}
+	if (output != nullptr)
+	{
+		lift->GetConnection1()->SetConnection(output);
+	}
+
+	lift->FinishSpawning(transform);
+
+	// Link the passthroughs back to the lift, with the same logic as FixLostPassthroughLinks.
+	if (fromPassthrough != nullptr)
+	{
+		if (fromPassthrough->GetActorLocation().Z < to.Z)
+			fromPassthrough->SetTopSnappedConnection(lift->GetConnection0());
+		else
+			fromPassthrough->SetBottomSnappedConnection(lift->GetConnection0());
+	}
+	if (toPassthrough != nullptr)
+	{
+		if (toPassthrough->GetActorLocation().Z < from.Z)
+			toPassthrough->SetTopSnappedConnection(lift->GetConnection1());
+		else
+			toPassthrough->SetBottomSnappedConnection(lift->GetConnection1());
+	}
+
+	++NumLifts;
+	return lift;
+}
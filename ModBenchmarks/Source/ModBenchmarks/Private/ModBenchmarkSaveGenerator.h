@@ -0,0 +1,96 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AFGBuildable;
+class AFGBuildableConveyorAttachment;
+class AFGBuildableConveyorLift;
+class AFGBuildablePassthrough;
+class AFGBuildableSubsystem;
+class UFGCircuitConnectionComponent;
+class UFGFactoryConnectionComponent;
+class UWorld;
+
+/// Builds a grid of lift columns for stress testing the vertical logistics fixes, then saves the game.
+///
+/// Each column goes up through a passthrough on every floor, with lifts between the passthroughs,
+/// and some of the gaps between floors have a vertical splitter or merger in the middle of them. Each
+/// column flows either up or down. Everything is picked from a seeded random stream, so the same
+/// settings always produce the same layout.
+///
+/// It can also build rows of buildings with a power pole on each of their roofs, wired to the next pole
+/// along the row, and rows of train stations, to one side of the lift columns. The poles are where
+/// PowerPolesOnBuildings would put them, and the stations are what FixTrainStationMapLocation tracks.
+///
+/// The buildables are spawned straight through the buildable subsystem rather than holograms, so
+/// there are no foundations for the passthroughs to sit in, the train stations don't have any track,
+/// and nothing costs anything.
+class FModBenchmarkSaveGenerator
+{
+public:
+	struct FSettings
+	{
+		int32 Columns = 100;
+		int32 Floors = 10;
+		int32 AttachmentsPerColumn = 2;
+		/// Each one is on the roof of its own building.
+		int32 PowerPoles = 0;
+		int32 TrainStations = 0;
+		/// Fraction of the columns that flow downwards.
+		float DownwardFraction = 0.5f;
+		int32 Seed = 0;
+		FVector Origin = FVector(0.0, 0.0, 100000.0);
+		FString SaveName;
+		FSoftClassPath LiftClass;
+		FSoftClassPath PassthroughClass;
+		FSoftClassPath BuildingClass;
+		FSoftClassPath PowerPoleClass;
+		FSoftClassPath WireClass;
+		FSoftClassPath TrainStationClass;
+	};
+
+	static void Generate(UWorld* world, const FSettings& settings);
+
+private:
+	static constexpr double ColumnSpacing = 1200.0;
+	static constexpr double FloorHeight = 800.0;
+	static constexpr double BuildingSpacing = 2000.0;
+	static constexpr double TrainStationSpacing = 4000.0;
+	/// How far the rows of buildings and stations are from the lift columns.
+	static constexpr double AreaSpacing = 5000.0;
+
+	FModBenchmarkSaveGenerator(UWorld* world, const FSettings& settings);
+
+	static bool IsVerticalAttachment(const AFGBuildableConveyorAttachment* attachment);
+	static FVector GetRoofLocation(AFGBuildable* building);
+
+	bool LoadClasses();
+	void BuildColumn(const FVector& base, bool flowsDown);
+	AFGBuildablePassthrough* SpawnPassthrough(const FVector& location);
+	AFGBuildableConveyorAttachment* SpawnAttachment(const FVector& location, bool flowsDown, UFGFactoryConnectionComponent*& out_input, UFGFactoryConnectionComponent*& out_output);
+	void BuildPowerPoles(const FVector& origin);
+	void BuildTrainStations(const FVector& origin);
+	UFGCircuitConnectionComponent* SpawnPowerPole(const FVector& location);
+	void SpawnWire(UFGCircuitConnectionComponent* from, UFGCircuitConnectionComponent* to);
+	AFGBuildableConveyorLift* SpawnLift(const FVector& from, const FVector& to, AFGBuildablePassthrough* fromPassthrough, AFGBuildablePassthrough* toPassthrough, UFGFactoryConnectionComponent* input, UFGFactoryConnectionComponent* output);
+
+	UWorld* World;
+	const FSettings& Settings;
+	FRandomStream Random;
+	AFGBuildableSubsystem* BuildableSubsystem = nullptr;
+
+	UClass* LiftClass = nullptr;
+	UClass* PassthroughClass = nullptr;
+	TArray<UClass*> VerticalAttachmentClasses;
+	UClass* BuildingClass = nullptr;
+	UClass* PowerPoleClass = nullptr;
+	UClass* WireClass = nullptr;
+	UClass* TrainStationClass = nullptr;
+
+	int32 NumLifts = 0;
+	int32 NumPassthroughs = 0;
+	int32 NumAttachments = 0;
+	int32 NumPowerPoles = 0;
+	int32 NumWires = 0;
+	int32 NumTrainStations = 0;
+};
@@ -0,0 +1,63 @@
+#include "ModBenchmarks.h"
+
+#include "Engine/ActorChannel.h"
+#include "Misc/CommandLine.h"
+#include "ModBenchmarkReplication.h"
+#include "ModBenchmarkRun.h"
+#include "Module/GameInstanceModuleManager.h"
+#include "Patching/NativeHookManager.h"
+
+DEFINE_LOG_CATEGORY(LogModBenchmarks)
+
+void FModBenchmarksModule::StartupModule()
+{
+	if (FParse::Param(FCommandLine::Get(), TEXT("ModBenchmark")))
+	{
+		StartBenchmarkRun();
+	}
+	if (FParse::Param(FCommandLine::Get(), TEXT("ModBenchmarkReplication")))
+	{
+		StartReplicationCapture();
+	}
+}
+
+void FModBenchmarksModule::ShutdownModule()
+{
+	Replication.Reset();
+	BenchmarkRun.Reset();
+}
+
+void FModBenchmarksModule::StartBenchmarkRun()
+{
+	BenchmarkRun = MakeUnique<FModBenchmarkRun>();
+
+#if !WITH_EDITOR
+	SUBSCRIBE_UOBJECT_METHOD_AFTER(UGameInstanceModuleManager, DispatchLifecycleEvent,
+		[this](UGameInstanceModuleManager* manager, ELifecyclePhase phase)
+		{
+			if (phase == ELifecyclePhase::POST_INITIALIZATION && BenchmarkRun)
+			{
+				BenchmarkRun->OnPostInitialization();
+			}
+		});
+#endif
+}
+
+void FModBenchmarksModule::StartReplicationCapture()
+{
+	Replication = MakeUnique<FModBenchmarkReplication>();
+
+#if !WITH_EDITOR
+	SUBSCRIBE_METHOD(UActorChannel::ReplicateActor,
+		[this](auto& scope, UActorChannel* channel)
+		{
+			const int64 numBits = scope(channel);
+			if (Replication)
+			{
+				Replication->OnReplicateActor(channel, numBits);
+			}
+		});
+#endif
+}
+
+IMPLEMENT_MODULE(FModBenchmarksModule, ModBenchmarks)
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogModBenchmarks, Log, All)
+
+class FModBenchmarkReplication;
+class FModBenchmarkRun;
+
+class FModBenchmarksModule : public IModuleInterface
+{
+public:
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
+
+private:
+	void StartBenchmarkRun();
+	void StartReplicationCapture();
+
+	TUniquePtr<FModBenchmarkRun> BenchmarkRun;
+	TUniquePtr<FModBenchmarkReplication> Replication;
+};
@@ -0,0 +1,96 @@
+#include "PPOBAttachmentPointCache.h"
+
+#include "Dom/JsonObject.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "PowerPolesOnBuildings.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+FString FPPOBAttachmentPointCache::GetFilePath()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("PowerPolesOnBuildings"), TEXT("AttachmentPointCache.json"));
+}
+
+bool FPPOBAttachmentPointCache::Load()
+{
+	Signature = 0;
+	Offsets.Reset();
+
+	FString json;
+	if (!FFileHelper::LoadFileToString(json, *GetFilePath()))
+		return false;	// Doesn't exist yet.
+
+	TSharedPtr<FJsonObject> root;
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(json), root) || !root.IsValid())
+	{
+		UE_LOG(LogPowerPolesOnBuildings, Warning, TEXT("Failed to parse %s, ignoring it."), *GetFilePath());
+		return false;
+	}
+
+	int32 fileVersion = 0;
+	if (!root->TryGetNumberField(TEXT("Version"), fileVersion) || fileVersion != Version)
+		return false;
+
+	double fileSignature = 0;
+	if (!root->TryGetNumberField(TEXT("Signature"), fileSignature))
+		return false;
+	Signature = static_cast<uint32>(fileSignature);
+
+	const TArray<TSharedPtr<FJsonValue>>* entries = nullptr;
+	if (root->TryGetArrayField(TEXT("Offsets"), entries))
+	{
+		Offsets.Reserve(entries->Num());
+		for (const TSharedPtr<FJsonValue>& value : *entries)
+		{
+			const TSharedPtr<FJsonObject>* entry = nullptr;
+			if (!value->TryGetObject(entry))
+				continue;
+
+			FString classPath;
+			FVector offset;
+			if ((*entry)->TryGetStringField(TEXT("Class"), classPath)
+				&& (*entry)->TryGetNumberField(TEXT("X"), offset.X)
+				&& (*entry)->TryGetNumberField(TEXT("Y"), offset.Y)
+				&& (*entry)->TryGetNumberField(TEXT("Z"), offset.Z))
+			{
+				Offsets.Add(FSoftClassPath(classPath), offset);
+			}
+		}
+	}
+
+	return true;
+}
+
+bool FPPOBAttachmentPointCache::Save() const
+{
+	TArray<TSharedPtr<FJsonValue>> entries;
+	entries.Reserve(Offsets.Num());
+	for (auto&& [classPath, offset] : Offsets)
+	{
+		auto entry = MakeShared<FJsonObject>();
+		entry->SetStringField(TEXT("Class"), classPath.ToString());
+		entry->SetNumberField(TEXT("X"), offset.X);
+		entry->SetNumberField(TEXT("Y"), offset.Y);
+		entry->SetNumberField(TEXT("Z"), offset.Z);
+		entries.Add(MakeShared<FJsonValueObject>(MoveTemp(entry)));
+	}
+
+	auto root = MakeShared<FJsonObject>();
+	root->SetNumberField(TEXT("Version"), Version);
+	root->SetNumberField(TEXT("Signature"), Signature);
+	root->SetArrayField(TEXT("Offsets"), MoveTemp(entries));
+
+	FString json;
+	if (!FJsonSerializer::Serialize(root, TJsonWriterFactory<>::Create(&json)))
+		return false;
+
+	if (!FFileHelper::SaveStringToFile(json, *GetFilePath()))
+	{
+		UE_LOG(LogPowerPolesOnBuildings, Warning, TEXT("Failed to write %s."), *GetFilePath());
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/// On-disk cache of the attachment points that have been automatically discovered for buildings.
+///
+/// Discovering the attachment points means loading every building (and everything that they
+/// reference), which is far too slow to do on every launch. The cache is keyed by a signature of
+/// everything that could affect the result, so we only need to do that again when something changes.
+struct FPPOBAttachmentPointCache
+{
+	/// Bump this whenever the file format or the way that the offsets are calculated changes.
+	static constexpr int32 Version = 1;
+
+	/// Hash of all of the inputs that were used to discover the attachment points.
+	uint32 Signature = 0;
+
+	/// Attachment point offsets, keyed by the decoration template that they were added to.
+	TMap<FSoftClassPath, FVector> Offsets;
+
+	static FString GetFilePath();
+
+	/// Returns false if the cache doesn't exist or was written by a different version.
+	bool Load();
+	bool Save() const;
+};
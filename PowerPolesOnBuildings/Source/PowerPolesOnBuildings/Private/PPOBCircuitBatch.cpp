@@ -0,0 +1,267 @@
+#include "PPOBCircuitBatch.h"
+
+#include "Algo/StableSort.h"
+#include "Buildables/FGBuildablePowerPole.h"
+#include "Buildables/FGBuildableWire.h"
+#include "EngineUtils.h"
+#include "FGBuildableSubsystem.h"
+#include "FGCircuitConnectionComponent.h"
+#include "FGCircuitSubsystem.h"
+#include "HAL/IConsoleManager.h"
+#include "Hologram/FGBlueprintHologram.h"
+#include "PowerPolesOnBuildings.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flush Circuit Batch"), STAT_PPOBFlushCircuitBatch, STATGROUP_PowerPolesOnBuildings);
+
+namespace
+{
+
+TAutoConsoleVariable<bool> CVarBatchCircuitConnections(
+	TEXT("PPOB.BatchCircuitConnections"),
+	true,
+	TEXT("Defer power circuit merges until all of the poles in a blueprint or pole chain have been constructed."));
+
+/// Builds a chain of poles next to an existing pole and wires it up, the same way that a chained wire
+/// or a blueprint would, then removes it again. Returns how long the construction took in seconds.
+double TimeChainConstruction(UWorld* world, AFGBuildablePowerPole* existingPole, UClass* wireClass, int32 poleCount)
+{
+	AFGBuildableSubsystem* buildableSubsystem = AFGBuildableSubsystem::Get(world);
+	const FVector origin = existingPole->GetActorLocation() + FVector(0.0, 0.0, 10000.0);
+
+	TArray<AActor*> children;
+	children.Reserve(2 * poleCount);
+
+	const double startTime = FPlatformTime::Seconds();
+	{
+		FPPOBCircuitBatch batch;
+
+		UFGCircuitConnectionComponent* from = existingPole->FindComponentByClass<UFGCircuitConnectionComponent>();
+		for (int32 i = 0; i < poleCount; ++i)
+		{
+			const FTransform poleTransform(origin + FVector(i * 2000.0, 0.0, 0.0));
+			auto* pole = CastChecked<AFGBuildablePowerPole>(buildableSubsystem->BeginSpawnBuildable(existingPole->GetClass(), poleTransform));
+			pole->FinishSpawning(poleTransform);
+			children.Add(pole);
+
+			UFGCircuitConnectionComponent* to = pole->FindComponentByClass<UFGCircuitConnectionComponent>();
+			const FTransform wireTransform(from->GetComponentLocation());
+			auto* wire = CastChecked<AFGBuildableWire>(buildableSubsystem->BeginSpawnBuildable(wireClass, wireTransform));
+			wire->Connect(from, to);
+			wire->FinishSpawning(wireTransform);
+			children.Add(wire);
+
+			from = to;
+		}
+
+		batch.AddConstructedActors(nullptr, children);
+	}
+	const double elapsed = FPlatformTime::Seconds() - startTime;
+
+	// Wires first, so that the poles don't have anything left to disconnect.
+	for (int32 i = children.Num() - 1; i >= 0; --i)
+	{
+		if (children[i]->IsA<AFGBuildableWire>())
+		{
+			children[i]->Destroy();
+		}
+	}
+	for (AActor* pole : children)
+	{
+		if (IsValid(pole))
+		{
+			pole->Destroy();
+		}
+	}
+
+	return elapsed;
+}
+
+FAutoConsoleCommandWithWorldAndArgs BenchmarkCircuitBatchCommand(
+	TEXT("PPOB.BenchmarkCircuitBatch"),
+	TEXT("Times connecting a chain of [Poles=200] new poles to an existing circuit with and without PPOB.BatchCircuitConnections, [Runs=5] times each. Has to be run on the server."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& args, UWorld* world)
+	{
+		const int32 poleCount = args.Num() > 0 ? FCString::Atoi(*args[0]) : 200;
+		const int32 runCount = args.Num() > 1 ? FCString::Atoi(*args[1]) : 5;
+
+		if (world == nullptr || world->GetNetMode() == NM_Client)
+		{
+			UE_LOG(LogPowerPolesOnBuildings, Error, TEXT("The circuit batch benchmark has to be run on the server."));
+			return;
+		}
+
+		// The biggest circuit is the one that a chain would take the longest to merge in to, so start
+		// from whichever pole has the most wires as a rough stand-in for that.
+		AFGBuildablePowerPole* existingPole = nullptr;
+		int32 mostWires = -1;
+		for (TActorIterator<AFGBuildablePowerPole> it(world); it; ++it)
+		{
+			const UFGCircuitConnectionComponent* connection = it->FindComponentByClass<UFGCircuitConnectionComponent>();
+			if (connection != nullptr && connection->GetNumConnections() > mostWires)
+			{
+				existingPole = *it;
+				mostWires = connection->GetNumConnections();
+			}
+		}
+
+		UClass* wireClass = FSoftClassPath(TEXT("/Game/FactoryGame/Buildable/Factory/PowerLine/Build_PowerLine.Build_PowerLine_C")).TryLoadClass<AFGBuildableWire>();
+		if (existingPole == nullptr || wireClass == nullptr || poleCount <= 0 || runCount <= 0)
+		{
+			UE_LOG(LogPowerPolesOnBuildings, Warning, TEXT("Nothing to benchmark, the save needs at least one power pole."));
+			return;
+		}
+
+		IConsoleVariable* batchVariable = CVarBatchCircuitConnections.AsVariable();
+		const bool wasBatching = CVarBatchCircuitConnections.GetValueOnGameThread();
+
+		// Alternated so that anything that warms up over the runs affects both the same.
+		double unbatchedTime = 0.0;
+		double batchedTime = 0.0;
+		for (int32 run = 0; run < runCount; ++run)
+		{
+			batchVariable->Set(false, ECVF_SetByCode);
+			unbatchedTime += TimeChainConstruction(world, existingPole, wireClass, poleCount);
+			batchVariable->Set(true, ECVF_SetByCode);
+			batchedTime += TimeChainConstruction(world, existingPole, wireClass, poleCount);
+		}
+		batchVariable->Set(wasBatching, ECVF_SetByCode);
+
+		UE_LOG(LogPowerPolesOnBuildings, Display,
+			TEXT("Connecting %i poles to a circuit (%s, %i wires), average of %i runs: unbatched %.3fms, batched %.3fms."),
+			poleCount, *existingPole->GetName(), mostWires, runCount,
+			unbatchedTime * 1000.0 / runCount,
+			batchedTime * 1000.0 / runCount);
+	}));
+
+} // namespace
+
+thread_local FPPOBCircuitBatch* FPPOBCircuitBatch::t_activeBatch = nullptr;
+
+FPPOBCircuitBatch::FPPOBCircuitBatch()
+	: Outer(t_activeBatch)
+	, StartTime(FPlatformTime::Seconds())
+{
+	if (Outer == nullptr && CVarBatchCircuitConnections.GetValueOnGameThread())
+	{
+		t_activeBatch = this;
+	}
+}
+
+FPPOBCircuitBatch::~FPPOBCircuitBatch()
+{
+	if (Outer != nullptr)
+		return;	// The outer batch will deal with everything.
+
+	if (t_activeBatch == this)
+	{
+		t_activeBatch = nullptr;
+		Flush();
+	}
+
+	// Logged whether or not the batching is enabled, so that the two can be compared.
+	UE_LOG(LogPowerPolesOnBuildings, Verbose,
+		TEXT("Constructed %i actors in %.3fms (batched circuit connections: %s)."),
+		ConstructedActors.Num(),
+		(FPlatformTime::Seconds() - StartTime) * 1000.0,
+		CVarBatchCircuitConnections.GetValueOnGameThread() ? TEXT("yes") : TEXT("no"));
+}
+
+void FPPOBCircuitBatch::AddConstructedActors(AActor* result, const TArray<AActor*>& children)
+{
+	FPPOBCircuitBatch* batch = Outer != nullptr ? Outer : this;
+
+	if (result != nullptr)
+	{
+		batch->ConstructedActors.Add(result);
+	}
+	for (const AActor* child : children)
+	{
+		if (child != nullptr)
+		{
+			batch->ConstructedActors.Add(child);
+		}
+	}
+}
+
+bool FPPOBCircuitBatch::TryDeferConnection(AFGCircuitSubsystem* subsystem, UFGCircuitConnectionComponent* first, UFGCircuitConnectionComponent* second)
+{
+	FPPOBCircuitBatch* batch = t_activeBatch;
+	if (LIKELY(batch == nullptr))
+		return false;
+	if (first == nullptr || second == nullptr)
+		return false;
+
+	// Only poles are interesting; anything else is connected straight away in case something relies
+	// on it happening immediately.
+	if (!first->GetOwner()->IsA<AFGBuildablePowerPole>() && !second->GetOwner()->IsA<AFGBuildablePowerPole>())
+		return false;
+
+	batch->PendingConnections.Add(
+	{
+		.subsystem = subsystem,
+		.first = first,
+		.second = second,
+	});
+	return true;
+}
+
+void FPPOBCircuitBatch::DropDeferredConnection(const UFGCircuitConnectionComponent* first, const UFGCircuitConnectionComponent* second)
+{
+	FPPOBCircuitBatch* batch = t_activeBatch;
+	if (LIKELY(batch == nullptr))
+		return;
+
+	batch->PendingConnections.RemoveAll(
+		[first, second](const FPendingConnection& connection)
+		{
+			return (connection.first == first && connection.second == second)
+				|| (connection.first == second && connection.second == first);
+		});
+}
+
+bool FPPOBCircuitBatch::ContainsPowerPoles(const AFGBlueprintHologram* blueprint)
+{
+	return blueprint->mBuildables.ContainsByPredicate(
+		[](const AFGBuildable* buildable) { return buildable != nullptr && buildable->IsA<AFGBuildablePowerPole>(); });
+}
+
+void FPPOBCircuitBatch::Flush()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPOBFlushCircuitBatch);
+
+	if (PendingConnections.IsEmpty())
+		return;
+
+	// Connections between the new actors only ever merge small circuits, so do all of those first and
+	// leave the ones that reach out to the rest of the world until the end. That way the existing
+	// circuits only get merged with the complete set of new poles rather than one pole at a time.
+	Algo::StableSortBy(PendingConnections,
+		[this](const FPendingConnection& connection)
+		{
+			return !(IsConstructed(connection.first.Get()) && IsConstructed(connection.second.Get()));
+		});
+
+	const double startTime = FPlatformTime::Seconds();
+
+	for (const FPendingConnection& connection : PendingConnections)
+	{
+		UFGCircuitConnectionComponent* first = connection.first.Get();
+		UFGCircuitConnectionComponent* second = connection.second.Get();
+		if (first != nullptr && second != nullptr && IsValid(connection.subsystem))
+		{
+			connection.subsystem->ConnectComponents(first, second);
+		}
+	}
+
+	UE_LOG(LogPowerPolesOnBuildings, Verbose,
+		TEXT("Applied %i deferred circuit connections in %.3fms."),
+		PendingConnections.Num(),
+		(FPlatformTime::Seconds() - startTime) * 1000.0);
+
+	PendingConnections.Reset();
+}
+
+bool FPPOBCircuitBatch::IsConstructed(const UFGCircuitConnectionComponent* component) const
+{
+	return component != nullptr && ConstructedActors.Contains(component->GetOwner());
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class AFGBlueprintHologram;
+class AFGCircuitSubsystem;
+class UFGCircuitConnectionComponent;
+
+/// Defers power circuit merges while a batch of poles and wires is being constructed.
+///
+/// Every wire that gets connected merges the circuits on either side of it, and merging into a large
+/// circuit isn't cheap. When lots of poles are built at once, like when pasting a blueprint or placing
+/// a chain of poles, that happens for every single wire even though most of them only connect the new
+/// poles to each other. While a batch is active the connections are held back until everything has
+/// been constructed, then the new poles are connected to each other first so that the existing
+/// circuits only need to absorb them once.
+///
+/// Batches are scoped; nested batches are folded in to the outermost one. Disconnecting two components
+/// while their connection is still held back drops it, since the game disconnects things straight
+/// away (e.g. when re-routing a chained wire) and would otherwise be undone by the deferred connect.
+///
+/// PPOB.BenchmarkCircuitBatch times a chain of poles being connected to an existing circuit with and
+/// without batching, and works headless on a dedicated server.
+class FPPOBCircuitBatch
+{
+public:
+	FPPOBCircuitBatch();
+	~FPPOBCircuitBatch();
+
+	UE_NONCOPYABLE(FPPOBCircuitBatch);
+
+	/// Tells the batch which actors were constructed as part of it.
+	void AddConstructedActors(AActor* result, const TArray<AActor*>& children);
+
+	/// Called from the circuit subsystem hook. Returns true if the connection has been deferred.
+	static bool TryDeferConnection(AFGCircuitSubsystem* subsystem, UFGCircuitConnectionComponent* first, UFGCircuitConnectionComponent* second);
+
+	/// Called from the circuit subsystem hook, forgets any deferred connection between the components.
+	static void DropDeferredConnection(const UFGCircuitConnectionComponent* first, const UFGCircuitConnectionComponent* second);
+
+	/// Whether a blueprint has any power poles in it, since there's nothing to batch otherwise.
+	static bool ContainsPowerPoles(const AFGBlueprintHologram* blueprint);
+
+private:
+	struct FPendingConnection
+	{
+		AFGCircuitSubsystem* subsystem;
+		TWeakObjectPtr<UFGCircuitConnectionComponent> first;
+		TWeakObjectPtr<UFGCircuitConnectionComponent> second;
+	};
+
+	void Flush();
+	bool IsConstructed(const UFGCircuitConnectionComponent* component) const;
+
+	static thread_local FPPOBCircuitBatch* t_activeBatch;
+
+	/// The batch that this one has been folded in to, if it isn't the outermost one.
+	FPPOBCircuitBatch* Outer;
+	double StartTime;
+
+	TArray<FPendingConnection, TInlineAllocator<64>> PendingConnections;
+	TSet<const AActor*, DefaultKeyFuncs<const AActor*>, TInlineSetAllocator<64>> ConstructedActors;
+};
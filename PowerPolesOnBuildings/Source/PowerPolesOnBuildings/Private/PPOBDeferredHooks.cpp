@@ -0,0 +1,8 @@
+#include "PPOBDeferredHooks.h"
+
+#include "PowerPolesOnBuildings.h"
+
+void FPPOBDeferredHooksTraits::LogInstall(const UClass* hologramClass)
+{
+	UE_LOG(LogPowerPolesOnBuildings, Verbose, TEXT("Installing deferred hooks for %s."), *GetNameSafe(hologramClass));
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ModDeferredHooks.h"
+
+/// Where FPPOBDeferredHooks reports what it installs.
+struct FPPOBDeferredHooksTraits
+{
+	static void LogInstall(const UClass* hologramClass);
+};
+
+/// Hooks that PPOB holds back until the holograms that need them turn up, see TModDeferredHooks.
+using FPPOBDeferredHooks = TModDeferredHooks<FPPOBDeferredHooksTraits>;
@@ -1,11 +1,33 @@
 #include "PPOBGameInstanceModule.h"
 
+#include "Algo/Transform.h"
+#include "AssetRegistry/IAssetRegistry.h"
+#include "Buildables/FGBuildableBeam.h"
+#include "Buildables/FGBuildableConveyorBase.h"
+#include "Buildables/FGBuildableFoundation.h"
+#include "Buildables/FGBuildablePillar.h"
+#include "Buildables/FGBuildablePipeBase.h"
+#include "Buildables/FGBuildablePowerPole.h"
+#include "Buildables/FGBuildableRailroadTrack.h"
+#include "Buildables/FGBuildableWall.h"
+#include "Buildables/FGBuildableWire.h"
+#include "Engine/AssetManager.h"
 #include "Engine/SCS_Node.h"
 #include "Engine/SimpleConstructionScript.h"
 #include "FGAttachmentPointComponent.h"
+#include "FGBuildable.h"
+#include "FGClearanceInterface.h"
 #include "FGDecorationTemplate.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/EngineVersion.h"
+#include "ModLoading/ModLoadingLibrary.h"
+#include "ModMemoryTally.h"
 #include "Module/GameInstanceModuleManager.h"
+#include "PowerPolesOnBuildings.h"
+#include "PPOBAttachmentPointCache.h"
+#include "PPOBHitchWatchdog.h"
 #include "PPOBPowerPoleAttachmentPoint.h"
+#include "UObject/UObjectIterator.h"
 
 UPPOBGameInstanceModule* UPPOBGameInstanceModule::Get(UObject* worldContext)
 {
@@ -36,17 +58,45 @@ void UPPOBGameInstanceModule::DispatchLifecycleEvent(ELifecyclePhase phase)
 {
 	if (!WITH_EDITOR && phase == ELifecyclePhase::INITIALIZATION)
 	{
-		// Create attachment points for the buildings.
-		for (auto&& entry : BuildingAttachmentPoints)
+		LLM_SCOPE_BYTAG(PowerPolesOnBuildings);
+
+		// Create attachment points for the buildings. Discovery goes first so that the cached attachment
+		// points are loaded in the same batch as the configured ones.
+		if (AutoDiscoverBuildingAttachmentPoints)
 		{
-			auto* blueprintClass = CastChecked<UBlueprintGeneratedClass>(entry.Key);
-			AddAttachmentPointComponent(blueprintClass, entry.Value);
+			DiscoverBuildingAttachmentPoints();
 		}
+
+		LoadBuildingAttachmentPoints();
 	}
 
 	Super::DispatchLifecycleEvent(phase);
 }
 
+namespace
+{
+
+const TCHAR* AttachmentPointComponentName = TEXT("PPOB_AttachmentPointComponent");
+const TCHAR* AttachmentPointNodeName = TEXT("PPOB_AttachmentPointNode");
+
+FAutoConsoleCommandWithWorldArgsAndOutputDevice MemoryReportCommand(
+	TEXT("PPOB.MemoryReport"),
+	TEXT("Prints the classes, objects and memory that the mod is keeping resident."),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+		[](const TArray<FString>& args, UWorld* world, FOutputDevice& ar)
+		{
+			if (const UPPOBGameInstanceModule* gameInstanceModule = UPPOBGameInstanceModule::Get(world))
+			{
+				gameInstanceModule->DumpMemoryReport(ar);
+			}
+			else
+			{
+				ar.Log(TEXT("The game instance module hasn't been created yet."));
+			}
+		}));
+
+} // namespace
+
 // Adds a UFGAttachmentPointComponent to the given blueprint.
 //
 // We'd usually use the actor mixin system for this, but decorator templates are never actually
@@ -78,20 +128,315 @@ void UPPOBGameInstanceModule::AddAttachmentPointComponent(UBlueprintGeneratedCla
 	}
 
 	TStringBuilder<128> componentName;
-	componentName << "PPOB_AttachmentPointComponent" << USimpleConstructionScript::ComponentTemplateNameSuffix;
+	componentName << AttachmentPointComponentName << USimpleConstructionScript::ComponentTemplateNameSuffix;
 
 	auto* component = NewObject<UFGAttachmentPointComponent>(blueprintClass, FName(componentName), RF_ArchetypeObject);
 	component->SetRelativeLocation_Direct(offset);
 	component->mUsage = attachmentPointUsage;
 	component->mType = attachmentPointType;
 
-	auto* node = NewObject<USCS_Node>(constructionScript, TEXT("PPOB_AttachmentPointNode"));
+	auto* node = NewObject<USCS_Node>(constructionScript, AttachmentPointNodeName);
 	node->ComponentClass = UFGAttachmentPointComponent::StaticClass();
 	node->ComponentTemplate = component;
 
 	constructionScript->AddNode(node);
 }
 
+void UPPOBGameInstanceModule::LoadBuildingAttachmentPoints()
+{
+	TArray<FSoftObjectPath> decoratorPaths;
+	decoratorPaths.Reserve(BuildingAttachmentPoints.Num() + CachedBuildingAttachmentPoints.Num());
+	for (auto&& [decoratorPath, offset] : CachedBuildingAttachmentPoints)
+	{
+		decoratorPaths.Add(decoratorPath);
+	}
+
+	int32 alreadyLoadedCount = 0;
+	for (auto&& [decoratorClass, offset] : BuildingAttachmentPoints)
+	{
+		decoratorPaths.Add(decoratorClass.ToSoftObjectPath());
+		alreadyLoadedCount += decoratorClass.Get() != nullptr ? 1 : 0;
+	}
+
+	// If the root instance was saved before these were soft references, loading it converts the old
+	// hard references but still loads every template up front.
+	if (alreadyLoadedCount > 0 && alreadyLoadedCount == BuildingAttachmentPoints.Num())
+	{
+		UE_LOG(LogPowerPolesOnBuildings, Warning,
+			TEXT("All %i configured decoration templates were already loaded, %s probably needs re-saving in the editor so that it only holds soft references to them."),
+			alreadyLoadedCount, *GetClass()->GetPathName());
+	}
+
+	BuildingAttachmentPointsLoadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		MoveTemp(decoratorPaths),
+		FStreamableDelegate::CreateUObject(this, &UPPOBGameInstanceModule::PatchLoadedBuildingAttachmentPoints));
+
+	if (BuildingAttachmentPointsLoadHandle)
+	{
+		// Patch each building as soon as it arrives rather than waiting for the slowest one.
+		BuildingAttachmentPointsLoadHandle->BindUpdateDelegate(FStreamableUpdateDelegate::CreateWeakLambda(this,
+			[this](TSharedRef<FStreamableHandle>) { PatchLoadedBuildingAttachmentPoints(); }));
+	}
+}
+
+void UPPOBGameInstanceModule::PatchLoadedBuildingAttachmentPoints()
+{
+	LLM_SCOPE_BYTAG(PowerPolesOnBuildings);
+
+	for (auto&& [decoratorClass, offset] : BuildingAttachmentPoints)
+	{
+		auto* blueprintClass = Cast<UBlueprintGeneratedClass>(decoratorClass.Get());
+		if (blueprintClass == nullptr || PatchedBuildingAttachmentPoints.Contains(blueprintClass))
+			continue;	// Not loaded yet, or already done.
+
+		AddAttachmentPointComponent(blueprintClass, offset);
+		PatchedBuildingAttachmentPoints.Add(blueprintClass, offset);
+	}
+
+	for (auto it = CachedBuildingAttachmentPoints.CreateIterator(); it; ++it)
+	{
+		// Only finds it if it's already loaded.
+		if (auto* decoratorClass = Cast<UBlueprintGeneratedClass>(it->Key.ResolveClass()))
+		{
+			AddDiscoveredAttachmentPoint(decoratorClass, it->Value);
+			it.RemoveCurrent();
+		}
+	}
+
+	if (BuildingAttachmentPointsLoadHandle && BuildingAttachmentPointsLoadHandle->HasLoadCompleted())
+	{
+		// Anything that still isn't there has been renamed or removed, or belongs to a mod that isn't
+		// installed.
+		for (auto&& [decoratorClass, offset] : BuildingAttachmentPoints)
+		{
+			if (decoratorClass.Get() == nullptr)
+			{
+				UE_LOG(LogPowerPolesOnBuildings, Warning, TEXT("Couldn't load the configured decoration template %s."), *decoratorClass.ToString());
+			}
+		}
+
+		for (auto&& [decoratorPath, offset] : CachedBuildingAttachmentPoints)
+		{
+			UE_LOG(LogPowerPolesOnBuildings, Warning, TEXT("Couldn't load the cached decoration template %s."), *decoratorPath.ToString());
+		}
+		CachedBuildingAttachmentPoints.Empty();
+
+		UE_LOG(LogPowerPolesOnBuildings, Log, TEXT("Added %i configured and %i discovered building attachment points."),
+			PatchedBuildingAttachmentPoints.Num(), DiscoveredBuildingAttachmentPoints.Num());
+		BuildingAttachmentPointsLoadHandle.Reset();
+	}
+}
+
+void UPPOBGameInstanceModule::FinishLoadingBuildingAttachmentPoints()
+{
+	if (LIKELY(BuildingAttachmentPointsLoadHandle == nullptr))
+		return;
+
+	const FPPOBHitchWatchdog::FScope watchdogScope(FPPOBHitchWatchdog::EHook::AttachmentPointLoading);
+
+	BuildingAttachmentPointsLoadHandle->WaitUntilComplete();
+	PatchLoadedBuildingAttachmentPoints();
+}
+
+namespace
+{
+
+/// Finds the paths of all subclasses of the given class, apart from those under the excluded classes,
+/// without loading any of them.
+TArray<FSoftObjectPath> GetDerivedClassPaths(const UClass* rootClass, TConstArrayView<const UClass*> excludedClasses)
+{
+	TArray<FSoftObjectPath> softPaths;
+	{
+		TSet<FTopLevelAssetPath> excludedClassNames;
+		for (const UClass* excludedClass : excludedClasses)
+		{
+			excludedClassNames.Add(excludedClass->GetClassPathName());
+		}
+
+		TSet<FTopLevelAssetPath> classNames;
+		IAssetRegistry::Get()->GetDerivedClassNames({rootClass->GetClassPathName()}, excludedClassNames, classNames);
+		softPaths.Reserve(classNames.Num());
+		Algo::Transform(classNames, softPaths,
+			[](auto&& name) { return FSoftObjectPath(Forward<decltype(name)>(name)); });
+	}
+
+	// The asset registry doesn't guarantee any particular order, but the cache signature needs one.
+	softPaths.Sort([](const FSoftObjectPath& a, const FSoftObjectPath& b) { return a.LexicalLess(b); });
+	return softPaths;
+}
+
+/// Calculates an attachment point offset for the middle of the building's roof.
+TOptional<FVector> CalculateRoofOffset(AFGBuildable* buildable)
+{
+	// The clearance boxes are authored to wrap the building's meshes, and unlike the meshes they're
+	// available from the CDO without having to instantiate any components.
+	TArray<FFGClearanceData> clearanceData;
+	IFGClearanceInterface::Execute_GetClearanceData(buildable, clearanceData);
+
+	FBox bounds(ForceInit);
+	for (const FFGClearanceData& clearance : clearanceData)
+	{
+		bounds += clearance.ClearanceBox.TransformBy(clearance.RelativeTransform);
+	}
+
+	if (!bounds.IsValid)
+		return {};
+
+	const FVector center = bounds.GetCenter();
+	return FVector(center.X, center.Y, bounds.Max.Z);
+}
+
+} // namespace
+
+// Adds attachment points to buildings that haven't been configured in BuildingAttachmentPoints.
+//
+// Working out where the attachment point should go means loading the building, which gets very slow
+// when there are lots of modded buildings, so the results are cached on disk. As long as the cache
+// is up to date we only need to load the decoration templates that we're patching.
+void UPPOBGameInstanceModule::DiscoverBuildingAttachmentPoints()
+{
+	// Every kind of buildable is checked, apart from the ones that are nothing like a building with a
+	// roof: the things that poles would be connecting buildings with, and the structural pieces that
+	// poles can already be built on.
+	const UClass* const excludedClasses[] =
+	{
+		AFGBuildableConveyorBase::StaticClass(),
+		AFGBuildablePipeBase::StaticClass(),
+		AFGBuildableRailroadTrack::StaticClass(),
+		AFGBuildableWire::StaticClass(),
+		AFGBuildablePowerPole::StaticClass(),
+		AFGBuildableFoundation::StaticClass(),
+		AFGBuildableWall::StaticClass(),
+		AFGBuildableBeam::StaticClass(),
+		AFGBuildablePillar::StaticClass(),
+	};
+
+	// This only reads from the asset registry so it's cheap enough to do every time, and it's how we
+	// notice that buildings have been added or removed since the cache was written.
+	TArray<FSoftObjectPath> buildableClasses = GetDerivedClassPaths(AFGBuildable::StaticClass(), excludedClasses);
+	const uint32 cacheSignature = CalculateAttachmentPointCacheSignature(buildableClasses);
+
+	FPPOBAttachmentPointCache cache;
+	if (cache.Load() && cache.Signature == cacheSignature)
+	{
+		// Loaded in the background by LoadBuildingAttachmentPoints, so startup doesn't grow with the
+		// number of buildings.
+		UE_LOG(LogPowerPolesOnBuildings, Log, TEXT("Using %i cached building attachment points."), cache.Offsets.Num());
+		CachedBuildingAttachmentPoints = MoveTemp(cache.Offsets);
+		return;
+	}
+
+	UE_LOG(LogPowerPolesOnBuildings, Log,
+		TEXT("Building attachment point cache is missing or out of date, checking %i buildables."),
+		buildableClasses.Num());
+
+	if (TSharedPtr<FStreamableHandle> loadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(MoveTemp(buildableClasses)))
+	{
+		if (loadHandle->HasLoadCompleted())
+		{
+			FinishBuildingAttachmentPointDiscovery(loadHandle.Get(), cacheSignature);
+		}
+		else
+		{
+			loadHandle->BindCompleteDelegate(FStreamableDelegate::CreateUObject(
+				this,
+				&UPPOBGameInstanceModule::FinishBuildingAttachmentPointDiscovery,
+				const_cast<const FStreamableHandle*>(loadHandle.Get()),
+				cacheSignature));
+		}
+	}
+}
+
+void UPPOBGameInstanceModule::FinishBuildingAttachmentPointDiscovery(const FStreamableHandle* loadRequest, uint32 cacheSignature)
+{
+	LLM_SCOPE_BYTAG(PowerPolesOnBuildings);
+	const FPPOBHitchWatchdog::FScope watchdogScope(FPPOBHitchWatchdog::EHook::AttachmentPointDiscovery);
+
+	FPPOBAttachmentPointCache cache;
+	cache.Signature = cacheSignature;
+
+	loadRequest->ForEachLoadedAsset([&](UObject* asset)
+	{
+		auto* buildableClass = Cast<UClass>(asset);
+		if (buildableClass == nullptr)
+			return;
+		auto* buildable = Cast<AFGBuildable>(buildableClass->GetDefaultObject());
+		if (buildable == nullptr)
+			return;
+
+		// Attachment points are found through the decoration template, so there's nothing that we can do
+		// for buildings that don't have one.
+		auto* decoratorClass = Cast<UBlueprintGeneratedClass>(buildable->mDecoratorClass.Get());
+		if (decoratorClass == nullptr)
+		{
+			UE_LOG(LogPowerPolesOnBuildings, Verbose,
+				TEXT("Skipping %s because it doesn't have a decoration template."),
+				*buildableClass->GetName());
+			return;
+		}
+
+		// Hand-picked offsets always take priority.
+		if (BuildingAttachmentPoints.Contains(TSoftClassPtr<AFGDecorationTemplate>(decoratorClass)) || cache.Offsets.Contains(FSoftClassPath(decoratorClass)))
+			return;
+
+		const TOptional<FVector> offset = CalculateRoofOffset(buildable);
+		if (!offset.IsSet())
+		{
+			UE_LOG(LogPowerPolesOnBuildings, Log,
+				TEXT("Skipping %s because it doesn't have any clearance data to find the roof from."),
+				*buildableClass->GetName());
+			return;
+		}
+
+		UE_LOG(LogPowerPolesOnBuildings, Verbose,
+			TEXT("Adding an attachment point to %s at %s."),
+			*buildableClass->GetName(), *offset->ToCompactString());
+
+		cache.Offsets.Add(FSoftClassPath(decoratorClass), *offset);
+		AddDiscoveredAttachmentPoint(decoratorClass, *offset);
+	});
+
+	UE_LOG(LogPowerPolesOnBuildings, Log, TEXT("Discovered %i building attachment points."), cache.Offsets.Num());
+	cache.Save();
+}
+
+void UPPOBGameInstanceModule::AddDiscoveredAttachmentPoint(UBlueprintGeneratedClass* decoratorClass, const FVector& offset)
+{
+	AddAttachmentPointComponent(decoratorClass, offset);
+	DiscoveredBuildingAttachmentPoints.Add(decoratorClass, offset);
+}
+
+// Hashes everything that could change the result of the attachment point discovery.
+//
+// This needs to be stable between launches, so it only hashes strings and not things like FNames.
+uint32 UPPOBGameInstanceModule::CalculateAttachmentPointCacheSignature(const TArray<FSoftObjectPath>& buildableClasses) const
+{
+	uint32 signature = GetTypeHash(FPPOBAttachmentPointCache::Version);
+	signature = HashCombine(signature, GetTypeHash(FEngineVersion::Current().ToString()));
+
+	for (const FSoftObjectPath& buildableClass : buildableClasses)
+	{
+		signature = HashCombine(signature, GetTypeHash(buildableClass.ToString()));
+	}
+
+	for (auto&& entry : BuildingAttachmentPoints)
+	{
+		signature = HashCombine(signature, GetTypeHash(entry.Key.ToString()));
+	}
+
+	// Mods can change their buildings without adding or removing any classes.
+	if (auto* modLoadingLibrary = GEngine->GetEngineSubsystem<UModLoadingLibrary>())
+	{
+		for (const FModInfo& mod : modLoadingLibrary->GetLoadedMods())
+		{
+			signature = HashCombine(signature, GetTypeHash(mod.Name));
+			signature = HashCombine(signature, GetTypeHash(mod.Version.ToString()));
+		}
+	}
+
+	return signature;
+}
+
 FFGAttachmentPoint UPPOBGameInstanceModule::CreatePowerPoleAttachmentPoint(AActor* owner) const
 {
 	FFGAttachmentPoint result;
@@ -100,3 +445,82 @@ FFGAttachmentPoint UPPOBGameInstanceModule::CreatePowerPoleAttachmentPoint(AActo
 	result.Owner = owner;
 	return result;
 }
+
+TOptional<FVector> UPPOBGameInstanceModule::FindBuildingAttachmentPoint(const AFGBuildable* buildable) const
+{
+	if (buildable == nullptr)
+		return {};
+
+	const TSubclassOf<AFGDecorationTemplate> decoratorClass = buildable->mDecoratorClass;
+	if (decoratorClass == nullptr)
+		return {};
+
+	if (const FVector* offset = PatchedBuildingAttachmentPoints.Find(decoratorClass))
+		return *offset;
+	if (const FVector* offset = DiscoveredBuildingAttachmentPoints.Find(decoratorClass))
+		return *offset;
+
+	return {};
+}
+
+void UPPOBGameInstanceModule::DumpMemoryReport(FOutputDevice& ar) const
+{
+	FModMemoryTally nativeTally;
+	FModMemoryTally contentTally;
+	FModMemoryTally attachmentPointTally;
+	FModMemoryTally decoratorTally;
+
+	for (TObjectIterator<UObject> it; it; ++it)
+	{
+		const UObject* object = *it;
+		const FString packageName = object->GetPackage()->GetName();
+
+		if (packageName.StartsWith(TEXT("/Script/PowerPolesOnBuildings")))
+		{
+			nativeTally.Add(object);
+		}
+		else if (packageName.StartsWith(TEXT("/PowerPolesOnBuildings/")))
+		{
+			contentTally.Add(object);
+		}
+		else if (object->IsA<USCS_Node>() || object->IsA<UFGAttachmentPointComponent>())
+		{
+			// The nodes and templates from AddAttachmentPointComponent live in the patched blueprints.
+			if (object->GetName().StartsWith(AttachmentPointComponentName) || object->GetName().StartsWith(AttachmentPointNodeName))
+			{
+				attachmentPointTally.Add(object);
+			}
+		}
+	}
+
+	// The patched decoration templates belong to the game, but they're only kept loaded because we
+	// reference them.
+	for (auto&& [decoratorClass, offset] : PatchedBuildingAttachmentPoints)
+	{
+		if (decoratorClass != nullptr)
+		{
+			decoratorTally.Add(decoratorClass);
+		}
+	}
+	for (auto&& [decoratorClass, offset] : DiscoveredBuildingAttachmentPoints)
+	{
+		if (decoratorClass != nullptr)
+		{
+			decoratorTally.Add(decoratorClass);
+		}
+	}
+
+	const SIZE_T mapBytes = BuildingAttachmentPoints.GetAllocatedSize() + DiscoveredBuildingAttachmentPoints.GetAllocatedSize()
+		+ PatchedBuildingAttachmentPoints.GetAllocatedSize() + CachedBuildingAttachmentPoints.GetAllocatedSize();
+	const int32 mapEntries = BuildingAttachmentPoints.Num() + DiscoveredBuildingAttachmentPoints.Num()
+		+ PatchedBuildingAttachmentPoints.Num() + CachedBuildingAttachmentPoints.Num();
+
+	ar.Log(TEXT("PowerPolesOnBuildings memory:"));
+	nativeTally.Print(ar, TEXT("Native classes"));
+	contentTally.Print(ar, TEXT("Content"));
+	decoratorTally.Print(ar, TEXT("Patched decoration templates"));
+	attachmentPointTally.Print(ar, TEXT("Added attachment points"));
+	FModMemoryTally::PrintEntries(ar, TEXT("Attachment point maps"), mapEntries, mapBytes);
+
+	FModMemoryTally::PrintLLMTag(ar, TEXT("PowerPolesOnBuildings"));
+}
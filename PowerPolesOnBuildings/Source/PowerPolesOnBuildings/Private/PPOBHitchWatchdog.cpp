@@ -0,0 +1,30 @@
+#include "PPOBHitchWatchdog.h"
+
+#include "HAL/IConsoleManager.h"
+#include "PowerPolesOnBuildings.h"
+
+const TCHAR* const FPPOBHitchWatchdogTraits::HookNames[] =
+{
+	TEXT("Power pole BeginPlay"),
+	TEXT("Wire TrySnapToActor"),
+	TEXT("Wire Construct"),
+	TEXT("Blueprint Construct"),
+	TEXT("Attachment point loading"),
+	TEXT("Attachment point discovery"),
+};
+static_assert(UE_ARRAY_COUNT(FPPOBHitchWatchdogTraits::HookNames) == static_cast<int32>(FPPOBHitchWatchdogTraits::EHook::Count));
+
+void FPPOBHitchWatchdogTraits::LogHitch(const FString& message)
+{
+	UE_LOG(LogPowerPolesOnBuildings, Warning, TEXT("%s"), *message);
+}
+
+namespace
+{
+
+FAutoConsoleCommandWithOutputDevice HitchReportCommand(
+	TEXT("PPOB.HitchReport"),
+	TEXT("Prints how long the last few frames took and which of our hooks ran in them, see PPOB.HitchBudgetMs."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateStatic(&FPPOBHitchWatchdog::DumpRecentFrames));
+
+} // namespace
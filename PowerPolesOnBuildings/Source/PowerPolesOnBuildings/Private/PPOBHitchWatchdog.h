@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ModHitchWatchdog.h"
+
+/// The hooks that FPPOBHitchWatchdog times, and where it reports them.
+struct FPPOBHitchWatchdogTraits
+{
+	enum class EHook : uint8
+	{
+		PowerPoleBeginPlay,
+		WireTrySnapToActor,
+		WireConstruct,
+		BlueprintConstruct,
+		AttachmentPointLoading,
+		AttachmentPointDiscovery,
+		Count
+	};
+
+	static constexpr const TCHAR* BudgetVariableName = TEXT("PPOB.HitchBudgetMs");
+	/// Indexed by EHook.
+	static const TCHAR* const HookNames[];
+
+	static void LogHitch(const FString& message);
+};
+
+/// Logs the time spent in our hooks during any game thread frame that takes longer than
+/// PPOB.HitchBudgetMs, so that a long frame while wiring poles or loading a save can be put down to us
+/// or to something else.
+///
+/// Hooks are timed with an FScope on the game thread, including the game's function when the hook
+/// wraps it. The last few frames are kept in a fixed ring for PPOB.HitchReport, so nothing is
+/// allocated unless a frame actually goes over.
+using FPPOBHitchWatchdog = TModHitchWatchdog<FPPOBHitchWatchdogTraits>;
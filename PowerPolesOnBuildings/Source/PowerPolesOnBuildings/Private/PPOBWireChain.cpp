@@ -0,0 +1,347 @@
+#include "PPOBWireChain.h"
+
+#include "Algo/AnyOf.h"
+#include "Buildables/FGBuildablePowerPole.h"
+#include "Buildables/FGBuildableWire.h"
+#include "FGBuildableSubsystem.h"
+#include "FGCircuitConnectionComponent.h"
+#include "FGConstructDisqualifier.h"
+#include "Hologram/FGPowerPoleHologram.h"
+#include "Hologram/FGWireHologram.h"
+#include "PPOBBuildModes.h"
+#include "PowerPolesOnBuildings.h"
+#include "PPOBGameInstanceModule.h"
+
+namespace
+{
+
+/// Tag used to tell our poles apart from the wire's own children.
+const FName ChainedPoleTag(TEXT("PPOB_ChainedPole"));
+
+/// Buildings this close to either end of the wire are treated as being the end itself.
+constexpr double MinimumPoleSpacing = 100.0;
+
+/// Attachment points are treated as occupied when there's an existing pole this close to them.
+constexpr double OccupiedTolerance = 50.0;
+
+/// The overlap query is reused while both ends of the wire stay within the same cells of this size.
+constexpr double OverlapCacheCellSize = 200.0;
+
+FIntVector GetOverlapCacheCell(const FVector& location)
+{
+	return FIntVector(
+		FMath::FloorToInt(location.X / OverlapCacheCellSize),
+		FMath::FloorToInt(location.Y / OverlapCacheCellSize),
+		FMath::FloorToInt(location.Z / OverlapCacheCellSize));
+}
+
+} // namespace
+
+FPPOBWireChain::FOverlapCache FPPOBWireChain::OverlapCache;
+
+void FPPOBWireChain::Update(AFGWireHologram* wire, AFGBuildable* endBuilding)
+{
+	// The chained poles are child holograms, so they're the bulk of what this mod allocates at runtime.
+	LLM_SCOPE_BYTAG(PowerPolesOnBuildings);
+
+	AFGPowerPoleHologram* endPole = wire->mPowerPole;
+	const UFGCircuitConnectionComponent* startConnection = wire->mConnections[0];
+
+	if (endBuilding == nullptr
+		|| startConnection == nullptr
+		|| !IsValid(endPole)
+		|| !wire->IsCurrentBuildMode(UPPOBChainedWireBuildMode::StaticClass()))
+	{
+		Clear(wire);
+		return;
+	}
+
+	// Poles stand on the attachment points, so the line between the bases of the two end poles goes
+	// across the roofs of the buildings in between.
+	const AActor* startActor = startConnection->GetOwner();
+	const FVector start = startActor->GetActorLocation();
+	const FVector end = endPole->GetActorLocation();
+
+	FChainLinks links;
+	FindChainLinks(wire, start, end, startActor, endBuilding, links);
+
+	FChainPoles poles;
+	GetChainedPoles(wire, poles);
+
+	// Reuse the poles that we already have where possible, spawning a new child hologram for every
+	// pole is far too expensive to do each frame.
+	while (poles.Num() > links.Num())
+	{
+		AFGPowerPoleHologram* pole = poles.Pop(false);
+		wire->mChildren.Remove(pole);
+		pole->Destroy();
+	}
+	for (int32 i = poles.Num(); i < links.Num(); ++i)
+	{
+		TStringBuilder<64> name;
+		name << ChainedPoleTag << TEXT("_") << i;
+
+		auto* pole = Cast<AFGPowerPoleHologram>(AFGHologram::SpawnChildHologramFromRecipe(
+			wire, FName(name), endPole->GetRecipe(), wire->GetOwner(), links[i].location));
+		if (pole == nullptr)
+			break;
+
+		pole->Tags.Add(ChainedPoleTag);
+		poles.Add(pole);
+	}
+
+	// Use the same snapping logic as the automatic pole so that they end up in exactly the same place
+	// that they would if they were placed by hand.
+	for (int32 i = 0; i < poles.Num(); ++i)
+	{
+		AFGPowerPoleHologram* pole = poles[i];
+		const FChainLink& link = links[i];
+
+		pole->SetActorRotation(endPole->GetActorQuat());
+		const FHitResult hitResult(link.building, nullptr, link.location, FVector::UpVector);
+		if (!pole->TrySnapToActor(hitResult))
+		{
+			pole->SetActorLocation(link.location);
+		}
+	}
+}
+
+void FPPOBWireChain::Clear(AFGWireHologram* wire)
+{
+	FChainPoles poles;
+	GetChainedPoles(wire, poles);
+
+	for (AFGPowerPoleHologram* pole : poles)
+	{
+		wire->mChildren.Remove(pole);
+		pole->Destroy();
+	}
+}
+
+void FPPOBWireChain::AllowLongChain(AFGWireHologram* wire)
+{
+	if (!wire->mConstructDisqualifiers.Contains(UFGCDWireTooLong::StaticClass()))
+		return;	// Nothing to allow.
+
+	const UFGCircuitConnectionComponent* startConnection = wire->mConnections[0];
+	const AFGPowerPoleHologram* endPole = wire->mPowerPole;
+	if (startConnection == nullptr || !IsValid(endPole))
+		return;
+
+	// Found without the tag, which isn't sent with the construct message, so that the server makes
+	// the same decision as the client. The automatic pole is the only other pole that the wire has.
+	TArray<FVector, TInlineAllocator<34>> points;
+	for (AFGHologram* child : wire->mChildren)
+	{
+		if (child != endPole && child != nullptr && child->IsA<AFGPowerPoleHologram>())
+		{
+			points.Add(child->GetActorLocation());
+		}
+	}
+	if (points.IsEmpty())
+		return;	// Just a wire that's too long.
+
+	const FVector start = startConnection->GetOwner()->GetActorLocation();
+	points.Sort([&start](const FVector& a, const FVector& b) { return FVector::DistSquared(start, a) < FVector::DistSquared(start, b); });
+	points.Insert(start, 0);
+	points.Add(endPole->GetActorLocation());
+
+	// Each gap gets its own wire once everything has been built.
+	for (int32 i = 1; i < points.Num(); ++i)
+	{
+		if (FVector::Dist(points[i - 1], points[i]) > wire->mMaxLength)
+			return;	// Still too long for one wire.
+	}
+
+	wire->mConstructDisqualifiers.Remove(UFGCDWireTooLong::StaticClass());
+}
+
+void FPPOBWireChain::ConnectConstructedPoles(AFGWireHologram* wire, AActor* constructedWire, const TArray<AActor*>& constructedChildren)
+{
+	auto* mainWire = Cast<AFGBuildableWire>(constructedWire);
+	if (mainWire == nullptr)
+		return;
+
+	UFGCircuitConnectionComponent* start = mainWire->GetConnection(0);
+	UFGCircuitConnectionComponent* end = mainWire->GetConnection(1);
+	if (start == nullptr || end == nullptr)
+		return;
+
+	// The construct message doesn't tell us which children were chained poles, but the wire only has
+	// one automatic pole and that's already connected, so any other poles must be ours.
+	struct FConstructedLink { double distanceSquared; UFGCircuitConnectionComponent* connection; };
+	TArray<FConstructedLink, TInlineAllocator<32>> chain;
+	{
+		const FVector startLocation = start->GetComponentLocation();
+		for (AActor* child : constructedChildren)
+		{
+			if (child == nullptr || !child->IsA<AFGBuildablePowerPole>())
+				continue;
+			if (child == start->GetOwner() || child == end->GetOwner())
+				continue;
+			if (UFGCircuitConnectionComponent* connection = GetPoleConnection(child))
+			{
+				chain.Add(
+				{
+					.distanceSquared = FVector::DistSquared(startLocation, connection->GetComponentLocation()),
+					.connection = connection,
+				});
+			}
+		}
+	}
+
+	if (chain.IsEmpty())
+		return;	// Not a chained placement.
+
+	chain.Sort([](const FConstructedLink& a, const FConstructedLink& b) { return a.distanceSquared < b.distanceSquared; });
+
+	// The constructed wire becomes the last link in the chain, and new wires are spawned for the rest.
+	mainWire->Disconnect();
+	mainWire->Connect(chain.Last().connection, end);
+
+	AFGBuildableSubsystem* buildableSubsystem = AFGBuildableSubsystem::Get(mainWire);
+	UFGCircuitConnectionComponent* from = start;
+
+	for (int32 i = 0; i < chain.Num(); ++i)
+	{
+		UFGCircuitConnectionComponent* to = chain[i].connection;
+
+		const FTransform transform(from->GetComponentLocation());
+		if (auto* segment = Cast<AFGBuildableWire>(buildableSubsystem->BeginSpawnBuildable(mainWire->GetClass(), transform)))
+		{
+			segment->SetBuiltWithRecipe(mainWire->GetBuiltWithRecipe());
+			segment->Connect(from, to);
+			segment->FinishSpawning(transform);
+		}
+
+		from = to;
+	}
+}
+
+void FPPOBWireChain::FindChainLinks(const AFGWireHologram* wire, const FVector& start, const FVector& end, const AActor* startActor, const AActor* endActor, FChainLinks& out_links)
+{
+	const UPPOBGameInstanceModule* gameInstanceModule = UPPOBGameInstanceModule::Get(const_cast<AFGWireHologram*>(wire));
+	if (gameInstanceModule == nullptr)
+		return;
+
+	const FVector segment = end - start;
+	const double length = segment.Size();
+	if (length <= 2 * MinimumPoleSpacing)
+		return;	// No room for anything in between.
+
+	const FVector direction = segment / length;
+	const float radius = gameInstanceModule->GetChainSearchRadius();
+
+	const FOverlapCache& nearby = FindNearbyBuildings(wire, start, end, radius);
+
+	TArray<FVector, TInlineAllocator<8>> existingPoles;
+	for (const TWeakObjectPtr<AFGBuildable>& pole : nearby.existingPoles)
+	{
+		if (pole.IsValid() && pole.Get() != startActor && pole.Get() != endActor)
+		{
+			existingPoles.Add(pole->GetActorLocation());
+		}
+	}
+
+	for (const TWeakObjectPtr<AFGBuildable>& weakBuilding : nearby.buildings)
+	{
+		AFGBuildable* building = weakBuilding.Get();
+		if (building == nullptr || building == startActor || building == endActor)
+			continue;	// Gone, or one of the ends.
+
+		const TOptional<FVector> offset = gameInstanceModule->FindBuildingAttachmentPoint(building);
+		if (!offset.IsSet())
+			continue;	// Not a building that we can put poles on.
+
+		const FVector location = building->GetActorTransform().TransformPosition(*offset);
+		if (FMath::PointDistToSegment(location, start, end) > radius)
+			continue;	// Too far off to the side.
+
+		const double distance = FVector::DotProduct(location - start, direction);
+		if (distance < MinimumPoleSpacing || distance > length - MinimumPoleSpacing)
+			continue;	// This is one of the ends.
+
+		const bool occupied = Algo::AnyOf(existingPoles,
+			[&](const FVector& pole) { return FVector::DistSquared(pole, location) < FMath::Square(OccupiedTolerance); });
+		if (occupied)
+			continue;	// There's already a pole here.
+
+		out_links.Add(
+		{
+			.building = building,
+			.location = location,
+			.distance = distance,
+		});
+	}
+
+	out_links.Sort([](const FChainLink& a, const FChainLink& b) { return a.distance < b.distance; });
+
+	const int32 maxPoles = gameInstanceModule->GetMaxChainedPoles();
+	if (out_links.Num() > maxPoles)
+	{
+		out_links.SetNum(maxPoles, false);
+	}
+}
+
+const FPPOBWireChain::FOverlapCache& FPPOBWireChain::FindNearbyBuildings(const AFGWireHologram* wire, const FVector& start, const FVector& end, float radius)
+{
+	const FIntVector startCell = GetOverlapCacheCell(start);
+	const FIntVector endCell = GetOverlapCacheCell(end);
+	if (OverlapCache.wire == wire && OverlapCache.startCell == startCell && OverlapCache.endCell == endCell && OverlapCache.radius == radius)
+		return OverlapCache;
+
+	OverlapCache.wire = wire;
+	OverlapCache.startCell = startCell;
+	OverlapCache.endCell = endCell;
+	OverlapCache.radius = radius;
+	OverlapCache.buildings.Reset();
+	OverlapCache.existingPoles.Reset();
+
+	// Padded so that it still covers the line from anywhere else in the same cells. The ends aren't
+	// ignored here because they change within a cell; FindChainLinks skips them instead.
+	const double padding = OverlapCacheCellSize * UE_SQRT_3;
+	const FVector segment = end - start;
+	const double length = segment.Size();
+
+	TArray<FOverlapResult> overlaps;
+	wire->GetWorld()->OverlapMultiByObjectType(
+		overlaps,
+		start + 0.5 * segment,
+		FRotationMatrix::MakeFromZ(segment / length).ToQuat(),
+		FCollisionObjectQueryParams(FCollisionObjectQueryParams::AllStaticObjects),
+		FCollisionShape::MakeCapsule(radius + padding, 0.5 * length + radius + padding),
+		FCollisionQueryParams(SCENE_QUERY_STAT(PPOBWireChain), false));
+
+	// Buildings with several components turn up once for each of them.
+	TSet<AFGBuildable*, DefaultKeyFuncs<AFGBuildable*>, TInlineSetAllocator<32>> buildings;
+	for (const FOverlapResult& overlap : overlaps)
+	{
+		if (auto* building = Cast<AFGBuildable>(overlap.GetActor()))
+		{
+			buildings.Add(building);
+		}
+	}
+
+	for (AFGBuildable* building : buildings)
+	{
+		(building->IsA<AFGBuildablePowerPole>() ? OverlapCache.existingPoles : OverlapCache.buildings).Add(building);
+	}
+
+	return OverlapCache;
+}
+
+void FPPOBWireChain::GetChainedPoles(const AFGWireHologram* wire, FChainPoles& out_poles)
+{
+	for (AFGHologram* child : wire->mChildren)
+	{
+		if (auto* pole = Cast<AFGPowerPoleHologram>(child); pole != nullptr && pole->ActorHasTag(ChainedPoleTag))
+		{
+			out_poles.Add(pole);
+		}
+	}
+}
+
+UFGCircuitConnectionComponent* FPPOBWireChain::GetPoleConnection(const AActor* pole)
+{
+	return pole->FindComponentByClass<UFGCircuitConnectionComponent>();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class AFGBuildable;
+class AFGPowerPoleHologram;
+class AFGWireHologram;
+class UFGCircuitConnectionComponent;
+
+/// Places extra power poles on the buildings between the two ends of a wire when the wire hologram
+/// is in the chained build mode, so that a whole row of buildings can be powered in one placement.
+///
+/// The extra poles are child holograms of the wire, which means that they're previewed, paid for and
+/// sent to the server in the same construct message as the wire. The wire hologram itself still goes
+/// straight from one end to the other, and that's fine because the poles sit on that line anyway, so
+/// the cost of the cable doesn't change. Once everything has been built on the server, the wire is
+/// split up so that it goes through each of the new poles, so the chain can be longer than a single
+/// wire as long as each gap between the poles isn't.
+///
+/// The buildings along the wire are found with an overlap query, which is kept while both ends of the
+/// wire stay in the same cells, so that it doesn't run every frame while the cursor is held still or
+/// moved across a roof.
+class FPPOBWireChain
+{
+public:
+	/// Updates the chained poles after the wire has tried to snap its automatic pole to a building.
+	/// endBuilding is the building that the automatic pole was snapped to, or null if it wasn't.
+	static void Update(AFGWireHologram* wire, AFGBuildable* endBuilding);
+
+	/// Removes all of the chained poles from the wire.
+	static void Clear(AFGWireHologram* wire);
+
+	/// Lets the wire be placed when it's too long for one wire but the gaps between the chained poles
+	/// aren't. Called after the wire has checked its placement.
+	static void AllowLongChain(AFGWireHologram* wire);
+
+	/// Re-routes the constructed wire through all of the constructed chained poles.
+	static void ConnectConstructedPoles(AFGWireHologram* wire, AActor* constructedWire, const TArray<AActor*>& constructedChildren);
+
+private:
+	struct FChainLink
+	{
+		AFGBuildable* building;
+		FVector location;
+		double distance;
+	};
+
+	using FChainLinks = TArray<FChainLink, TInlineAllocator<32>>;
+	using FChainPoles = TArray<AFGPowerPoleHologram*, TInlineAllocator<32>>;
+
+	/// What the last overlap query found around the wire.
+	struct FOverlapCache
+	{
+		TWeakObjectPtr<const AFGWireHologram> wire;
+		FIntVector startCell;
+		FIntVector endCell;
+		float radius = 0.0f;
+		TArray<TWeakObjectPtr<AFGBuildable>> buildings;
+		TArray<TWeakObjectPtr<AFGBuildable>> existingPoles;
+	};
+
+	static void FindChainLinks(const AFGWireHologram* wire, const FVector& start, const FVector& end, const AActor* startActor, const AActor* endActor, FChainLinks& out_links);
+	static void GetChainedPoles(const AFGWireHologram* wire, FChainPoles& out_poles);
+	static UFGCircuitConnectionComponent* GetPoleConnection(const AActor* pole);
+	static const FOverlapCache& FindNearbyBuildings(const AFGWireHologram* wire, const FVector& start, const FVector& end, float radius);
+
+	static FOverlapCache OverlapCache;
+};
@@ -2,10 +2,20 @@
 
 #include "FGBuildable.h"
 #include "FGCircuitConnectionComponent.h"
+#include "FGCircuitSubsystem.h"
+#include "Hologram/FGBlueprintHologram.h"
 #include "Hologram/FGPowerPoleHologram.h"
 #include "Hologram/FGWireHologram.h"
 #include "Patching/NativeHookManager.h"
+#include "PPOBBuildModes.h"
+#include "PPOBCircuitBatch.h"
+#include "PPOBDeferredHooks.h"
 #include "PPOBGameInstanceModule.h"
+#include "PPOBHitchWatchdog.h"
+#include "PPOBWireChain.h"
+
+DEFINE_LOG_CATEGORY(LogPowerPolesOnBuildings)
+LLM_DEFINE_TAG(PowerPolesOnBuildings);
 
 namespace
 {
@@ -26,68 +36,179 @@ bool WireHologramCanSnapPowerPoleToActor(const AFGWireHologram* wire, const AAct
 	return firstConnection == nullptr || firstConnection->GetOwner() == actor;
 }
 
-} // namespace
-
-void FPowerPolesOnBuildingsModule::StartupModule()
+/// Both wires and blueprints batch their circuit connections, so whichever turns up first installs these.
+void InstallCircuitBatchHook()
 {
-#if !WITH_EDITOR
-	SUBSCRIBE_UOBJECT_METHOD_AFTER(AFGPowerPoleHologram, BeginPlay,
-		[](AFGPowerPoleHologram* hologram)
+	static bool isInstalled = false;
+	if (isInstalled)
+		return;
+	isInstalled = true;
+
+	SUBSCRIBE_METHOD(AFGCircuitSubsystem::ConnectComponents,
+		[](auto& scope, AFGCircuitSubsystem* subsystem, UFGCircuitConnectionComponent* first, UFGCircuitConnectionComponent* second)
 		{
-			// Manually add the attachment point to the power pole.
-			// This is usually done by adding a component to the decorator template, and that's what we've done
-			// for all of the buildings that we want the power pole to snap to, but power poles don't have
-			// decorator templates set up and it isn't worth adding one just for this.
-			if (auto* gameInstanceModule = UPPOBGameInstanceModule::Get(hologram))
+			if (FPPOBCircuitBatch::TryDeferConnection(subsystem, first, second))
 			{
-				const FFGAttachmentPoint attachmentPoint = gameInstanceModule->CreatePowerPoleAttachmentPoint(hologram);
-				hologram->mCachedAttachmentPoints.Add(attachmentPoint);
+				scope.Cancel();
 			}
-
-			// The attachment points won't ever be found if the buildings aren't seen as valid.
-			hologram->AddValidHitClass(AFGBuildable::StaticClass());
 		});
 
-	SUBSCRIBE_UOBJECT_METHOD(AFGWireHologram, TrySnapToActor,
-		[](auto& scope, AFGWireHologram* wire, const FHitResult& hitResult)
+	// Disconnects still go through straight away, since the circuits have to be split based on what's
+	// actually wired up, but they mustn't be followed by a deferred connect for the same wire.
+	SUBSCRIBE_METHOD(AFGCircuitSubsystem::DisconnectComponents,
+		[](auto& scope, AFGCircuitSubsystem* subsystem, UFGCircuitConnectionComponent* first, UFGCircuitConnectionComponent* second)
 		{
-			// The wire hologram will only try to snap its wall outlet, presumably because the base game doesn't
-			// have snap points for power poles. Now that we've added some, we need to have logic for snapping
-			// them in the same way.
-
-			if (scope(wire, hitResult))
-				return;	// Already handled.
-
-			AFGPowerPoleHologram* powerPole = wire->mPowerPole;
-			const int32 currentConnectionIndex = wire->mCurrentConnection;
-			UFGCircuitConnectionComponent*& currentConnection = wire->mConnections[currentConnectionIndex];
-
-			if (!IsValid(powerPole) || !wire->mAutomaticPoleAvailable)
-				return;	// Don't have a power pole to play with.
-			if (currentConnectionIndex < 1)
-				return;	// Not placing the power pole yet.
-			if (currentConnection != nullptr && currentConnection != wire->mActiveSnapConnection)
-				return;	// The wire is currently connected to something other than the power pole.
-			if (!WireHologramCanSnapPowerPoleToActor(wire, hitResult.GetActor()))
-				return;	// Not allowed to snap to this actor.
-
-			// Preliminary checks passed, now actually try snapping.
-			if (powerPole->TrySnapToActor(hitResult))
+			FPPOBCircuitBatch::DropDeferredConnection(first, second);
+		});
+}
+
+} // namespace
+
+void FPowerPolesOnBuildingsModule::StartupModule()
+{
+#if !WITH_EDITOR
+	FPPOBHitchWatchdog::Install();
+
+	// Everything here is only needed while building, so none of it is installed until the relevant
+	// hologram turns up.
+
+	// The wire spawns its automatic pole as a child while it's being spawned itself, so the pole needs
+	// its hooks in place by then or the first wire placed would have no attachment points to snap to.
+	FPPOBDeferredHooks::Add({ AFGPowerPoleHologram::StaticClass(), AFGWireHologram::StaticClass() }, []
+	{
+		SUBSCRIBE_UOBJECT_METHOD_AFTER(AFGPowerPoleHologram, BeginPlay,
+			[](AFGPowerPoleHologram* hologram)
+			{
+				const FPPOBHitchWatchdog::FScope watchdogScope(FPPOBHitchWatchdog::EHook::PowerPoleBeginPlay);
+
+				// Manually add the attachment point to the power pole.
+				// This is usually done by adding a component to the decorator template, and that's what we've done
+				// for all of the buildings that we want the power pole to snap to, but power poles don't have
+				// decorator templates set up and it isn't worth adding one just for this.
+				if (auto* gameInstanceModule = UPPOBGameInstanceModule::Get(hologram))
+				{
+					// This is the first point that the buildings need their attachment points.
+					gameInstanceModule->FinishLoadingBuildingAttachmentPoints();
+
+					const FFGAttachmentPoint attachmentPoint = gameInstanceModule->CreatePowerPoleAttachmentPoint(hologram);
+					hologram->mCachedAttachmentPoints.Add(attachmentPoint);
+				}
+
+				// The attachment points won't ever be found if the buildings aren't seen as valid.
+				hologram->AddValidHitClass(AFGBuildable::StaticClass());
+			});
+	});
+
+	FPPOBDeferredHooks::Add(AFGWireHologram::StaticClass(), []
+	{
+		SUBSCRIBE_UOBJECT_METHOD(AFGWireHologram, TrySnapToActor,
+			[](auto& scope, AFGWireHologram* wire, const FHitResult& hitResult)
 			{
-				wire->SetActiveAutomaticPoleHologram(powerPole);
+				const FPPOBHitchWatchdog::FScope watchdogScope(FPPOBHitchWatchdog::EHook::WireTrySnapToActor);
+
+				// The wire hologram will only try to snap its wall outlet, presumably because the base game doesn't
+				// have snap points for power poles. Now that we've added some, we need to have logic for snapping
+				// them in the same way.
+
+				const bool snappedPowerPole = [&]
+				{
+					if (scope(wire, hitResult))
+						return false;	// Already handled.
+
+					AFGPowerPoleHologram* powerPole = wire->mPowerPole;
+					const int32 currentConnectionIndex = wire->mCurrentConnection;
+					UFGCircuitConnectionComponent*& currentConnection = wire->mConnections[currentConnectionIndex];
+
+					if (!IsValid(powerPole) || !wire->mAutomaticPoleAvailable)
+						return false;	// Don't have a power pole to play with.
+					if (currentConnectionIndex < 1)
+						return false;	// Not placing the power pole yet.
+					if (currentConnection != nullptr && currentConnection != wire->mActiveSnapConnection)
+						return false;	// The wire is currently connected to something other than the power pole.
+					if (!WireHologramCanSnapPowerPoleToActor(wire, hitResult.GetActor()))
+						return false;	// Not allowed to snap to this actor.
+
+					// Preliminary checks passed, now actually try snapping.
+					if (!powerPole->TrySnapToActor(hitResult))
+						return false;
+
+					wire->SetActiveAutomaticPoleHologram(powerPole);
+
+					UFGCircuitConnectionComponent* snapConnection = powerPole->mSnapConnection;
+					currentConnection = snapConnection;
+					wire->SetActorTransform(snapConnection->GetComponentTransform());
+
+					scope.Override(true);
+					return true;
+				}();
+
+				// Fill in the buildings between the two ends when placing a chain of poles.
+				FPPOBWireChain::Update(wire, snappedPowerPole ? Cast<AFGBuildable>(hitResult.GetActor()) : nullptr);
+			});
+
+		SUBSCRIBE_METHOD_VIRTUAL_AFTER(AFGHologram::GetSupportedBuildModes_Implementation, GetDefault<AFGWireHologram>(),
+			[](const AFGHologram* hologram, TArray<TSubclassOf<UFGBuildGunModeDescriptor>>& out_buildmodes)
+			{
+				auto* wire = Cast<AFGWireHologram>(hologram);
+				if (wire == nullptr)
+					return;
+
+				// Make sure that there's a way to get back to the normal behavior.
+				if (out_buildmodes.IsEmpty() && wire->mDefaultBuildMode != nullptr)
+				{
+					out_buildmodes.Add(wire->mDefaultBuildMode);
+				}
+				out_buildmodes.AddUnique(UPPOBChainedWireBuildMode::StaticClass());
+			});
+
+		SUBSCRIBE_UOBJECT_METHOD(AFGWireHologram, Construct,
+			[](auto& scope, AFGWireHologram* wire, TArray<AActor*>& out_children, FNetConstructionID constructionID)
+			{
+				// The chained poles are constructed as children of the wire, so everything arrives in one
+				// construct message and we only need to re-route the wires once it's all been built.
+				const FPPOBHitchWatchdog::FScope watchdogScope(FPPOBHitchWatchdog::EHook::WireConstruct);
+				FPPOBCircuitBatch batch;
+				AActor* result = scope(wire, out_children, constructionID);
+				FPPOBWireChain::ConnectConstructedPoles(wire, result, out_children);
+				batch.AddConstructedActors(result, out_children);
+			});
+
+		SUBSCRIBE_UOBJECT_METHOD_AFTER(AFGWireHologram, CheckValidPlacement,
+			[](AFGWireHologram* wire)
+			{
+				// Chains can be longer than a single wire, as long as each gap between the poles isn't.
+				FPPOBWireChain::AllowLongChain(wire);
+			});
 
-				UFGCircuitConnectionComponent* snapConnection = powerPole->mSnapConnection;
-				currentConnection = snapConnection;
-				wire->SetActorTransform(snapConnection->GetComponentTransform());
+		InstallCircuitBatchHook();
+	});
 
-				scope.Override(true);
-			}
-		});
+	FPPOBDeferredHooks::Add(AFGBlueprintHologram::StaticClass(), []
+	{
+		SUBSCRIBE_UOBJECT_METHOD(AFGBlueprintHologram, Construct,
+			[](auto& scope, AFGBlueprintHologram* blueprint, TArray<AActor*>& out_children, FNetConstructionID constructionID)
+			{
+				// Blueprints can contain lots of poles on top of buildings, so merge their circuits in one go.
+				const FPPOBHitchWatchdog::FScope watchdogScope(FPPOBHitchWatchdog::EHook::BlueprintConstruct);
+				if (!FPPOBCircuitBatch::ContainsPowerPoles(blueprint))
+				{
+					scope(blueprint, out_children, constructionID);
+					return;	// Nothing to batch.
+				}
+
+				FPPOBCircuitBatch batch;
+				AActor* result = scope(blueprint, out_children, constructionID);
+				batch.AddConstructedActors(result, out_children);
+			});
+
+		InstallCircuitBatchHook();
+	});
 #endif
 }
 
 void FPowerPolesOnBuildingsModule::ShutdownModule()
 {
+	FPPOBHitchWatchdog::Uninstall();
 }
 
 IMPLEMENT_MODULE(FPowerPolesOnBuildingsModule, PowerPolesOnBuildings)
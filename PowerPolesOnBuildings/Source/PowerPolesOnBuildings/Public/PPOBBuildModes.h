@@ -0,0 +1,17 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Hologram/FGHologramBuildModeDescriptor.h"
+#include "PPOBBuildModes.generated.h"
+
+/// Places a power pole on every building between the two ends of the wire.
+UCLASS()
+class POWERPOLESONBUILDINGS_API UPPOBChainedWireBuildMode : public UFGHologramBuildModeDescriptor
+{
+	GENERATED_BODY()
+public:
+	UPPOBChainedWireBuildMode()
+	{
+		mDisplayName = INVTEXT("Chained Poles");
+	}
+};
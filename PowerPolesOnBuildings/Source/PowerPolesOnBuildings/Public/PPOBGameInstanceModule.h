@@ -4,8 +4,10 @@
 #include "Module/GameInstanceModule.h"
 #include "PPOBGameInstanceModule.generated.h"
 
+class AFGBuildable;
 class AFGDecorationTemplate;
 struct FFGAttachmentPoint;
+struct FStreamableHandle;
 
 UCLASS()
 class POWERPOLESONBUILDINGS_API UPPOBGameInstanceModule : public UGameInstanceModule
@@ -18,17 +20,74 @@ public:
 
 	FFGAttachmentPoint CreatePowerPoleAttachmentPoint(AActor* owner) const;
 
+	/// Makes sure that all of the buildings in BuildingAttachmentPoints and the discovery cache have
+	/// their attachment points, waiting for them to finish loading if necessary.
+	void FinishLoadingBuildingAttachmentPoints();
+
+	/// Gets the relative location of the power pole attachment point on the given building.
+	/// Returns an unset value if the building doesn't have one.
+	TOptional<FVector> FindBuildingAttachmentPoint(const AFGBuildable* buildable) const;
+
+	/// Prints what the mod is keeping resident: its own classes and assets, the decoration templates
+	/// that it patched along with the attachment points that it added to them, and its lookup tables.
+	void DumpMemoryReport(FOutputDevice& ar) const;
+
+	int32 GetMaxChainedPoles() const { return MaxChainedPoles; }
+	float GetChainSearchRadius() const { return ChainSearchRadius; }
+
 	// UGameInstanceModule
 	virtual void DispatchLifecycleEvent(ELifecyclePhase phase) override;
 
 private:
 	static void AddAttachmentPointComponent(UBlueprintGeneratedClass* blueprintClass, const FVector& offset);
 
+	void LoadBuildingAttachmentPoints();
+	void PatchLoadedBuildingAttachmentPoints();
+
+	void DiscoverBuildingAttachmentPoints();
+	void FinishBuildingAttachmentPointDiscovery(const FStreamableHandle* loadRequest, uint32 cacheSignature);
+	void AddDiscoveredAttachmentPoint(UBlueprintGeneratedClass* decoratorClass, const FVector& offset);
+	uint32 CalculateAttachmentPointCacheSignature(const TArray<FSoftObjectPath>& buildableClasses) const;
+
 	/// Relative transform for the attachment point added to power pole holograms.
 	UPROPERTY(Category="Attachment Points", EditDefaultsOnly)
 	FVector PowerPoleAttachmentPoint;
 
-	/// Relative transform for the attachment points added to buildings.
+	/// Relative transform for the attachment points added to buildings. These are loaded in the
+	/// background along with the cached discovered ones and patched as they arrive, so that startup
+	/// doesn't have to wait for them.
+	UPROPERTY(Category = "Attachment Points", EditDefaultsOnly)
+	TMap<TSoftClassPtr<AFGDecorationTemplate>, FVector> BuildingAttachmentPoints;
+
+	/// Automatically add attachment points to the middle of the roof of any building that isn't listed
+	/// in BuildingAttachmentPoints.
 	UPROPERTY(Category = "Attachment Points", EditDefaultsOnly)
-	TMap<TSubclassOf<AFGDecorationTemplate>, FVector> BuildingAttachmentPoints;
+	bool AutoDiscoverBuildingAttachmentPoints = true;
+
+	/// Maximum number of extra poles that the chained wire build mode will place.
+	UPROPERTY(Category = "Chained Poles", EditDefaultsOnly)
+	int32 MaxChainedPoles = 32;
+
+	/// How far a building's attachment point can be from the line between the two ends of the wire for
+	/// the chained wire build mode to put a pole on it.
+	UPROPERTY(Category = "Chained Poles", EditDefaultsOnly)
+	float ChainSearchRadius = 400.0f;
+
+	/// Attachment points that were added by the automatic discovery. This also keeps the patched
+	/// decoration templates loaded, otherwise we'd lose the new components if they got unloaded.
+	UPROPERTY(Transient)
+	TMap<TSubclassOf<AFGDecorationTemplate>, FVector> DiscoveredBuildingAttachmentPoints;
+
+	/// Attachment points from the discovery cache whose decoration templates are still loading. They're
+	/// loaded along with BuildingAttachmentPoints, and moved to DiscoveredBuildingAttachmentPoints as
+	/// they arrive.
+	TMap<FSoftClassPath, FVector> CachedBuildingAttachmentPoints;
+
+	/// Decoration templates from BuildingAttachmentPoints that have been patched so far, which also keeps
+	/// them loaded for the same reason. Lookups go through here rather than BuildingAttachmentPoints,
+	/// since hashing a soft pointer means building its path.
+	UPROPERTY(Transient)
+	TMap<TSubclassOf<AFGDecorationTemplate>, FVector> PatchedBuildingAttachmentPoints;
+
+	TSharedPtr<FStreamableHandle> BuildingAttachmentPointsLoadHandle;
 };
@@ -1,7 +1,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
 #include "Modules/ModuleManager.h"
+#include "Stats/Stats.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogPowerPolesOnBuildings, Log, All)
+LLM_DECLARE_TAG_API(PowerPolesOnBuildings, POWERPOLESONBUILDINGS_API);
+DECLARE_STATS_GROUP(TEXT("PowerPolesOnBuildings"), STATGROUP_PowerPolesOnBuildings, STATCAT_Advanced);
 
 class FPowerPolesOnBuildingsModule : public IModuleInterface
 {
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FGBuildDescriptor.h"
+#include "FGRecipe.h"
+#include "Hologram/FGHologram.h"
+#include "Patching/NativeHookManager.h"
+
+/// Delays installing hooks that only matter for particular kinds of hologram until just before the
+/// first hologram of one of those kinds is spawned. Hooks aren't free even when they don't do anything,
+/// and a lot of servers go for long stretches without anyone building, so there's no point paying for
+/// hologram hooks until somebody does.
+///
+/// Holograms are noticed when they're spawned through AFGHologram::SpawnHologramFromRecipe, which is
+/// what the build gun and the construction messages on the server go through, and through
+/// AFGHologram::SpawnChildHologramFromRecipe for the holograms that others make for themselves. If the
+/// hologram class can't be worked out from the recipe, everything that's pending gets installed to be
+/// on the safe side.
+///
+/// Each mod gives it a traits struct with LogInstall(const UClass*), which logs in the mod's own
+/// category, so that every mod has its own list and its own spawn hooks.
+template <typename TTraits>
+class TModDeferredHooks
+{
+public:
+	/// Calls install just before the first hologram of any of the given classes (or their subclasses)
+	/// is spawned.
+	static void Add(TArray<UClass*> hologramClasses, TFunction<void()> install)
+	{
+		check(IsInGameThread());
+
+		PendingHooks.Add({ .hologramClasses = MoveTemp(hologramClasses), .install = MoveTemp(install) });
+
+		if (IsSpawnHookInstalled)
+			return;
+		IsSpawnHookInstalled = true;
+
+		SUBSCRIBE_METHOD(AFGHologram::SpawnHologramFromRecipe,
+			[](auto& scope, TSubclassOf<UFGRecipe> recipe, auto&&...)
+			{
+				if (UNLIKELY(!PendingHooks.IsEmpty()))
+				{
+					OnSpawnHologram(recipe);
+				}
+			});
+
+		SUBSCRIBE_METHOD(AFGHologram::SpawnChildHologramFromRecipe,
+			[](auto& scope, AFGHologram* parent, FName hologramName, TSubclassOf<UFGRecipe> recipe, auto&&...)
+			{
+				if (UNLIKELY(!PendingHooks.IsEmpty()))
+				{
+					OnSpawnHologram(recipe);
+				}
+			});
+	}
+
+	static void Add(UClass* hologramClass, TFunction<void()> install)
+	{
+		Add(TArray<UClass*>{ hologramClass }, MoveTemp(install));
+	}
+
+private:
+	struct FPendingHook
+	{
+		TArray<UClass*> hologramClasses;
+		TFunction<void()> install;
+	};
+
+	static void OnSpawnHologram(TSubclassOf<UFGRecipe> recipe)
+	{
+		const UClass* hologramClass = GetHologramClass(recipe);
+
+		// Taken out of the list first in case installing one of them spawns another hologram.
+		TArray<FPendingHook> readyHooks;
+		for (int32 index = PendingHooks.Num() - 1; index >= 0; --index)
+		{
+			const bool isNeeded = hologramClass == nullptr || PendingHooks[index].hologramClasses.ContainsByPredicate(
+				[hologramClass](const UClass* pendingClass) { return hologramClass->IsChildOf(pendingClass); });
+			if (isNeeded)
+			{
+				readyHooks.Add(MoveTemp(PendingHooks[index]));
+				PendingHooks.RemoveAt(index);
+			}
+		}
+
+		// Install them in the order that they were added.
+		for (int32 index = readyHooks.Num() - 1; index >= 0; --index)
+		{
+			TTraits::LogInstall(readyHooks[index].hologramClasses[0]);
+			readyHooks[index].install();
+		}
+	}
+
+	static UClass* GetHologramClass(TSubclassOf<UFGRecipe> recipe)
+	{
+		if (recipe == nullptr)
+			return nullptr;
+
+		const TArray<FItemAmount> products = UFGRecipe::GetProducts(recipe);
+		if (products.IsEmpty())
+			return nullptr;
+
+		const TSubclassOf<UFGBuildDescriptor> descriptor = *products[0].ItemClass;
+		return descriptor ? *UFGBuildDescriptor::GetHologramClass(descriptor) : nullptr;
+	}
+
+	inline static TArray<FPendingHook> PendingHooks;
+	inline static bool IsSpawnHookInstalled = false;
+};
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+
+/// Logs which of a mod's hooks ran during any game thread frame that takes longer than a budget, with
+/// how long they took and how many times they were called, so that a hitch in someone's log can be
+/// pinned on the mod or ruled out.
+///
+/// Only the hooks that are wrapped in an FScope are counted, and only on the game thread. The times
+/// include the game's own function for hooks that wrap it, and a hook that runs inside another is
+/// counted in both. The counts go in a small ring of frames that's allocated up front, so timing a
+/// hook is two cycle counter reads and an add, and DumpRecentFrames can show the frames leading up to
+/// the last hitch as well.
+///
+/// Each mod gives it a traits struct with:
+/// - EHook, an enum class of the hooks that ends in Count.
+/// - HookNames, one display name for each EHook.
+/// - BudgetVariableName, the name of the console variable that holds the budget in milliseconds.
+/// - LogHitch(const FString&), which logs a warning in the mod's own category.
+template <typename TTraits>
+class TModHitchWatchdog
+{
+public:
+	using EHook = typename TTraits::EHook;
+
+	/// Times a hook for as long as it's in scope.
+	class FScope
+	{
+	public:
+		explicit FScope(EHook hook)
+			: Hook(hook)
+			, StartCycles(IsEnabled && IsInGameThread() ? FPlatformTime::Cycles64() : 0)
+		{
+		}
+
+		~FScope()
+		{
+			if (StartCycles != 0)
+			{
+				Record(Hook, FPlatformTime::Cycles64() - StartCycles);
+			}
+		}
+
+		UE_NONCOPYABLE(FScope);
+
+	private:
+		EHook Hook;
+		uint64 StartCycles;
+	};
+
+	static void Install()
+	{
+		if (BeginFrameHandle.IsValid())
+			return;	// Already installed.
+
+		BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddStatic(&TModHitchWatchdog::OnBeginFrame);
+		EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&TModHitchWatchdog::OnEndFrame);
+	}
+
+	static void Uninstall()
+	{
+		FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+		BeginFrameHandle.Reset();
+		EndFrameHandle.Reset();
+		IsEnabled = false;
+	}
+
+	/// Prints the frames in the ring, oldest first.
+	static void DumpRecentFrames(FOutputDevice& ar)
+	{
+		for (int32 i = 1; i <= FrameCount; ++i)
+		{
+			const FFrame& frame = Frames[(CurrentFrame + i) % FrameCount];
+			if (frame.FrameNumber != 0)
+			{
+				ar.Log(DescribeFrame(frame));
+			}
+		}
+	}
+
+private:
+	struct FHookStats
+	{
+		uint64 Cycles = 0;
+		uint32 Calls = 0;
+	};
+
+	struct FFrame
+	{
+		uint64 FrameNumber = 0;
+		double Milliseconds = 0.0;
+		FHookStats Hooks[static_cast<int32>(EHook::Count)];
+	};
+
+	static constexpr int32 FrameCount = 16;
+
+	static void Record(EHook hook, uint64 cycles)
+	{
+		FHookStats& stats = Frames[CurrentFrame].Hooks[static_cast<int32>(hook)];
+		stats.Cycles += cycles;
+		++stats.Calls;
+	}
+
+	static void OnBeginFrame()
+	{
+		IsEnabled = CVarHitchBudgetMs.GetValueOnGameThread() > 0.0f;
+
+		CurrentFrame = (CurrentFrame + 1) % FrameCount;
+		FFrame& frame = Frames[CurrentFrame];
+		frame = FFrame();
+		frame.FrameNumber = GFrameCounter;
+
+		FrameStartTime = FPlatformTime::Seconds();
+	}
+
+	static void OnEndFrame()
+	{
+		if (FrameStartTime == 0.0)
+			return;	// Installed part way through a frame.
+
+		FFrame& frame = Frames[CurrentFrame];
+		frame.Milliseconds = (FPlatformTime::Seconds() - FrameStartTime) * 1000.0;
+
+		const float budgetMs = CVarHitchBudgetMs.GetValueOnGameThread();
+		if (IsEnabled && budgetMs > 0.0f && frame.Milliseconds > budgetMs)
+		{
+			TTraits::LogHitch(FString::Printf(TEXT("Hitch over %.0fms budget. %s"), budgetMs, *DescribeFrame(frame)));
+		}
+	}
+
+	static FString DescribeFrame(const FFrame& frame)
+	{
+		TStringBuilder<512> description;
+		description.Appendf(TEXT("Frame %llu took %.1fms:"), frame.FrameNumber, frame.Milliseconds);
+
+		bool anyHooks = false;
+		for (int32 hook = 0; hook < static_cast<int32>(EHook::Count); ++hook)
+		{
+			const FHookStats& stats = frame.Hooks[hook];
+			if (stats.Calls == 0)
+				continue;
+
+			description.Appendf(TEXT("%s %s %.2fms (%u calls)"),
+				anyHooks ? TEXT(",") : TEXT(""), TTraits::HookNames[hook], FPlatformTime::ToMilliseconds64(stats.Cycles), stats.Calls);
+			anyHooks = true;
+		}
+		if (!anyHooks)
+		{
+			description << TEXT(" none of our hooks ran");
+		}
+		description << TEXT(".");
+
+		return FString(description);
+	}
+
+	inline static TAutoConsoleVariable<float> CVarHitchBudgetMs{
+		TTraits::BudgetVariableName,
+		100.0f,
+		TEXT("Game thread frames longer than this log which of our hooks ran in them. 0 turns the watchdog off.")};
+
+	inline static FFrame Frames[FrameCount];
+	inline static int32 CurrentFrame = 0;
+	inline static double FrameStartTime = 0.0;
+	/// Read once per frame from the console variable, since the scopes can't afford to.
+	inline static bool IsEnabled = false;
+	inline static FDelegateHandle BeginFrameHandle;
+	inline static FDelegateHandle EndFrameHandle;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Serialization/ArchiveCountMem.h"
+
+/// Adds up the objects and memory that are kept resident by one part of a mod, for the mods' memory
+/// reports.
+struct FModMemoryTally
+{
+	int32 classCount = 0;
+	int32 objectCount = 0;
+	SIZE_T byteCount = 0;
+
+	void Add(const UObject* object)
+	{
+		++(object->IsA<UClass>() ? classCount : objectCount);
+
+		// This is the same measurement that `obj list` uses, so it works without a renderer.
+		FArchiveCountMem countMem(const_cast<UObject*>(object));
+		byteCount += countMem.GetMax() + object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	}
+
+	void Print(FOutputDevice& ar, const TCHAR* name) const
+	{
+		ar.Logf(TEXT("  %-32s %6i classes %8i objects %10.1f KiB"), name, classCount, objectCount, byteCount / 1024.0);
+	}
+
+	/// Prints the size of a container or anything else that isn't an object.
+	static void PrintEntries(FOutputDevice& ar, const TCHAR* name, int32 entryCount, SIZE_T entryBytes)
+	{
+		ar.Logf(TEXT("  %-32s %6i entries %9.1f KiB"), name, entryCount, entryBytes / 1024.0);
+	}
+
+	/// Prints the total for the mod's LLM tag, when LLM is compiled in and turned on.
+	static void PrintLLMTag(FOutputDevice& ar, const TCHAR* tagName)
+	{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		if (FLowLevelMemTracker::IsEnabled())
+		{
+			const int64 taggedBytes = FLowLevelMemTracker::Get().GetTagAmountForTracker(ELLMTracker::Default, tagName, ELLMTagSet::None);
+			ar.Logf(TEXT("  %-32s %31.1f KiB"), TEXT("LLM tag"), taggedBytes / 1024.0);
+		}
+#endif
+	}
+};
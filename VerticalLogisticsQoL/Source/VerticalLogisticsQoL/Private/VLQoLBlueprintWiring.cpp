@@ -0,0 +1,115 @@
+#include "VLQoLBlueprintWiring.h"
+
+#include "Buildables/FGBuildableConveyorLift.h"
+#include "FGFactoryConnectionComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "VerticalLogisticsQoL.h"
+
+namespace
+{
+
+TAutoConsoleVariable<bool> CVarConnectBlueprintsInBulk(
+	TEXT("VLQoL.ConnectBlueprintsInBulk"),
+	true,
+	TEXT("Match up the open factory connections in a pasted blueprint from a spatial hash."));
+
+/// Connectors closer than this are treated as being in the same place.
+constexpr double LocationTolerance = 1.0;
+
+} // namespace
+
+void FVLQoLBlueprintWiring::ConnectConstructedActors(AActor* result, const TArray<AActor*>& children)
+{
+	if (!CVarConnectBlueprintsInBulk.GetValueOnGameThread())
+		return;
+
+	const double startTime = FPlatformTime::Seconds();
+
+	// Cells are the same size as the tolerance, so a matching connector is always in one of the
+	// neighbouring cells.
+	TMultiMap<FIntVector, UFGFactoryConnectionComponent*> openConnections;
+	{
+		TInlineComponentArray<UFGFactoryConnectionComponent*> components;
+		auto addActor = [&](const AActor* actor)
+		{
+			if (actor == nullptr)
+				return;
+
+			actor->GetComponents(components);
+			for (UFGFactoryConnectionComponent* component : components)
+			{
+				if (component->GetConnection() == nullptr)
+				{
+					openConnections.Add(GetCell(component->GetConnectorLocation()), component);
+				}
+			}
+		};
+
+		addActor(result);
+		for (const AActor* child : children)
+		{
+			addActor(child);
+		}
+	}
+
+	int32 connectionCount = 0;
+
+	for (auto&& [cell, component] : openConnections)
+	{
+		if (component->GetConnection() != nullptr)
+			continue;	// Already matched up from the other side.
+
+		for (int32 x = -1; x <= 1 && component->GetConnection() == nullptr; ++x)
+		{
+			for (int32 y = -1; y <= 1 && component->GetConnection() == nullptr; ++y)
+			{
+				for (int32 z = -1; z <= 1 && component->GetConnection() == nullptr; ++z)
+				{
+					for (auto it = openConnections.CreateConstKeyIterator(cell + FIntVector(x, y, z)); it; ++it)
+					{
+						UFGFactoryConnectionComponent* other = it.Value();
+						if (other != component && other->GetConnection() == nullptr && CanConnect(component, other))
+						{
+							component->SetConnection(other);
+							++connectionCount;
+							break;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	UE_LOG(LogVerticalLogisticsQoL, Verbose,
+		TEXT("Checked %i open connections in a blueprint and connected %i pairs in %.3fms."),
+		openConnections.Num(), connectionCount, (FPlatformTime::Seconds() - startTime) * 1000.0);
+}
+
+bool FVLQoLBlueprintWiring::CanConnect(const UFGFactoryConnectionComponent* first, const UFGFactoryConnectionComponent* second)
+{
+	if (first->GetOuterBuildable() == second->GetOuterBuildable())
+		return false;	// Never connect a building to itself.
+	if (!first->GetConnectorLocation().Equals(second->GetConnectorLocation(), LocationTolerance))
+		return false;	// Not in the same place.
+	if (!first->CanSnapTo(const_cast<UFGFactoryConnectionComponent*>(second)))
+		return false;	// Incompatible directions.
+
+	const FVector firstNormal = first->GetConnectorNormal();
+	const FVector secondNormal = second->GetConnectorNormal();
+	if (FVector::Coincident(firstNormal, -secondNormal))
+		return true;	// Facing each other, like any other connection.
+
+	// The normal for a lift connection always points out horizontally, so it doesn't line up with a
+	// vertical connection even when the lift goes straight into it.
+	const bool firstIsLift = first->GetOuterBuildable()->IsA<AFGBuildableConveyorLift>();
+	const bool secondIsLift = second->GetOuterBuildable()->IsA<AFGBuildableConveyorLift>();
+	return (firstIsLift && FMath::Abs(secondNormal.Z) > 0.5) || (secondIsLift && FMath::Abs(firstNormal.Z) > 0.5);
+}
+
+FIntVector FVLQoLBlueprintWiring::GetCell(const FVector& location)
+{
+	return FIntVector(
+		FMath::FloorToInt(location.X / LocationTolerance),
+		FMath::FloorToInt(location.Y / LocationTolerance),
+		FMath::FloorToInt(location.Z / LocationTolerance));
+}
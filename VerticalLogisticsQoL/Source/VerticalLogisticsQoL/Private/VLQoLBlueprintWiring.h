@@ -0,0 +1,22 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UFGFactoryConnectionComponent;
+
+/// Connects up the factory connections between the actors in a pasted blueprint in one pass.
+///
+/// Connections that are left open after the blueprint has been constructed, which is mostly the
+/// vertical ones between lifts and attachments, would otherwise be found one connector at a time by
+/// overlap searches. Instead, every open connector in the blueprint goes into a spatial hash and the
+/// pairs are matched up from that, so the cost only grows linearly with the size of the blueprint.
+class FVLQoLBlueprintWiring
+{
+public:
+	static void ConnectConstructedActors(AActor* result, const TArray<AActor*>& children);
+
+private:
+	static bool CanConnect(const UFGFactoryConnectionComponent* first, const UFGFactoryConnectionComponent* second);
+	static FIntVector GetCell(const FVector& location);
+};
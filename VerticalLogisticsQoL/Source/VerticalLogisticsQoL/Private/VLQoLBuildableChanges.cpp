@@ -0,0 +1,20 @@
+#include "VLQoLBuildableChanges.h"
+
+#include "FGBuildableSubsystem.h"
+#include "Patching/NativeHookManager.h"
+
+uint64 FVLQoLBuildableChanges::Count = 0;
+
+void FVLQoLBuildableChanges::Install()
+{
+	static bool isInstalled = false;
+	if (isInstalled)
+		return;
+	isInstalled = true;
+
+	SUBSCRIBE_METHOD_AFTER(AFGBuildableSubsystem::AddBuildable,
+		[](AFGBuildableSubsystem* subsystem, AFGBuildable* buildable) { ++Count; });
+
+	SUBSCRIBE_METHOD_AFTER(AFGBuildableSubsystem::RemoveBuildable,
+		[](AFGBuildableSubsystem* subsystem, AFGBuildable* buildable) { ++Count; });
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/// Counts how many times something has been built or dismantled, so that anything that's worked out
+/// from the layout of the factory can tell when it's out of date.
+class FVLQoLBuildableChanges
+{
+public:
+	/// Installs the hooks that do the counting; safe to call more than once.
+	static void Install();
+
+	static uint64 GetCount() { return Count; }
+
+private:
+	static uint64 Count;
+};
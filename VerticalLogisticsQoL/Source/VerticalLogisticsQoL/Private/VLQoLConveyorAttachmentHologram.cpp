@@ -14,6 +14,8 @@
 #include "VLQoLBuildModes.h"
 #include "VLQoLConstructDisqualifiers.h"
 #include "VLQoLGameInstanceModule.h"
+#include "VLQoLHitchWatchdog.h"
+#include "VerticalLogisticsQoL.h"
 
 AVLQoLConveyorAttachmentHologram::AVLQoLConveyorAttachmentHologram()
 {
@@ -324,6 +326,9 @@ void AVLQoLConveyorAttachmentHologram::UpdateClearance()
 
 void AVLQoLConveyorAttachmentHologram::UpdateHologramComponents(const UFGFactorySettings* settings)
 {
+	LLM_SCOPE_BYTAG(VerticalLogisticsQoL);
+	const FVLQoLHitchWatchdog::FScope watchdogScope(FVLQoLHitchWatchdog::EHook::UpdateHologramComponents);
+
 	// Remove the previous buildable's meshes.
 	{
 		TArray<USceneComponent*, TInlineAllocator<64>> componentsToDelete;
@@ -0,0 +1,8 @@
+#include "VLQoLDeferredHooks.h"
+
+#include "VerticalLogisticsQoL.h"
+
+void FVLQoLDeferredHooksTraits::LogInstall(const UClass* hologramClass)
+{
+	UE_LOG(LogVerticalLogisticsQoL, Verbose, TEXT("Installing deferred hooks for %s."), *GetNameSafe(hologramClass));
+}
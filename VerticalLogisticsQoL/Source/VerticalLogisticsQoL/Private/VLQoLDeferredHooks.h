@@ -0,0 +1,13 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ModDeferredHooks.h"
+
+/// Where FVLQoLDeferredHooks reports what it installs.
+struct FVLQoLDeferredHooksTraits
+{
+	static void LogInstall(const UClass* hologramClass);
+};
+
+/// Hooks that VLQoL holds back until the holograms that need them turn up, see TModDeferredHooks.
+using FVLQoLDeferredHooks = TModDeferredHooks<FVLQoLDeferredHooksTraits>;
@@ -8,8 +8,12 @@
 #include "Engine/AssetManager.h"
 #include "FGFactoryConnectionComponent.h"
 #include "Hologram/FGConveyorAttachmentHologram.h"
+#include "ModMemoryTally.h"
 #include "Module/GameInstanceModuleManager.h"
+#include "UObject/UObjectIterator.h"
 #include "VerticalLogisticsQoL.h"
+#include "VLQoLConveyorAttachmentHologram.h"
+#include "VLQoLHitchWatchdog.h"
 
 UVLQoLGameInstanceModule* UVLQoLGameInstanceModule::Get(UObject* worldContext)
 {
@@ -114,238 +118,404 @@ void UVLQoLGameInstanceModule::DispatchLifecycleEvent(ELifecyclePhase phase)
 
 	if (!WITH_EDITOR && phase == ELifecyclePhase::POST_INITIALIZATION)
 	{
+		LLM_SCOPE_BYTAG(VerticalLogisticsQoL);
+
 		// Dynamically discover (and patch) all of the conveyor attachment types.
 		UClass* rootClass = AFGBuildableConveyorAttachment::StaticClass();
-		if (TSharedPtr<FStreamableHandle> loadHandle = LoadDerivedClasses(rootClass))
+		SetupLoadHandle = LoadDerivedClasses(rootClass);
+		if (SetupLoadHandle)
 		{
-			if (loadHandle->HasLoadCompleted())
+			if (SetupLoadHandle->HasLoadCompleted())
 			{
-				FinishSetup(loadHandle.Get());
+				StartSetup();
 			}
 			else
 			{
-				loadHandle->BindCompleteDelegate(FStreamableDelegate::CreateUObject(
-					this,
-					&UVLQoLGameInstanceModule::FinishSetup,
-					const_cast<const FStreamableHandle*>(loadHandle.Get())));
+				SetupLoadHandle->BindCompleteDelegate(FStreamableDelegate::CreateUObject(this, &UVLQoLGameInstanceModule::StartSetup));
 			}
 		}
 	}
 }
 
-void UVLQoLGameInstanceModule::FinishSetup(const FStreamableHandle* loadRequest)
+void UVLQoLGameInstanceModule::BeginDestroy()
+{
+	if (SetupTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SetupTickerHandle);
+		SetupTickerHandle.Reset();
+	}
+
+	Super::BeginDestroy();
+}
+
+TSubclassOf<UFGRecipe> UVLQoLGameInstanceModule::GetVerticalConveyorAttachmentRecipe(TSubclassOf<UFGRecipe> recipe)
+{
+	CompleteSetup();
+	return RegularToVerticalRecipeMap.FindRef(recipe);
+}
+
+TSubclassOf<UFGRecipe> UVLQoLGameInstanceModule::GetRegularConveyorAttachmentRecipe(TSubclassOf<UFGRecipe> recipe)
+{
+	CompleteSetup();
+	return VerticalToRegularRecipeMap.FindRef(recipe);
+}
+
+// Checking every conveyor attachment class gets slow with lots of modded attachments, so rather than
+// doing it all at once when the load finishes, the work is spread over as many frames as it needs.
+void UVLQoLGameInstanceModule::StartSetup()
 {
 	check(CDOEdits.IsEmpty());
+	check(SetupJob == nullptr);
 
-	struct OverrideInfo { UClass* recipeClass; UClass* buildableClass; };
-	TArray<TPair<UClass* /* buildableClass */, OverrideInfo>, TInlineAllocator<64>> floorToLiftOverrides;
-	TMap<UClass* /* buildableClass */, OverrideInfo, TInlineSetAllocator<64>> liftToFloorOverrides;
+	SetupJob = MakeUnique<FSetupJob>();
+	SetupJob->startTime = FPlatformTime::Seconds();
 
-	// Parse the hologram overrides on each of the buildables, ignoring any that wouldn't work with our
-	// custom hologram implementation.
-	loadRequest->ForEachLoadedAsset([&](UObject* asset)
+	SetupLoadHandle->ForEachLoadedAsset([this](UObject* asset)
 	{
-		auto* buildableClass = Cast<UBlueprintGeneratedClass>(asset);
-		if (buildableClass == nullptr)
-			return;
-		auto* buildable = Cast<AFGBuildableConveyorAttachment>(buildableClass->GetDefaultObject());
-		if (buildable == nullptr)
-			return;
+		if (auto* buildableClass = Cast<UBlueprintGeneratedClass>(asset))
+		{
+			SetupJob->pendingClasses.Add(buildableClass);
+		}
+	});
+
+	UE_LOG(LogVerticalLogisticsQoL, Log,
+		TEXT("Checking %i conveyor attachment classes, using up to %.1fms per frame."),
+		SetupJob->pendingClasses.Num(), SetupTimeBudgetMs);
+
+	SetupTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UVLQoLGameInstanceModule::TickSetup));
+}
 
-		if (UClass* hologramClass = buildable->mHologramClass)
+bool UVLQoLGameInstanceModule::TickSetup(float deltaTime)
+{
+	if (RunSetup(FPlatformTime::Seconds() + SetupTimeBudgetMs / 1000.0))
+	{
+		SetupTickerHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+void UVLQoLGameInstanceModule::CompleteSetup()
+{
+	if (LIKELY(SetupJob == nullptr))
+		return;
+
+	// Something needs the results right now, so finish the rest of the job in one go.
+	UE_LOG(LogVerticalLogisticsQoL, Log, TEXT("Conveyor attachment setup was still running when it was needed, finishing it now."));
+	RunSetup(TNumericLimits<double>::Max());
+
+	if (SetupTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SetupTickerHandle);
+		SetupTickerHandle.Reset();
+	}
+}
+
+bool UVLQoLGameInstanceModule::RunSetup(double endTime)
+{
+	LLM_SCOPE_BYTAG(VerticalLogisticsQoL);
+	const FVLQoLHitchWatchdog::FScope watchdogScope(FVLQoLHitchWatchdog::EHook::AttachmentSetup);
+
+	FSetupJob& job = *SetupJob;
+	++job.frameCount;
+
+	// Always make some progress, even if the budget is tiny.
+	do
+	{
+		if (job.nextClass < job.pendingClasses.Num())
 		{
-			// Leave the buildable alone if it has a non-default hologram class, as that's probably a custom
-			// hologram from another mod that we shouldn't touch.
-			if (hologramClass != DefaultConveyorAttachmentHologram
-				&& hologramClass != AFGConveyorAttachmentHologram::StaticClass())
+			CheckConveyorAttachment(job.pendingClasses[job.nextClass++]);
+		}
+		else if (job.nextPair < job.floorToLiftOverrides.Num())
+		{
+			if (job.nextPair == 0)
 			{
-				UE_LOG(LogVerticalLogisticsQoL, Log,
-					TEXT("Skipping %s because it uses non-default hologram class %s."),
-					*buildableClass->GetName(), *hologramClass->GetName());
-				return;
+				// Reserve memory.
+				const int32 count = job.floorToLiftOverrides.Num();
+				CDOEdits.Reserve(count);
+				RegularToVerticalRecipeMap.Reserve(count);
+				VerticalToRegularRecipeMap.Reserve(count);
 			}
+
+			auto [buildableClass, verticalInfo] = job.floorToLiftOverrides[job.nextPair++];
+			PatchConveyorAttachment(buildableClass, verticalInfo);
 		}
 		else
 		{
-			// Buildables without a hologram are probably abstract and therefore not interesting.
-			UE_LOG(LogVerticalLogisticsQoL, Verbose,
-				TEXT("Skipping %s because it doesn't have a hologram class."),
-				*buildableClass->GetName());
-			return;
+			UE_LOG(LogVerticalLogisticsQoL, Log,
+				TEXT("Patched %i of %i conveyor attachment classes in %.1fms over %i frames."),
+				CDOEdits.Num(), job.pendingClasses.Num(), (FPlatformTime::Seconds() - job.startTime) * 1000.0, job.frameCount);
+
+			// Our patched classes are kept alive by CDOEdits, so the rest can be released now.
+			SetupJob.Reset();
+			SetupLoadHandle.Reset();
+			return true;
 		}
+	}
+	while (FPlatformTime::Seconds() < endTime);
 
-		// If the buildable doesn't have exactly four factory connections then it probably isn't a normal
-		// merger or splitter and therefore isn't something that we can handle.
+	UE_LOG(LogVerticalLogisticsQoL, Verbose,
+		TEXT("Conveyor attachment setup progress: checked %i of %i classes, patched %i of %i."),
+		job.nextClass, job.pendingClasses.Num(), job.nextPair, job.floorToLiftOverrides.Num());
+	return false;
+}
+
+// Parses the hologram overrides on the buildable, ignoring any that wouldn't work with our custom
+// hologram implementation.
+void UVLQoLGameInstanceModule::CheckConveyorAttachment(UBlueprintGeneratedClass* buildableClass)
+{
+	auto* buildable = Cast<AFGBuildableConveyorAttachment>(buildableClass->GetDefaultObject());
+	if (buildable == nullptr)
+		return;
+
+	if (UClass* hologramClass = buildable->mHologramClass)
+	{
+		// Leave the buildable alone if it has a non-default hologram class, as that's probably a custom
+		// hologram from another mod that we shouldn't touch.
+		if (hologramClass != DefaultConveyorAttachmentHologram
+			&& hologramClass != AFGConveyorAttachmentHologram::StaticClass())
 		{
-			constexpr int32 expectedConnectionCount = 4;
-			const CountComponents connectionCount(buildableClass, UFGConnectionComponent::StaticClass());
+			UE_LOG(LogVerticalLogisticsQoL, Log,
+				TEXT("Skipping %s because it uses non-default hologram class %s."),
+				*buildableClass->GetName(), *hologramClass->GetName());
+			return;
+		}
+	}
+	else
+	{
+		// Buildables without a hologram are probably abstract and therefore not interesting.
+		UE_LOG(LogVerticalLogisticsQoL, Verbose,
+			TEXT("Skipping %s because it doesn't have a hologram class."),
+			*buildableClass->GetName());
+		return;
+	}
 
-			switch (connectionCount.seenTypes.Num())
+	// If the buildable doesn't have exactly four factory connections then it probably isn't a normal
+	// merger or splitter and therefore isn't something that we can handle.
+	{
+		constexpr int32 expectedConnectionCount = 4;
+		const CountComponents connectionCount(buildableClass, UFGConnectionComponent::StaticClass());
+
+		switch (connectionCount.seenTypes.Num())
+		{
+		case 0:
+			UE_LOG(LogVerticalLogisticsQoL, Log,
+				TEXT("Skipping %s because it doesn't have any connection components."),
+				*buildableClass->GetName());
+			return;
+		case 1:
+			if (!(*connectionCount.seenTypes.CreateConstIterator())->IsChildOf<UFGFactoryConnectionComponent>())
 			{
-			case 0:
+			default:
 				UE_LOG(LogVerticalLogisticsQoL, Log,
-					TEXT("Skipping %s because it doesn't have any connection components."),
+					TEXT("Skipping %s because it has non-factory connection components."),
 					*buildableClass->GetName());
 				return;
-			case 1:
-				if (!(*connectionCount.seenTypes.CreateConstIterator())->IsChildOf<UFGFactoryConnectionComponent>())
-				{
-				default:
-					UE_LOG(LogVerticalLogisticsQoL, Log,
-						TEXT("Skipping %s because it has non-factory connection components."),
-						*buildableClass->GetName());
-					return;
-				}
-				if (connectionCount.childCount != 0)
-				{
-					UE_LOG(LogVerticalLogisticsQoL, Log,
-						TEXT("Skipping %s because it has non-root factory connection components."),
-						*buildableClass->GetName());
-					return;
-				}
-				if (connectionCount.rootCount != expectedConnectionCount)
-				{
-					UE_LOG(LogVerticalLogisticsQoL, Log,
-						TEXT("Skipping %s because it has an unsupported factory connection count; expected %i, found %i."),
-						*buildableClass->GetName(), expectedConnectionCount, connectionCount.rootCount);
-					return;
-				}
 			}
-		}
-
-		// Our hologram class can only handle meshes if they're attached to the root. This isn't relevant
-		// for any of the base game conveyor attachments because they use abstract instances for their
-		// meshes, but some mods don't.
-		{
-			const CountComponents meshCount(buildableClass, UMeshComponent::StaticClass());
-
-			if (meshCount.childCount != 0)
+			if (connectionCount.childCount != 0)
 			{
 				UE_LOG(LogVerticalLogisticsQoL, Log,
-					TEXT("Skipping %s because it has non-root UMeshComponent instances."),
+					TEXT("Skipping %s because it has non-root factory connection components."),
 					*buildableClass->GetName());
 				return;
 			}
-		}
-
-		const UFGHologramOverride* hologramOverride = nullptr;
-
-		// We only know how to deal with buildables that have a single override, but the game treats null
-		// overrides as if they don't exist so we should try to support that too.
-		for (const UFGHologramOverride* currentHologramOverride : buildable->mHologramOverrides)
-		{
-			if (currentHologramOverride != nullptr)
+			if (connectionCount.rootCount != expectedConnectionCount)
 			{
-				if (hologramOverride == nullptr)
-				{
-					hologramOverride = currentHologramOverride;
-				}
-				else
-				{
-					UE_LOG(LogVerticalLogisticsQoL, Log,
-						TEXT("Skipping %s because it has more than one hologram override."),
-						*buildableClass->GetName());
-					return;
-				}
+				UE_LOG(LogVerticalLogisticsQoL, Log,
+					TEXT("Skipping %s because it has an unsupported factory connection count; expected %i, found %i."),
+					*buildableClass->GetName(), expectedConnectionCount, connectionCount.rootCount);
+				return;
 			}
 		}
+	}
+
+	// Our hologram class can only handle meshes if they're attached to the root. This isn't relevant
+	// for any of the base game conveyor attachments because they use abstract instances for their
+	// meshes, but some mods don't.
+	{
+		const CountComponents meshCount(buildableClass, UMeshComponent::StaticClass());
 
-		if (hologramOverride == nullptr)
+		if (meshCount.childCount != 0)
 		{
-			// No overrides means no vertical version, which doesn't interest us.
-			UE_LOG(LogVerticalLogisticsQoL, Verbose,
-				TEXT("Skipping %s because it doesn't have any hologram overrides."),
+			UE_LOG(LogVerticalLogisticsQoL, Log,
+				TEXT("Skipping %s because it has non-root UMeshComponent instances."),
 				*buildableClass->GetName());
 			return;
 		}
+	}
 
-		UClass* hologramOverrideClass = hologramOverride->GetClass();
-		UClass* overrideRecipeClass = hologramOverride->GetHologramOverrideWithoutChecks();
-		bool isRegularAttachment = false;
+	const UFGHologramOverride* hologramOverride = nullptr;
 
-		// Validate the override type, the game only has these two at the time of writing.
-		if (hologramOverrideClass == UFGHologramOverride_ConveyorAttachment_FloorToLift::StaticClass())
-		{
-			isRegularAttachment = true;
-		}
-		else if (hologramOverrideClass != UFGHologramOverride_ConveyorAttachment_LiftToFloor::StaticClass())
+	// We only know how to deal with buildables that have a single override, but the game treats null
+	// overrides as if they don't exist so we should try to support that too.
+	for (const UFGHologramOverride* currentHologramOverride : buildable->mHologramOverrides)
+	{
+		if (currentHologramOverride != nullptr)
 		{
-			UE_LOG(LogVerticalLogisticsQoL, Log,
-				TEXT("Skipping %s because it has an unknown hologram override class %s."),
-				*buildableClass->GetName(), *hologramOverrideClass->GetName());
-			return;
+			if (hologramOverride == nullptr)
+			{
+				hologramOverride = currentHologramOverride;
+			}
+			else
+			{
+				UE_LOG(LogVerticalLogisticsQoL, Log,
+					TEXT("Skipping %s because it has more than one hologram override."),
+					*buildableClass->GetName());
+				return;
+			}
 		}
+	}
 
-		UClass* overrideBuildableClass = AFGBuildable::GetBuildableClassFromRecipe(overrideRecipeClass);
+	if (hologramOverride == nullptr)
+	{
+		// No overrides means no vertical version, which doesn't interest us.
+		UE_LOG(LogVerticalLogisticsQoL, Verbose,
+			TEXT("Skipping %s because it doesn't have any hologram overrides."),
+			*buildableClass->GetName());
+		return;
+	}
 
-		// By default you can technically have a hologram override that points to any kind of buildable, but
-		// we're only expecting the case where you go to/from a vertical attachment.
-		if (overrideBuildableClass == nullptr || !overrideBuildableClass->IsChildOf<AFGBuildableConveyorAttachment>())
-		{
-			UE_LOG(LogVerticalLogisticsQoL, Log,
-				TEXT("Skipping %s because its hologram override points to %s, which isn't an AFGBuildableConveyorAttachment."),
-				*buildableClass->GetName(), overrideBuildableClass ? *overrideBuildableClass->GetName() : TEXT("null"));
-			return;
-		}
+	UClass* hologramOverrideClass = hologramOverride->GetClass();
+	UClass* overrideRecipeClass = hologramOverride->GetHologramOverrideWithoutChecks();
+	bool isRegularAttachment = false;
 
-		const OverrideInfo overrideInfo
-		{
-			.recipeClass = overrideRecipeClass,
-			.buildableClass = overrideBuildableClass,
-		};
+	// Validate the override type, the game only has these two at the time of writing.
+	if (hologramOverrideClass == UFGHologramOverride_ConveyorAttachment_FloorToLift::StaticClass())
+	{
+		isRegularAttachment = true;
+	}
+	else if (hologramOverrideClass != UFGHologramOverride_ConveyorAttachment_LiftToFloor::StaticClass())
+	{
+		UE_LOG(LogVerticalLogisticsQoL, Log,
+			TEXT("Skipping %s because it has an unknown hologram override class %s."),
+			*buildableClass->GetName(), *hologramOverrideClass->GetName());
+		return;
+	}
 
-		if (isRegularAttachment)
-		{
-			floorToLiftOverrides.Emplace(buildableClass, overrideInfo);
-		}
-		else
-		{
-			liftToFloorOverrides.Add(buildableClass, overrideInfo);
-		}
-	});
+	UClass* overrideBuildableClass = AFGBuildable::GetBuildableClassFromRecipe(overrideRecipeClass);
 
-	// Reserve memory.
+	// By default you can technically have a hologram override that points to any kind of buildable, but
+	// we're only expecting the case where you go to/from a vertical attachment.
+	if (overrideBuildableClass == nullptr || !overrideBuildableClass->IsChildOf<AFGBuildableConveyorAttachment>())
 	{
-		const int32 count = floorToLiftOverrides.Num();
-		CDOEdits.Reserve(count);
-		RegularToVerticalRecipeMap.Reserve(count);
-		VerticalToRegularRecipeMap.Reserve(count);
+		UE_LOG(LogVerticalLogisticsQoL, Log,
+			TEXT("Skipping %s because its hologram override points to %s, which isn't an AFGBuildableConveyorAttachment."),
+			*buildableClass->GetName(), overrideBuildableClass ? *overrideBuildableClass->GetName() : TEXT("null"));
+		return;
 	}
 
-	// Match up the regular/vertical versions and apply the hologram patch.
-	for (auto [buildableClass, verticalInfo] : floorToLiftOverrides)
+	const FOverrideInfo overrideInfo
 	{
-		const OverrideInfo* regularInfo = liftToFloorOverrides.Find(verticalInfo.buildableClass);
+		.recipeClass = overrideRecipeClass,
+		.buildableClass = overrideBuildableClass,
+	};
 
-		// Validate the consistency of the regular/vertical pair.
-		if (regularInfo == nullptr)
+	if (isRegularAttachment)
+	{
+		SetupJob->floorToLiftOverrides.Emplace(buildableClass, overrideInfo);
+	}
+	else
+	{
+		SetupJob->liftToFloorOverrides.Add(buildableClass, overrideInfo);
+	}
+}
+
+// Matches up the regular/vertical versions and applies the hologram patch.
+void UVLQoLGameInstanceModule::PatchConveyorAttachment(UClass* buildableClass, const FOverrideInfo& verticalInfo)
+{
+	const FOverrideInfo* regularInfo = SetupJob->liftToFloorOverrides.Find(verticalInfo.buildableClass);
+
+	// Validate the consistency of the regular/vertical pair.
+	if (regularInfo == nullptr)
+	{
+		UE_LOG(LogVerticalLogisticsQoL, Log,
+			TEXT("Skipping %s because its vertical version doesn't point back to itself."),
+			*buildableClass->GetName())
+		return;
+	}
+	else if (regularInfo->buildableClass != buildableClass)
+	{
+		UE_LOG(LogVerticalLogisticsQoL, Log,
+			TEXT("Skipping %s because its vertical version points back to unrelated class %s."),
+			*buildableClass->GetName(), *regularInfo->buildableClass->GetName())
+		return;
+	}
+
+	UE_LOG(LogVerticalLogisticsQoL, Log,
+		TEXT("Overriding the hologram for %s, detected vertical version is %s."),
+		*buildableClass->GetName(), *verticalInfo.buildableClass->GetName());
+
+	// Write our hologram class into the buildable's CDO.
+	{
+		auto* buildable = buildableClass->GetDefaultObject<AFGBuildableConveyorAttachment>();
+		buildable->mHologramClass = HookConveyorAttachmentHologram;
+		CDOEdits.Add(buildable);
+	}
+
+	// Cache the mapping between the regular/vertical classes.
+	RegularToVerticalRecipeMap.Add(regularInfo->recipeClass, verticalInfo.recipeClass);
+	VerticalToRegularRecipeMap.Add(verticalInfo.recipeClass, regularInfo->recipeClass);
+}
+
+void UVLQoLGameInstanceModule::DumpMemoryReport(FOutputDevice& ar) const
+{
+	FModMemoryTally nativeTally;
+	FModMemoryTally contentTally;
+	FModMemoryTally attachmentClassTally;
+	FModMemoryTally patchedDefaultTally;
+	FModMemoryTally hologramComponentTally;
+
+	const UClass* attachmentClass = AFGBuildableConveyorAttachment::StaticClass();
+
+	for (TObjectIterator<UObject> it; it; ++it)
+	{
+		const UObject* object = *it;
+		const FString packageName = object->GetPackage()->GetName();
+
+		if (packageName.StartsWith(TEXT("/Script/VerticalLogisticsQoL")))
 		{
-			UE_LOG(LogVerticalLogisticsQoL, Log,
-				TEXT("Skipping %s because its vertical version doesn't point back to itself."),
-				*buildableClass->GetName())
-			continue;
+			nativeTally.Add(object);
 		}
-		else if (regularInfo->buildableClass != buildableClass)
+		else if (packageName.StartsWith(TEXT("/VerticalLogisticsQoL/")))
 		{
-			UE_LOG(LogVerticalLogisticsQoL, Log,
-				TEXT("Skipping %s because its vertical version points back to unrelated class %s."),
-				*buildableClass->GetName(), *regularInfo->buildableClass->GetName())
-			continue;
+			contentTally.Add(object);
 		}
-
-		UE_LOG(LogVerticalLogisticsQoL, Log,
-			TEXT("Overriding the hologram for %s, detected vertical version is %s."),
-			*buildableClass->GetName(), *verticalInfo.buildableClass->GetName());
-
-		// Write our hologram class into the buildable's CDO.
+		else if (const UClass* objectClass = Cast<UBlueprintGeneratedClass>(object))
+		{
+			// These are loaded by LoadDerivedClasses; the patched ones stay loaded because of CDOEdits.
+			if (objectClass->IsChildOf(attachmentClass))
+			{
+				attachmentClassTally.Add(object);
+			}
+		}
+		else if (const auto* component = Cast<UMeshComponent>(object))
 		{
-			auto* buildable = buildableClass->GetDefaultObject<AFGBuildableConveyorAttachment>();
-			buildable->mHologramClass = HookConveyorAttachmentHologram;
-			CDOEdits.Add(buildable);
+			if (component->GetOwner() != nullptr
+				&& component->GetOwner()->IsA<AVLQoLConveyorAttachmentHologram>()
+				&& component->ComponentHasTag(HOLOGRAM_MESH_TAG))
+			{
+				hologramComponentTally.Add(object);
+			}
 		}
+	}
 
-		// Cache the mapping between the regular/vertical classes.
-		RegularToVerticalRecipeMap.Add(regularInfo->recipeClass, verticalInfo.recipeClass);
-		VerticalToRegularRecipeMap.Add(verticalInfo.recipeClass, regularInfo->recipeClass);
+	for (const UObject* object : CDOEdits)
+	{
+		if (object != nullptr)
+		{
+			patchedDefaultTally.Add(object);
+		}
 	}
+
+	const SIZE_T recipeMapBytes = RegularToVerticalRecipeMap.GetAllocatedSize() + VerticalToRegularRecipeMap.GetAllocatedSize();
+
+	ar.Log(TEXT("VerticalLogisticsQoL memory:"));
+	nativeTally.Print(ar, TEXT("Native classes"));
+	contentTally.Print(ar, TEXT("Content"));
+	attachmentClassTally.Print(ar, TEXT("Conveyor attachment classes"));
+	patchedDefaultTally.Print(ar, TEXT("Patched class defaults"));
+	hologramComponentTally.Print(ar, TEXT("Hologram components"));
+	FModMemoryTally::PrintEntries(ar, TEXT("Recipe maps"), RegularToVerticalRecipeMap.Num(), recipeMapBytes);
+
+	FModMemoryTally::PrintLLMTag(ar, TEXT("VerticalLogisticsQoL"));
 }
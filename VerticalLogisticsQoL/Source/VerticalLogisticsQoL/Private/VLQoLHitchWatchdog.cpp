@@ -0,0 +1,21 @@
+#include "VLQoLHitchWatchdog.h"
+
+#include "VerticalLogisticsQoL.h"
+
+const TCHAR* const FVLQoLHitchWatchdogTraits::HookNames[] =
+{
+	TEXT("Lift Merge"),
+	TEXT("Lift BeginPlay"),
+	TEXT("Passthrough repair"),
+	TEXT("Attachment setup"),
+	TEXT("UpdateHologramComponents"),
+	TEXT("Blueprint Construct"),
+	TEXT("Lift column TryUpgrade"),
+	TEXT("Lift column Construct"),
+};
+static_assert(UE_ARRAY_COUNT(FVLQoLHitchWatchdogTraits::HookNames) == static_cast<int32>(FVLQoLHitchWatchdogTraits::EHook::Count));
+
+void FVLQoLHitchWatchdogTraits::LogHitch(const FString& message)
+{
+	UE_LOG(LogVerticalLogisticsQoL, Warning, TEXT("%s"), *message);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ModHitchWatchdog.h"
+
+/// The hooks that FVLQoLHitchWatchdog times, and where it reports them.
+struct FVLQoLHitchWatchdogTraits
+{
+	enum class EHook : uint8
+	{
+		LiftMerge,
+		LiftBeginPlay,
+		PassthroughRepair,
+		AttachmentSetup,
+		UpdateHologramComponents,
+		BlueprintConstruct,
+		LiftColumnUpgrade,
+		LiftColumnConstruct,
+		Count
+	};
+
+	static constexpr const TCHAR* BudgetVariableName = TEXT("VLQoL.HitchBudgetMs");
+	/// Indexed by EHook.
+	static const TCHAR* const HookNames[];
+
+	static void LogHitch(const FString& message);
+};
+
+/// Logs which of our hooks ran during any game thread frame that takes longer than
+/// VLQoL.HitchBudgetMs, and keeps the last few frames for VLQoL.HitchReport.
+using FVLQoLHitchWatchdog = TModHitchWatchdog<FVLQoLHitchWatchdogTraits>;
@@ -0,0 +1,199 @@
+#include "VLQoLLiftColumnUpgrade.h"
+
+#include "Buildables/FGBuildableConveyorAttachment.h"
+#include "Buildables/FGBuildableConveyorLift.h"
+#include "Buildables/FGBuildablePassthrough.h"
+#include "FGFactoryConnectionComponent.h"
+#include "Hologram/FGConveyorAttachmentHologram.h"
+#include "Hologram/FGConveyorLiftHologram.h"
+#include "VLQoLBuildModes.h"
+
+namespace
+{
+
+/// Tag used to tell our lifts apart from the hologram's own children.
+const FName ColumnLiftTag(TEXT("VLQoL_ColumnLift"));
+
+/// Stops a runaway search, and keeps the number of child holograms reasonable.
+constexpr int32 MaxColumnLifts = 128;
+
+} // namespace
+
+void FVLQoLLiftColumnUpgrade::Update(AFGConveyorLiftHologram* hologram, bool isUpgrading)
+{
+	AFGBuildableConveyorLift* upgradedLift = hologram->mUpgradedConveyorLift;
+
+	if (!isUpgrading
+		|| upgradedLift == nullptr
+		|| !hologram->IsCurrentBuildMode(UVLQoLLiftColumnBuildMode::StaticClass()))
+	{
+		Clear(hologram);
+		return;
+	}
+
+	FColumnLifts lifts;
+	FindColumn(upgradedLift, hologram->GetBuildClass(), lifts);
+
+	FColumnHolograms holograms;
+	GetColumnHolograms(hologram, holograms);
+
+	// Reuse the holograms that we already have where possible, since this runs every frame that the
+	// build gun is aimed at the column. A child that's still upgrading a lift in the column keeps it,
+	// rather than going by index, so that one lift that can't be upgraded doesn't shift all of the
+	// others on to a different lift every frame.
+	FColumnHolograms spareHolograms;
+	for (AFGConveyorLiftHologram* child : holograms)
+	{
+		const int32 index = lifts.Find(child->mUpgradedConveyorLift);
+		if (index != INDEX_NONE)
+		{
+			lifts.RemoveAtSwap(index, 1, false);	// Already upgraded.
+		}
+		else
+		{
+			spareHolograms.Add(child);
+		}
+	}
+
+	// Each child upgrades its lift exactly as if the build gun was aimed at it. Any that can't are
+	// removed, otherwise they'd build a new lift wherever they happen to be.
+	for (AFGBuildableConveyorLift* lift : lifts)
+	{
+		AFGConveyorLiftHologram* child = spareHolograms.IsEmpty() ? nullptr : spareHolograms.Pop(false);
+		if (child == nullptr)
+		{
+			// Numbering the children by how many there are would reuse the name of one that failed to
+			// upgrade and hasn't finished being destroyed yet.
+			const FName name = MakeUniqueObjectName(hologram->GetLevel(), AFGConveyorLiftHologram::StaticClass(), ColumnLiftTag);
+			child = Cast<AFGConveyorLiftHologram>(AFGHologram::SpawnChildHologramFromRecipe(
+				hologram, name, hologram->GetRecipe(), hologram->GetOwner(), lift->GetActorLocation()));
+			if (child == nullptr)
+				break;
+
+			child->Tags.Add(ColumnLiftTag);
+		}
+
+		const FHitResult hitResult(lift, nullptr, lift->GetActorLocation(), FVector::UpVector);
+		if (!child->TryUpgrade(hitResult))
+		{
+			hologram->mChildren.Remove(child);
+			child->Destroy();
+		}
+	}
+
+	for (AFGConveyorLiftHologram* child : spareHolograms)
+	{
+		hologram->mChildren.Remove(child);
+		child->Destroy();
+	}
+}
+
+void FVLQoLLiftColumnUpgrade::Clear(AFGConveyorLiftHologram* hologram)
+{
+	FColumnHolograms holograms;
+	GetColumnHolograms(hologram, holograms);
+
+	for (AFGConveyorLiftHologram* child : holograms)
+	{
+		hologram->mChildren.Remove(child);
+		child->Destroy();
+	}
+}
+
+bool FVLQoLLiftColumnUpgrade::IsColumnLift(const AFGHologram* hologram)
+{
+	return hologram->ActorHasTag(ColumnLiftTag);
+}
+
+void FVLQoLLiftColumnUpgrade::FindColumn(AFGBuildableConveyorLift* start, const UClass* upgradedClass, FColumnLifts& out_lifts)
+{
+	TSet<AFGBuildableConveyorLift*, DefaultKeyFuncs<AFGBuildableConveyorLift*>, TInlineSetAllocator<32>> visited;
+	FColumnLifts pending;
+
+	const auto visit = [&](AFGBuildableConveyorLift* lift)
+	{
+		bool alreadyVisited;
+		if (lift != nullptr && visited.Num() < MaxColumnLifts)
+		{
+			visited.Add(lift, &alreadyVisited);
+			if (!alreadyVisited)
+			{
+				pending.Add(lift);
+			}
+		}
+	};
+
+	visit(start);
+
+	while (!pending.IsEmpty())
+	{
+		AFGBuildableConveyorLift* lift = pending.Pop(false);
+
+		// Lifts that are already the right tier are still followed, so that the column doesn't stop at
+		// the ones that were upgraded by hand.
+		if (lift != start && lift->GetClass() != upgradedClass)
+		{
+			out_lifts.Add(lift);
+		}
+
+		visit(GetNextLift(lift->GetConnection0()->GetConnection()));
+		visit(GetNextLift(lift->GetConnection1()->GetConnection()));
+
+		// Lifts going through the same passthrough are normally connected to each other anyway, but
+		// this also covers any that aren't.
+		for (const AFGBuildablePassthrough* passthrough : lift->mSnappedPassthroughs)
+		{
+			if (passthrough == nullptr)
+				continue;
+
+			for (const UFGConnectionComponent* snapped : { passthrough->mTopSnappedConnection, passthrough->mBottomSnappedConnection })
+			{
+				visit(snapped ? Cast<AFGBuildableConveyorLift>(snapped->GetOwner()) : nullptr);
+			}
+		}
+	}
+}
+
+AFGBuildableConveyorLift* FVLQoLLiftColumnUpgrade::GetNextLift(const UFGFactoryConnectionComponent* connection)
+{
+	if (connection == nullptr)
+		return nullptr;	// End of the column.
+
+	AFGBuildable* buildable = connection->GetOuterBuildable();
+	if (auto* lift = Cast<AFGBuildableConveyorLift>(buildable))
+		return lift;
+
+	auto* attachment = Cast<AFGBuildableConveyorAttachment>(buildable);
+	if (attachment == nullptr)
+		return nullptr;	// Not part of a column.
+
+	// Go straight through the attachment, from its bottom connection to its top or the other way around.
+	const FName topName = AFGConveyorAttachmentHologram::mLiftConnection_Top;
+	const FName bottomName = AFGConveyorAttachmentHologram::mLiftConnection_Bottom;
+
+	const FName name = connection->GetFName();
+	if (name != topName && name != bottomName)
+		return nullptr;	// Connected to the side.
+
+	const FName oppositeName = name == topName ? bottomName : topName;
+	for (const UFGFactoryConnectionComponent* opposite : TInlineComponentArray<UFGFactoryConnectionComponent*>(attachment))
+	{
+		if (opposite->GetFName() == oppositeName)
+		{
+			const UFGFactoryConnectionComponent* next = opposite->GetConnection();
+			return next ? Cast<AFGBuildableConveyorLift>(next->GetOuterBuildable()) : nullptr;
+		}
+	}
+	return nullptr;
+}
+
+void FVLQoLLiftColumnUpgrade::GetColumnHolograms(const AFGConveyorLiftHologram* hologram, FColumnHolograms& out_holograms)
+{
+	for (AFGHologram* child : hologram->mChildren)
+	{
+		if (auto* lift = Cast<AFGConveyorLiftHologram>(child); lift != nullptr && IsColumnLift(lift))
+		{
+			out_holograms.Add(lift);
+		}
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AFGBuildableConveyorLift;
+class AFGConveyorLiftHologram;
+class AFGHologram;
+class UFGFactoryConnectionComponent;
+
+/// Upgrades a whole vertical column of lifts in one placement when the lift hologram is in the column
+/// build mode.
+///
+/// The column is followed from the lift being upgraded through vertical attachments (using only their
+/// top and bottom connections) and through passthroughs, and every lift in it that isn't already the
+/// hologram's tier gets a child hologram that upgrades it, the same as aiming at it with the build
+/// gun. That way the whole column is previewed, paid for and sent to the server in one construct
+/// message, rather than one per lift.
+class FVLQoLLiftColumnUpgrade
+{
+public:
+	/// Updates the extra lifts after the hologram has tried to upgrade a lift.
+	static void Update(AFGConveyorLiftHologram* hologram, bool isUpgrading);
+
+	/// Removes all of the extra lifts from the hologram.
+	static void Clear(AFGConveyorLiftHologram* hologram);
+
+	/// Whether the hologram is one of the extra lifts, which are left to the game.
+	static bool IsColumnLift(const AFGHologram* hologram);
+
+private:
+	using FColumnLifts = TArray<AFGBuildableConveyorLift*, TInlineAllocator<32>>;
+	using FColumnHolograms = TArray<AFGConveyorLiftHologram*, TInlineAllocator<32>>;
+
+	static void FindColumn(AFGBuildableConveyorLift* start, const UClass* upgradedClass, FColumnLifts& out_lifts);
+	static AFGBuildableConveyorLift* GetNextLift(const UFGFactoryConnectionComponent* connection);
+	static void GetColumnHolograms(const AFGConveyorLiftHologram* hologram, FColumnHolograms& out_holograms);
+};
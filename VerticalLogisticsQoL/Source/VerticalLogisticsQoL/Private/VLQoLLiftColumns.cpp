@@ -0,0 +1,255 @@
+#include "VLQoLLiftColumns.h"
+
+#include "Buildables/FGBuildableAttachmentMerger.h"
+#include "Buildables/FGBuildableAttachmentSplitter.h"
+#include "Buildables/FGBuildableConveyorLift.h"
+#include "Engine/World.h"
+#include "FGBuildableSubsystem.h"
+#include "FGFactoryConnectionComponent.h"
+#include "FGInventoryComponent.h"
+#include "Hologram/FGConveyorAttachmentHologram.h"
+#include "Patching/NativeHookManager.h"
+#include "VerticalLogisticsQoL.h"
+#include "VLQoLBuildableChanges.h"
+
+TMap<const AFGBuildableConveyorAttachment*, FVLQoLLiftColumns::FFusedAttachment> FVLQoLLiftColumns::FusedAttachments;
+uint64 FVLQoLLiftColumns::FusedChangeCount = TNumericLimits<uint64>::Max();
+bool FVLQoLLiftColumns::IsFusingEnabled = true;
+FVLQoLLiftColumns::EBenchmarkPhase FVLQoLLiftColumns::BenchmarkPhase = EBenchmarkPhase::None;
+int32 FVLQoLLiftColumns::BenchmarkFrameCount = 0;
+TArray<double> FVLQoLLiftColumns::BenchmarkTimes[2];
+
+void FVLQoLLiftColumns::Install()
+{
+	FVLQoLBuildableChanges::Install();
+	FWorldDelegates::OnWorldCleanup.AddStatic(&FVLQoLLiftColumns::OnWorldCleanup);
+
+	SUBSCRIBE_UOBJECT_METHOD(AFGBuildableSubsystem, Tick,
+		[](auto& scope, AFGBuildableSubsystem* subsystem, float deltaTime)
+		{
+			// The factory tick happens inside here, so this is the last chance to update the columns before
+			// they're read from other threads.
+			if (FusedChangeCount != FVLQoLBuildableChanges::GetCount())
+			{
+				Rebuild(subsystem);
+			}
+
+			if (LIKELY(BenchmarkPhase == EBenchmarkPhase::None))
+				return;
+
+			const uint64 startCycles = FPlatformTime::Cycles64();
+			scope(subsystem, deltaTime);
+			OnFactoryTickTimed(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles));
+		});
+
+	InstallAttachmentHooks<AFGBuildableAttachmentSplitter>();
+	InstallAttachmentHooks<AFGBuildableAttachmentMerger>();
+}
+
+template<class TAttachment>
+void FVLQoLLiftColumns::InstallAttachmentHooks()
+{
+	SUBSCRIBE_UOBJECT_METHOD(TAttachment, Factory_Tick,
+		[](auto& scope, TAttachment* attachment, float deltaTime)
+		{
+			const FFusedAttachment* fused = FusedAttachments.Find(attachment);
+			if (fused == nullptr)
+				return;
+
+			scope.Cancel();
+
+			// This is the same call that the attachment's own tick makes to pull from the lift feeding it,
+			// minus deciding where the items go, since there's only one place that they can go. There's no
+			// way to see the next item before taking it, so only take one when any item would fit.
+			bool hasEmptySlot = false;
+			for (int32 itemCount = CountBufferedItems(fused->Buffer, hasEmptySlot); itemCount < MaxQueuedItems && hasEmptySlot; ++itemCount)
+			{
+				FInventoryStack stack;
+				float offsetBeyond = 0.0f;
+				if (!fused->Input->Factory_GrabOutput(stack.Item, offsetBeyond, nullptr))
+					break;
+
+				stack.NumItems = 1;
+				fused->Buffer->AddStack(stack);
+				CountBufferedItems(fused->Buffer, hasEmptySlot);
+			}
+		});
+
+	SUBSCRIBE_UOBJECT_METHOD(TAttachment, Factory_GrabOutput_Implementation,
+		[](auto& scope, TAttachment* attachment, UFGFactoryConnectionComponent* connection, FInventoryItem& out_item, float& out_OffsetBeyond, TSubclassOf<UFGItemDescriptor> type)
+		{
+			const FFusedAttachment* fused = FusedAttachments.Find(attachment);
+			if (fused == nullptr)
+				return;
+
+			// Anything that was in the buffer before it was fused is handed out the same way, in slot order.
+			UFGInventoryComponent* buffer = fused->Buffer;
+			for (int32 index = 0; index < buffer->GetSizeLinear(); ++index)
+			{
+				FInventoryStack stack;
+				if (!buffer->GetStackFromIndex(index, stack) || !stack.HasItems())
+					continue;
+				if (type != nullptr && stack.Item.GetItemClass() != type)
+					return;	// Not what the lift is asking for.
+
+				out_item = stack.Item;
+				out_OffsetBeyond = 0.0f;
+				buffer->RemoveFromIndex(index, 1);
+				scope.Override(true);
+				return;
+			}
+			scope.Override(false);
+		});
+}
+
+int32 FVLQoLLiftColumns::CountBufferedItems(const UFGInventoryComponent* buffer, bool& out_hasEmptySlot)
+{
+	int32 itemCount = 0;
+	out_hasEmptySlot = false;
+	for (int32 index = 0; index < buffer->GetSizeLinear(); ++index)
+	{
+		FInventoryStack stack;
+		if (buffer->GetStackFromIndex(index, stack) && stack.HasItems())
+		{
+			itemCount += stack.NumItems;
+		}
+		else
+		{
+			out_hasEmptySlot = true;
+		}
+	}
+	return itemCount;
+}
+
+void FVLQoLLiftColumns::Rebuild(AFGBuildableSubsystem* subsystem)
+{
+	FusedChangeCount = FVLQoLBuildableChanges::GetCount();
+	FusedAttachments.Reset();
+
+	if (!subsystem->HasAuthority())
+		return;	// Clients don't run the factory tick.
+
+	TArray<AFGBuildableConveyorAttachment*> attachments;
+	subsystem->GetTypedBuildable<AFGBuildableConveyorAttachment>(attachments);
+
+	for (AFGBuildableConveyorAttachment* attachment : attachments)
+	{
+		UFGFactoryConnectionComponent* input = IsFusingEnabled ? FindPassThroughInput(attachment) : nullptr;
+		if (input != nullptr && attachment->mBufferInventory != nullptr)
+		{
+			FusedAttachments.Add(attachment, { .Input = input, .Buffer = attachment->mBufferInventory });
+		}
+	}
+
+	// A column starts wherever the lift feeding a fused attachment isn't fed by another fused attachment.
+	int32 columnCount = 0;
+	for (auto&& [attachment, fused] : FusedAttachments)
+	{
+		auto* lift = CastChecked<AFGBuildableConveyorLift>(fused.Input->GetConnection()->GetOuterBuildable());
+		const UFGFactoryConnectionComponent* liftInput = lift->GetConnection0()->GetConnection();
+		if (liftInput == nullptr || !FusedAttachments.Contains(Cast<AFGBuildableConveyorAttachment>(liftInput->GetOuterBuildable())))
+		{
+			++columnCount;
+		}
+	}
+
+	UE_LOG(LogVerticalLogisticsQoL, Log, TEXT("Fused %i vertical attachments into %i lift columns."), FusedAttachments.Num(), columnCount);
+}
+
+void FVLQoLLiftColumns::OnWorldCleanup(UWorld* world, bool sessionEnded, bool cleanupResources)
+{
+	// Attachments in the next world can reuse the addresses of the ones in this world.
+	FusedAttachments.Empty();
+	FusedChangeCount = TNumericLimits<uint64>::Max();
+}
+
+UFGFactoryConnectionComponent* FVLQoLLiftColumns::FindPassThroughInput(AFGBuildableConveyorAttachment* attachment)
+{
+	const FName topName = AFGConveyorAttachmentHologram::mLiftConnection_Top;
+	const FName bottomName = AFGConveyorAttachmentHologram::mLiftConnection_Bottom;
+
+	UFGFactoryConnectionComponent* input = nullptr;
+	UFGFactoryConnectionComponent* output = nullptr;
+
+	for (UFGFactoryConnectionComponent* connection : TInlineComponentArray<UFGFactoryConnectionComponent*>(attachment))
+	{
+		const UFGFactoryConnectionComponent* connectedTo = connection->GetConnection();
+		if (connectedTo == nullptr)
+			continue;
+
+		const FName name = connection->GetFName();
+		if (name != topName && name != bottomName)
+			return nullptr;	// Something is connected to the side, so items don't just pass through.
+		if (!connectedTo->GetOuterBuildable()->IsA<AFGBuildableConveyorLift>())
+			return nullptr;	// Not part of a lift column.
+
+		// The top and bottom directions are the ones that the attachment saved when it was built.
+		switch (connection->GetDirection())
+		{
+		case EFactoryConnectionDirection::FCD_INPUT:
+			input = connection;
+			break;
+		case EFactoryConnectionDirection::FCD_OUTPUT:
+			output = connection;
+			break;
+		default:
+			return nullptr;	// Flow direction isn't known.
+		}
+	}
+
+	return input != nullptr && output != nullptr ? input : nullptr;
+}
+
+void FVLQoLLiftColumns::StartBenchmark(int32 frameCount)
+{
+	if (BenchmarkPhase != EBenchmarkPhase::None)
+	{
+		UE_LOG(LogVerticalLogisticsQoL, Error, TEXT("A lift column benchmark is already running."));
+		return;
+	}
+
+	UE_LOG(LogVerticalLogisticsQoL, Display, TEXT("Timing %i factory ticks without fused lift columns, then %i with them."), frameCount, frameCount);
+
+	BenchmarkFrameCount = frameCount;
+	BenchmarkTimes[0].Reset(frameCount);
+	BenchmarkTimes[1].Reset(frameCount);
+	BenchmarkPhase = EBenchmarkPhase::Unfused;
+	IsFusingEnabled = false;
+	FusedChangeCount = TNumericLimits<uint64>::Max();
+}
+
+void FVLQoLLiftColumns::OnFactoryTickTimed(double milliseconds)
+{
+	TArray<double>& times = BenchmarkTimes[BenchmarkPhase == EBenchmarkPhase::Fused ? 1 : 0];
+	times.Add(milliseconds);
+	if (times.Num() < BenchmarkFrameCount)
+		return;
+
+	if (BenchmarkPhase == EBenchmarkPhase::Unfused)
+	{
+		BenchmarkPhase = EBenchmarkPhase::Fused;
+		IsFusingEnabled = true;
+		FusedChangeCount = TNumericLimits<uint64>::Max();
+		return;
+	}
+
+	auto getMean = [](const TArray<double>& values)
+	{
+		double sum = 0.0;
+		for (const double value : values)
+		{
+			sum += value;
+		}
+		return values.IsEmpty() ? 0.0 : sum / values.Num();
+	};
+
+	const double unfusedMean = getMean(BenchmarkTimes[0]);
+	const double fusedMean = getMean(BenchmarkTimes[1]);
+
+	UE_LOG(LogVerticalLogisticsQoL, Display,
+		TEXT("Factory tick: %.3fms unfused, %.3fms fused (%.1f%% less) over %i frames each, %i fused attachments."),
+		unfusedMean, fusedMean, unfusedMean > 0.0 ? (1.0 - fusedMean / unfusedMean) * 100.0 : 0.0,
+		BenchmarkFrameCount, FusedAttachments.Num());
+
+	BenchmarkPhase = EBenchmarkPhase::None;
+}
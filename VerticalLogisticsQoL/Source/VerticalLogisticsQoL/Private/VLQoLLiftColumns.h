@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AFGBuildableConveyorAttachment;
+class AFGBuildableSubsystem;
+class UFGFactoryConnectionComponent;
+class UFGInventoryComponent;
+class UWorld;
+
+/// Runs straight lift columns as a single pipeline in the factory tick.
+///
+/// A tall vertical manifold is a chain of lifts with vertical splitters and mergers between them,
+/// and each attachment in the chain ticks on its own just to move items from the lift below it to the
+/// lift above it (or the other way around). When an attachment has nothing connected other than the
+/// lift feeding it and the lift that it feeds, using the flow direction that the attachment saved
+/// when it was built, it's fused: its own tick is replaced by a plain hand-over that pulls a few items
+/// from the lift feeding it into its buffer, without any of the splitting or merging logic, and the
+/// next lift takes them straight from the buffer. Items still move one attachment per tick, as they
+/// do without fusing, and every actor stays where it is for visuals and interaction.
+///
+/// The hand-over happens in the attachment's tick rather than when the next lift pulls, because the
+/// lifts either side belong to different conveyor chains, and the chains tick in parallel with each
+/// other but never at the same time as the attachments.
+///
+/// The items in flight are only ever kept in the attachment's own buffer inventory, so they're saved,
+/// refunded when it's dismantled and handed out by its normal tick if it stops being fusable, the
+/// same as without fusing. The columns are worked out again whenever something is built or
+/// dismantled, and forgotten when the world is cleaned up.
+class FVLQoLLiftColumns
+{
+public:
+	static void Install();
+
+	/// Times the factory tick for the given number of frames with and without fusing, then logs both.
+	static void StartBenchmark(int32 frameCount);
+
+private:
+	static void Rebuild(AFGBuildableSubsystem* subsystem);
+	static void OnWorldCleanup(UWorld* world, bool sessionEnded, bool cleanupResources);
+	static UFGFactoryConnectionComponent* FindPassThroughInput(AFGBuildableConveyorAttachment* attachment);
+	static void OnFactoryTickTimed(double milliseconds);
+
+	template<class TAttachment>
+	static void InstallAttachmentHooks();
+
+	/// How many items a fused attachment pulls ahead of the next lift.
+	static constexpr int32 MaxQueuedItems = 4;
+
+	struct FFusedAttachment
+	{
+		UFGFactoryConnectionComponent* Input = nullptr;
+		/// Filled by the attachment's tick and emptied by the next lift's tick, which never overlap.
+		UFGInventoryComponent* Buffer = nullptr;
+	};
+
+	/// Counts the items in a buffer, and finds out whether it has a free slot to pull another into.
+	static int32 CountBufferedItems(const UFGInventoryComponent* buffer, bool& out_hasEmptySlot);
+
+	/// The fused attachments. Only added to or removed from on the game thread, outside of the factory
+	/// tick, so the parallel factory tick can look things up freely.
+	static TMap<const AFGBuildableConveyorAttachment*, FFusedAttachment> FusedAttachments;
+	static uint64 FusedChangeCount;
+	static bool IsFusingEnabled;
+
+	enum class EBenchmarkPhase : uint8 { None, Unfused, Fused };
+	static EBenchmarkPhase BenchmarkPhase;
+	static int32 BenchmarkFrameCount;
+	static TArray<double> BenchmarkTimes[2];
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+// Deliberately doesn't include anything from the engine, so that the lift topology model in
+// Tools/LiftTopology can build it on its own.
+#include <cstdint>
+
+/// The repairs that the lift topology fixes make, written once against an adapter so that the hooks
+/// run them on the game's lifts and passthroughs and the model runs exactly the same code on its own
+/// structs. Anything that the model finds wrong with these is wrong in the game as well.
+///
+/// An adapter has the types FLift, FPassthrough and FConnection, where FConnection is what a lift
+/// end is connected to, along with NoPassthrough, and these functions:
+/// - GetPassthrough(lift, end) and GetPassthroughZ(passthrough).
+/// - GetEndZ(lift, end), the height of one end of a lift.
+/// - IsSnappedBack(passthrough, lift), whether the passthrough links to the lift on either side.
+/// - SetSnapped(passthrough, side, lift, end), which links that side of the passthrough to the lift.
+/// - GetConnected(lift, end), IsConnectedTo(connection, lift) and IsValid(connection).
+/// - IsConnected(lift, end) and Connect(lift, end, connection).
+class FVLQoLLiftTopology
+{
+public:
+	enum class EPassthroughSide : uint8_t { Bottom, Top };
+	enum class EMergeOrder : uint8_t { Lift0First, Lift1First, NotConnected };
+
+	/// The side of a passthrough that a lift end is snapped to, worked out from the height of the
+	/// passthrough and the height of the lift's other end.
+	static EPassthroughSide GetPassthroughSide(double passthroughZ, double oppositeEndZ)
+	{
+		return passthroughZ < oppositeEndZ ? EPassthroughSide::Top : EPassthroughSide::Bottom;
+	}
+
+	/// Which of two lifts being merged is on the input side, given whether lift 0's input or output is
+	/// connected to lift 1.
+	static EMergeOrder GetMergeOrder(bool lift0InputIsLift1, bool lift0OutputIsLift1)
+	{
+		if (lift0InputIsLift1)
+			return EMergeOrder::Lift1First;
+		if (lift0OutputIsLift1)
+			return EMergeOrder::Lift0First;
+		return EMergeOrder::NotConnected;
+	}
+
+	/// Points the passthroughs that a lift is snapped to back at the lift, after the game has handed
+	/// them over to a new lift without telling them. See FixLostPassthroughLinks.
+	template <typename TAdapter>
+	static void RepairPassthroughLinks(TAdapter& adapter, typename TAdapter::FLift lift)
+	{
+		const typename TAdapter::FPassthrough passthroughs[] =
+		{
+			adapter.GetPassthrough(lift, 0),
+			adapter.GetPassthrough(lift, 1),
+		};
+
+		if (passthroughs[0] == TAdapter::NoPassthrough && passthroughs[1] == TAdapter::NoPassthrough)
+			return;	// Not snapped to any passthroughs.
+
+		// Don't do anything if the passthroughs do in fact link back to the lift, as that probably means
+		// that we're running on a game version where the original bug has been fixed.
+		for (const auto& passthrough : passthroughs)
+		{
+			if (passthrough != TAdapter::NoPassthrough && adapter.IsSnappedBack(passthrough, lift))
+				return;
+		}
+
+		for (int32_t end = 0; end < 2; ++end)
+		{
+			if (passthroughs[end] == TAdapter::NoPassthrough)
+				continue;
+
+			// Use the vertical position to infer which side of the passthrough it must be snapped to.
+			const EPassthroughSide side = GetPassthroughSide(adapter.GetPassthroughZ(passthroughs[end]), adapter.GetEndZ(lift, 1 - end));
+			adapter.SetSnapped(passthroughs[end], side, lift, end);
+		}
+	}
+
+	/// Works out what the lift made by merging two lifts will be connected to, so that the connections
+	/// can be restored if the game's own attempt is rejected.
+	template <typename TAdapter>
+	static EMergeOrder FindMergedConnections(const TAdapter& adapter, typename TAdapter::FLift lift0, typename TAdapter::FLift lift1,
+		typename TAdapter::FConnection& out_input, typename TAdapter::FConnection& out_output)
+	{
+		const typename TAdapter::FConnection lift0Input = adapter.GetConnected(lift0, 0);
+		const typename TAdapter::FConnection lift0Output = adapter.GetConnected(lift0, 1);
+
+		const EMergeOrder order = GetMergeOrder(adapter.IsConnectedTo(lift0Input, lift1), adapter.IsConnectedTo(lift0Output, lift1));
+		switch (order)
+		{
+		case EMergeOrder::Lift1First:
+			// Lift 0 is on the output side.
+			out_input = adapter.GetConnected(lift1, 0);
+			out_output = lift0Output;
+			break;
+		case EMergeOrder::Lift0First:
+			// Lift 0 is on the input side.
+			out_input = lift0Input;
+			out_output = adapter.GetConnected(lift1, 1);
+			break;
+		default:
+			break;
+		}
+		return order;
+	}
+
+	/// Connects a merged lift to whatever FindMergedConnections found, where the game's own connections
+	/// were rejected. See FixBrokenConnectionsWhenMergingInBlueprintDesigner.
+	template <typename TAdapter>
+	static void RestoreMergedConnections(TAdapter& adapter, typename TAdapter::FLift merged,
+		const typename TAdapter::FConnection& input, const typename TAdapter::FConnection& output)
+	{
+		if (adapter.IsValid(input) && !adapter.IsConnected(merged, 0))
+		{
+			adapter.Connect(merged, 0, input);
+		}
+		if (adapter.IsValid(output) && !adapter.IsConnected(merged, 1))
+		{
+			adapter.Connect(merged, 1, output);
+		}
+	}
+};
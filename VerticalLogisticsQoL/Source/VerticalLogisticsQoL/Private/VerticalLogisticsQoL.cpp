@@ -5,13 +5,26 @@
 #include "Buildables/FGBuildablePassthrough.h"
 #include "Equipment/FGBuildGunBuild.h"
 #include "FGFactoryConnectionComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Hologram/FGBlueprintHologram.h"
 #include "Hologram/FGConveyorAttachmentHologram.h"
 #include "Hologram/FGConveyorLiftHologram.h"
+#include "Misc/CommandLine.h"
+#include "Misc/ConfigCacheIni.h"
 #include "Net/UnrealNetwork.h"
 #include "Patching/NativeHookManager.h"
+#include "VLQoLBlueprintWiring.h"
+#include "VLQoLBuildModes.h"
+#include "VLQoLBuildableChanges.h"
+#include "VLQoLDeferredHooks.h"
 #include "VLQoLGameInstanceModule.h"
+#include "VLQoLHitchWatchdog.h"
+#include "VLQoLLiftColumnUpgrade.h"
+#include "VLQoLLiftColumns.h"
+#include "VLQoLLiftTopology.h"
 
 DEFINE_LOG_CATEGORY(LogVerticalLogisticsQoL)
+LLM_DEFINE_TAG(VerticalLogisticsQoL);
 
 namespace
 {
@@ -43,30 +56,300 @@ bool CanConnectVertically(const AFGConveyorLiftHologram* lift, const UFGFactoryC
 	return true;
 }
 
+/// Set while a batch of lifts is being constructed, so that their passthroughs are only repaired once at
+/// the end rather than for every lift that gets replaced along the way.
+thread_local TArray<AFGBuildableConveyorLift*>* t_deferredPassthroughRepairs = nullptr;
+
+TAutoConsoleVariable<bool> CVarCacheLiftConnectionSearches(
+	TEXT("VLQoL.CacheLiftConnectionSearches"),
+	true,
+	TEXT("Reuse the connections that lift holograms find for the rest of the frame."));
+
+/// Remembers which connection a lift hologram found for the rest of the frame.
+///
+/// Lift holograms search for connections at both ends, sometimes more than once per update, and each
+/// search is a physics overlap plus our own check for vertical connections. The answers only change
+/// when the hologram moves or something is built or dismantled, so repeating them is wasted work.
+class FLiftConnectionSearchCache
+{
+public:
+	struct FKey
+	{
+		const UFGFactoryConnectionComponent* component;
+		FIntVector location;
+		const AActor* priorityActor;
+		float radius;
+
+		bool operator==(const FKey& other) const = default;
+
+		friend uint32 GetTypeHash(const FKey& key)
+		{
+			uint32 hash = GetTypeHash(key.component);
+			hash = HashCombine(hash, GetTypeHash(key.location));
+			hash = HashCombine(hash, GetTypeHash(key.priorityActor));
+			return HashCombine(hash, GetTypeHash(key.radius));
+		}
+	};
+
+	static FKey MakeKey(const UFGFactoryConnectionComponent* component, const FVector& location, const AActor* priorityActor, float radius)
+	{
+		// Rounded to the nearest centimeter, which is far smaller than any connection's search radius.
+		const FIntVector roundedLocation(FMath::RoundToInt(location.X), FMath::RoundToInt(location.Y), FMath::RoundToInt(location.Z));
+		return { component, roundedLocation, priorityActor, radius };
+	}
+
+	/// Returns true if the search has already been done this frame.
+	bool Find(const FKey& key, UFGFactoryConnectionComponent*& out_result)
+	{
+		if (Frame != GFrameCounter || ChangeCount != FVLQoLBuildableChanges::GetCount())
+		{
+			Frame = GFrameCounter;
+			ChangeCount = FVLQoLBuildableChanges::GetCount();
+			Entries.Reset();
+		}
+
+		if (const TWeakObjectPtr<UFGFactoryConnectionComponent>* entry = Entries.Find(key))
+		{
+			// A stale entry means that the result has been destroyed since, so search again.
+			if (!entry->IsStale())
+			{
+				out_result = entry->Get();
+				++HitCount;
+				return true;
+			}
+		}
+
+		++MissCount;
+		return false;
+	}
+
+	void Add(const FKey& key, UFGFactoryConnectionComponent* result)
+	{
+		Entries.Add(key, result);
+	}
+
+	void PrintStats(FOutputDevice& ar)
+	{
+		const uint64 total = HitCount + MissCount;
+		ar.Logf(TEXT("Lift connection searches: %llu hits, %llu misses (%.1f%% hit rate)."),
+			HitCount, MissCount, total != 0 ? HitCount * 100.0 / total : 0.0);
+		HitCount = 0;
+		MissCount = 0;
+	}
+
+private:
+	TMap<FKey, TWeakObjectPtr<UFGFactoryConnectionComponent>, TInlineSetAllocator<8>> Entries;
+	uint64 Frame = 0;
+	uint64 ChangeCount = 0;
+	uint64 HitCount = 0;
+	uint64 MissCount = 0;
+};
+
+FLiftConnectionSearchCache LiftConnectionSearchCache;
+
+/// The extra actors that a lift hologram ignores for clearance, for its current snap targets.
+struct FIgnoredClearanceActors
+{
+	TWeakObjectPtr<const AFGConveyorLiftHologram> hologram;
+	TArray<const UFGFactoryConnectionComponent*, TInlineAllocator<2>> snappedConnections;
+	uint64 changeCount = 0;
+	TArray<TWeakObjectPtr<AActor>, TInlineAllocator<2>> actors;
+};
+
+/// There's only ever one lift hologram per player, so this stays tiny.
+TArray<FIgnoredClearanceActors, TInlineAllocator<4>> IgnoredClearanceActorsCache;
+
+/// Section in Game.ini that the fixes can be turned off in, e.g. FixClearanceWarnings=False.
+const TCHAR* const FixesConfigSection = TEXT("VerticalLogisticsQoL.Fixes");
+
 } // namespace
 
+const FVerticalLogisticsQoLModule::FFix FVerticalLogisticsQoLModule::Fixes[] =
+{
+	{ TEXT("FixLostPassthroughLinks"), &FVerticalLogisticsQoLModule::FixLostPassthroughLinks },
+	{ TEXT("FixBrokenConnectionsWhenMergingInBlueprintDesigner"), &FVerticalLogisticsQoLModule::FixBrokenConnectionsWhenMergingInBlueprintDesigner },
+	{ TEXT("FixHologramLocking"), &FVerticalLogisticsQoLModule::FixHologramLocking, &AFGConveyorAttachmentHologram::StaticClass },
+	{ TEXT("FixLiftOnAttachmentOffByHalf"), &FVerticalLogisticsQoLModule::FixLiftOnAttachmentOffByHalf, &AFGConveyorLiftHologram::StaticClass },
+	{ TEXT("FixAttachmentOnLiftOffByHalf"), &FVerticalLogisticsQoLModule::FixAttachmentOnLiftOffByHalf },
+	{ TEXT("FixClearanceWarnings"), &FVerticalLogisticsQoLModule::FixClearanceWarnings, &AFGConveyorLiftHologram::StaticClass },
+	{ TEXT("FixMassDismantleVerticalAttachmentAndLifts"), &FVerticalLogisticsQoLModule::FixMassDismantleVerticalAttachmentAndLifts },
+	{ TEXT("FixReverseLiftConnectionFromSnapPoint"), &FVerticalLogisticsQoLModule::FixReverseLiftConnectionFromSnapPoint, &AFGConveyorLiftHologram::StaticClass },
+	{ TEXT("AllowConnectionToExistingAttachment"), &FVerticalLogisticsQoLModule::AllowConnectionToExistingAttachment, &AFGConveyorLiftHologram::StaticClass },
+	{ TEXT("HideLiftArrowWhenSnappedTopToAttachment"), &FVerticalLogisticsQoLModule::HideLiftArrowWhenSnappedTopToAttachment, &AFGConveyorLiftHologram::StaticClass },
+	{ TEXT("PrepareCustomAttachmentHologram"), &FVerticalLogisticsQoLModule::PrepareCustomAttachmentHologram },
+	{ TEXT("NetworkVerticalAttachmentFlowDirection"), &FVerticalLogisticsQoLModule::NetworkVerticalAttachmentFlowDirection, nullptr, true, true },
+	{ TEXT("NetworkLiftMeshRotationFlag"), &FVerticalLogisticsQoLModule::NetworkLiftMeshRotationFlag, nullptr, true, true },
+	{ TEXT("ConnectBlueprintsInBulk"), &FVerticalLogisticsQoLModule::ConnectBlueprintsInBulk, &AFGBlueprintHologram::StaticClass },
+	{ TEXT("FuseLiftColumns"), &FVerticalLogisticsQoLModule::FuseLiftColumns, nullptr, false },
+	{ TEXT("UpgradeLiftColumns"), &FVerticalLogisticsQoLModule::UpgradeLiftColumns, &AFGConveyorLiftHologram::StaticClass },
+};
+
 void FVerticalLogisticsQoLModule::StartupModule()
 {
 	if constexpr (!WITH_EDITOR)
 	{
-		FixLostPassthroughLinks();
-		FixBrokenConnectionsWhenMergingInBlueprintDesigner();
-		FixHologramLocking();
-		FixLiftOnAttachmentOffByHalf();
-		FixAttachmentOnLiftOffByHalf();
-		FixClearanceWarnings();
-		FixMassDismantleVerticalAttachmentAndLifts();
-		FixReverseLiftConnectionFromSnapPoint();
-		AllowConnectionToExistingAttachment();
-		HideLiftArrowWhenSnappedTopToAttachment();
-		PrepareCustomAttachmentHologram();
-		NetworkVerticalAttachmentFlowDirection();
-		NetworkLiftMeshRotationFlag();
+		for (const FFix& fix : Fixes)
+		{
+			if (IsFixEnabledInConfig(fix))
+			{
+				InstallFix(fix);
+			}
+			else
+			{
+				UE_LOG(LogVerticalLogisticsQoL, Log, TEXT("%s is disabled."), fix.Name);
+			}
+		}
+
+		FVLQoLHitchWatchdog::Install();
+
+		IConsoleManager& consoleManager = IConsoleManager::Get();
+
+		ConsoleCommands.Add(consoleManager.RegisterConsoleCommand(
+			TEXT("VLQoL.ListFixes"),
+			TEXT("Lists the fixes and whether they're installed."),
+			FConsoleCommandDelegate::CreateRaw(this, &FVerticalLogisticsQoLModule::ListFixes)));
+
+		ConsoleCommands.Add(consoleManager.RegisterConsoleCommand(
+			TEXT("VLQoL.EnableFix"),
+			TEXT("Installs the named fixes straight away, and keeps them enabled for future sessions. Fixes that change replication take effect after a restart."),
+			FConsoleCommandWithArgsDelegate::CreateRaw(this, &FVerticalLogisticsQoLModule::SetFixEnabled, true)));
+
+		ConsoleCommands.Add(consoleManager.RegisterConsoleCommand(
+			TEXT("VLQoL.DisableFix"),
+			TEXT("Disables the named fixes. They can't be uninstalled, so this takes effect after a restart."),
+			FConsoleCommandWithArgsDelegate::CreateRaw(this, &FVerticalLogisticsQoLModule::SetFixEnabled, false)));
+
+		ConsoleCommands.Add(consoleManager.RegisterConsoleCommand(
+			TEXT("VLQoL.MemoryReport"),
+			TEXT("Prints the classes, objects and memory that the mod is keeping resident."),
+			FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+				[](const TArray<FString>& args, UWorld* world, FOutputDevice& ar)
+				{
+					if (const UVLQoLGameInstanceModule* gameInstanceModule = UVLQoLGameInstanceModule::Get(world))
+					{
+						gameInstanceModule->DumpMemoryReport(ar);
+					}
+					else
+					{
+						ar.Log(TEXT("The game instance module hasn't been created yet."));
+					}
+				})));
+
+		ConsoleCommands.Add(consoleManager.RegisterConsoleCommand(
+			TEXT("VLQoL.HitchReport"),
+			TEXT("Prints how long the last few frames took and which of our hooks ran in them, see VLQoL.HitchBudgetMs."),
+			FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+				[](const TArray<FString>& args, UWorld* world, FOutputDevice& ar)
+				{
+					FVLQoLHitchWatchdog::DumpRecentFrames(ar);
+				})));
 	}
 }
 
 void FVerticalLogisticsQoLModule::ShutdownModule()
 {
+	FVLQoLHitchWatchdog::Uninstall();
+
+	for (IConsoleObject* command : ConsoleCommands)
+	{
+		IConsoleManager::Get().UnregisterConsoleObject(command);
+	}
+	ConsoleCommands.Reset();
+}
+
+const FVerticalLogisticsQoLModule::FFix* FVerticalLogisticsQoLModule::FindFix(const FString& name)
+{
+	for (const FFix& fix : Fixes)
+	{
+		if (name.Equals(fix.Name, ESearchCase::IgnoreCase))
+			return &fix;
+	}
+	return nullptr;
+}
+
+bool FVerticalLogisticsQoLModule::IsFixEnabledInConfig(const FFix& fix)
+{
+	// The command line wins over the config, e.g. -VLQoLDisableFixes=FixClearanceWarnings,FixHologramLocking
+	FString disabledFixes;
+	if (FParse::Value(FCommandLine::Get(), TEXT("VLQoLDisableFixes="), disabledFixes, false))
+	{
+		TArray<FString> names;
+		disabledFixes.ParseIntoArray(names, TEXT(","));
+		return fix.EnabledByDefault
+			&& !names.ContainsByPredicate([&fix](const FString& name) { return name.Equals(fix.Name, ESearchCase::IgnoreCase); });
+	}
+
+	bool enabled = fix.EnabledByDefault;
+	GConfig->GetBool(FixesConfigSection, fix.Name, enabled, GGameIni);
+	return enabled;
+}
+
+void FVerticalLogisticsQoLModule::InstallFix(const FFix& fix)
+{
+	if (InstalledFixes.Contains(&fix) || DeferredFixes.Contains(&fix))
+		return;
+
+	if (fix.DeferUntilHologram != nullptr)
+	{
+		DeferredFixes.Add(&fix);
+		FVLQoLDeferredHooks::Add(fix.DeferUntilHologram(),
+			[this, &fix]
+			{
+				DeferredFixes.Remove(&fix);
+				InstalledFixes.Add(&fix);
+				(this->*fix.Install)();
+			});
+		return;
+	}
+
+	InstalledFixes.Add(&fix);
+	(this->*fix.Install)();
+}
+
+void FVerticalLogisticsQoLModule::SetFixEnabled(const TArray<FString>& args, bool enabled)
+{
+	for (const FString& name : args)
+	{
+		const FFix* fix = FindFix(name);
+		if (fix == nullptr)
+		{
+			UE_LOG(LogVerticalLogisticsQoL, Error, TEXT("There's no fix called %s, see VLQoL.ListFixes."), *name);
+			continue;
+		}
+
+		GConfig->SetBool(FixesConfigSection, fix->Name, enabled, GGameIni);
+
+		if (enabled && fix->RequiresRestart && !InstalledFixes.Contains(fix))
+		{
+			// Installing these part way through a session would leave existing actors and clients that
+			// haven't got the fix disagreeing about what gets replicated.
+			UE_LOG(LogVerticalLogisticsQoL, Display, TEXT("%s will be enabled after a restart."), fix->Name);
+		}
+		else if (enabled)
+		{
+			InstallFix(*fix);
+			UE_LOG(LogVerticalLogisticsQoL, Display, TEXT("%s is enabled."), fix->Name);
+		}
+		else
+		{
+			UE_LOG(LogVerticalLogisticsQoL, Display, TEXT("%s will be disabled after a restart."), fix->Name);
+		}
+	}
+
+	GConfig->Flush(false, GGameIni);
+}
+
+void FVerticalLogisticsQoLModule::ListFixes() const
+{
+	for (const FFix& fix : Fixes)
+	{
+		UE_LOG(LogVerticalLogisticsQoL, Display, TEXT("%s: %s%s"),
+			fix.Name,
+			InstalledFixes.Contains(&fix) ? TEXT("installed")
+				: DeferredFixes.Contains(&fix) ? TEXT("waiting for the first hologram")
+				: TEXT("not installed"),
+			IsFixEnabledInConfig(fix) ? TEXT("") : TEXT(", disabled in config"));
+	}
 }
 
 void FVerticalLogisticsQoLModule::FixLostPassthroughLinks()
@@ -106,67 +389,73 @@ void FVerticalLogisticsQoLModule::FixLostPassthroughLinks()
 	private:
 		static void Repair(AFGBuildableConveyorLift* lift)
 		{
-			if (lift == nullptr)
+			if (TArray<AFGBuildableConveyorLift*>* deferredRepairs = t_deferredPassthroughRepairs; deferredRepairs && lift)
+			{
+				deferredRepairs->AddUnique(lift);	// Repaired once the whole batch is done.
 				return;
+			}
+			RepairPassthroughLinks(lift);
+		}
+	} hook;
 
-			const TArray<AFGBuildablePassthrough*>& snappedPassthroughs = lift->mSnappedPassthroughs;
+	SUBSCRIBE_METHOD_AFTER(AFGBuildableConveyorLift::DuplicateLift, hook);
+	SUBSCRIBE_METHOD_AFTER(AFGBuildableConveyorLift::Merge, hook);
+	SUBSCRIBE_METHOD_AFTER(AFGBuildableConveyorLift::Split, hook);
+}
 
-			if (snappedPassthroughs.Num() != 2)
-				return;	// Shouldn't ever happen?
-			if (snappedPassthroughs[0] == nullptr && snappedPassthroughs[1] == nullptr)
-				return;	// Not snapped to any passthroughs.
+struct FVerticalLogisticsQoLModule::FLiftAdapter
+{
+	using FLift = AFGBuildableConveyorLift*;
+	using FPassthrough = AFGBuildablePassthrough*;
+	using FConnection = UFGFactoryConnectionComponent*;
+	static constexpr FPassthrough NoPassthrough = nullptr;
 
-			// Don't do anything if the passthroughs do in fact link back to the lift, as that probably means
-			// that we're running on a game version where the original bug has been fixed.
-			for (AFGBuildablePassthrough* passthrough : snappedPassthroughs)
-			{
-				if (passthrough != nullptr)
-				{
-					if (UFGConnectionComponent* top = passthrough->mTopSnappedConnection)
-					{
-						if (top->GetOwner() == lift)
-							return;
-					}
-					if (UFGConnectionComponent* bottom = passthrough->mBottomSnappedConnection)
-					{
-						if (bottom->GetOwner() == lift)
-							return;
-					}
-				}
-			}
+	static UFGFactoryConnectionComponent* GetEnd(FLift lift, int32 end)
+	{
+		return end == 0 ? lift->GetConnection0() : lift->GetConnection1();
+	}
 
-			UFGFactoryConnectionComponent* connectionComponents[] =
-			{
-				lift->GetConnection0(),
-				lift->GetConnection1(),
-			};
+	static FPassthrough GetPassthrough(FLift lift, int32 end) { return lift->mSnappedPassthroughs[end]; }
+	static double GetPassthroughZ(FPassthrough passthrough) { return passthrough->GetActorLocation().Z; }
+	static double GetEndZ(FLift lift, int32 end) { return GetEnd(lift, end)->GetComponentLocation().Z; }
 
-			for (int i = 0; i != 2; ++i)
-			{
-				AFGBuildablePassthrough* passthrough = snappedPassthroughs[i];
+	static bool IsSnappedBack(FPassthrough passthrough, FLift lift)
+	{
+		const UFGConnectionComponent* top = passthrough->mTopSnappedConnection;
+		const UFGConnectionComponent* bottom = passthrough->mBottomSnappedConnection;
+		return (top != nullptr && top->GetOwner() == lift) || (bottom != nullptr && bottom->GetOwner() == lift);
+	}
 
-				if (passthrough == nullptr)
-					continue;
+	static void SetSnapped(FPassthrough passthrough, FVLQoLLiftTopology::EPassthroughSide side, FLift lift, int32 end)
+	{
+		if (side == FVLQoLLiftTopology::EPassthroughSide::Top)
+		{
+			passthrough->SetTopSnappedConnection(GetEnd(lift, end));
+		}
+		else
+		{
+			passthrough->SetBottomSnappedConnection(GetEnd(lift, end));
+		}
+	}
 
-				UFGFactoryConnectionComponent* connection = connectionComponents[i];
-				UFGFactoryConnectionComponent* oppositeConnection = connectionComponents[!i];
+	static FConnection GetConnected(FLift lift, int32 end) { return GetEnd(lift, end)->GetConnection(); }
+	static bool IsConnectedTo(FConnection connection, FLift lift) { return connection != nullptr && connection->GetOuterBuildable() == lift; }
+	static bool IsValid(FConnection connection) { return ::IsValid(connection); }
+	static bool IsConnected(FLift lift, int32 end) { return GetConnected(lift, end) != nullptr; }
+	static void Connect(FLift lift, int32 end, FConnection connection) { GetEnd(lift, end)->SetConnection(connection); }
+};
 
-				// Use the vertical position to infer which side of the passthrough it must be snapped to.
-				if (passthrough->GetActorLocation().Z < oppositeConnection->GetComponentLocation().Z)
-				{
-					passthrough->SetTopSnappedConnection(connection);
-				}
-				else
-				{
-					passthrough->SetBottomSnappedConnection(connection);
-				}
-			}
-		}
-	} hook;
+void FVerticalLogisticsQoLModule::RepairPassthroughLinks(AFGBuildableConveyorLift* lift)
+{
+	const FVLQoLHitchWatchdog::FScope watchdogScope(FVLQoLHitchWatchdog::EHook::PassthroughRepair);
 
-	SUBSCRIBE_METHOD_AFTER(AFGBuildableConveyorLift::DuplicateLift, hook);
-	SUBSCRIBE_METHOD_AFTER(AFGBuildableConveyorLift::Merge, hook);
-	SUBSCRIBE_METHOD_AFTER(AFGBuildableConveyorLift::Split, hook);
+	if (lift == nullptr)
+		return;
+	if (lift->mSnappedPassthroughs.Num() != 2)
+		return;	// Shouldn't ever happen?
+
+	FLiftAdapter adapter;
+	FVLQoLLiftTopology::RepairPassthroughLinks(adapter, lift);
 }
 
 void FVerticalLogisticsQoLModule::FixBrokenConnectionsWhenMergingInBlueprintDesigner()
@@ -184,6 +473,8 @@ void FVerticalLogisticsQoLModule::FixBrokenConnectionsWhenMergingInBlueprintDesi
 	SUBSCRIBE_UOBJECT_METHOD(AFGBuildableConveyorLift, BeginPlay,
 		[](auto& scope, AFGBuildableConveyorLift* lift)
 		{
+			const FVLQoLHitchWatchdog::FScope watchdogScope(FVLQoLHitchWatchdog::EHook::LiftBeginPlay);
+
 			// If this lift is being constructed as part of a merge operation, then we need to fix up the
 			// connections that would've been rejected earlier. Unfortunately this needs to happen before
 			// BeginPlay so that the lift gets the right meshes and clearance, but there's nothing that we can
@@ -193,24 +484,16 @@ void FVerticalLogisticsQoLModule::FixBrokenConnectionsWhenMergingInBlueprintDesi
 			if (UNLIKELY(pendingMerge != nullptr))
 			{
 				t_pendingMerge = nullptr;
-				if (UFGFactoryConnectionComponent* input = pendingMerge->input; IsValid(input))
-				{
-					UFGFactoryConnectionComponent* connection = lift->GetConnection0();
-					if (connection->GetConnection() == nullptr)
-						connection->SetConnection(input);
-				}
-				if (UFGFactoryConnectionComponent* output = pendingMerge->output; IsValid(output))
-				{
-					UFGFactoryConnectionComponent* connection = lift->GetConnection1();
-					if (connection->GetConnection() == nullptr)
-						connection->SetConnection(output);
-				}
+				FLiftAdapter adapter;
+				FVLQoLLiftTopology::RestoreMergedConnections(adapter, lift, pendingMerge->input, pendingMerge->output);
 			}
 		});
 
 	SUBSCRIBE_METHOD(AFGBuildableConveyorLift::Merge,
 		([](auto& scope, const TArray<AFGBuildableConveyorLift*>& lifts)
 		{
+			const FVLQoLHitchWatchdog::FScope watchdogScope(FVLQoLHitchWatchdog::EHook::LiftMerge);
+
 			if (lifts.Num() != 2)
 				return;
 
@@ -227,33 +510,12 @@ void FVerticalLogisticsQoLModule::FixBrokenConnectionsWhenMergingInBlueprintDesi
 					return;
 			}
 
+			// Figure out what the input and output for the new lift will be.
 			UFGFactoryConnectionComponent* input = nullptr;
 			UFGFactoryConnectionComponent* output = nullptr;
-
-			// Figure out what the input and output for the new lift will be.
-			{
-				UFGFactoryConnectionComponent* lift0Input = lift0->GetConnection0()->GetConnection();
-				UFGFactoryConnectionComponent* lift0Output = lift0->GetConnection1()->GetConnection();
-				UFGFactoryConnectionComponent* lift1Input = lift1->GetConnection0()->GetConnection();
-				UFGFactoryConnectionComponent* lift1Output = lift1->GetConnection1()->GetConnection();
-
-				if (lift0Input != nullptr && lift0Input->GetOuterBuildable() == lift1)
-				{
-					// Lift 0 is on the output side.
-					input = lift1Input;
-					output = lift0Output;
-				}
-				else if (lift0Output != nullptr && lift0Output->GetOuterBuildable() == lift1)
-				{
-					// Lift 0 is on the input side.
-					input = lift0Input;
-					output = lift1Output;
-				}
-				else
-				{
-					return;
-				}
-			}
+			const FLiftAdapter adapter;
+			if (FVLQoLLiftTopology::FindMergedConnections(adapter, lift0, lift1, input, output) == FVLQoLLiftTopology::EMergeOrder::NotConnected)
+				return;
 
 			const PendingMerge pendingMerge = { .input = input, .output = output, };
 			t_pendingMerge = &pendingMerge;
@@ -389,31 +651,78 @@ void FVerticalLogisticsQoLModule::FixClearanceWarnings()
 	SUBSCRIBE_UOBJECT_METHOD_AFTER(AFGConveyorLiftHologram, GetIgnoredClearanceActors,
 		[](const AFGConveyorLiftHologram* hologram, TSet<AActor*>& ignoredActors)
 		{
-			for (const UFGFactoryConnectionComponent* connection : hologram->mSnappedConnectionComponents)
+			// This gets called for every clearance check, but the answer only changes when the lift is
+			// snapped to something else or when something is built or dismantled, so hang on to it.
+			FIgnoredClearanceActors* cached = IgnoredClearanceActorsCache.FindByPredicate(
+				[hologram](const FIgnoredClearanceActors& entry) { return entry.hologram == hologram; });
+
+			if (cached == nullptr)
 			{
-				if (connection == nullptr)
-					continue;
+				IgnoredClearanceActorsCache.RemoveAllSwap(
+					[](const FIgnoredClearanceActors& entry) { return !entry.hologram.IsValid(); });
+				cached = &IgnoredClearanceActorsCache.AddDefaulted_GetRef();
+				cached->hologram = hologram;
+				cached->changeCount = FVLQoLBuildableChanges::GetCount() - 1;
+			}
 
-				const FVector connectorNormal = connection->GetConnectorNormal();
-				if (!IsVerticalConnector(connectorNormal.Z))
-					continue;
-				const FVector connectorLocation = connection->GetConnectorLocation();
+			bool isUpToDate = cached->changeCount == FVLQoLBuildableChanges::GetCount();
+			{
+				int32 index = 0;
+				for (const UFGFactoryConnectionComponent* connection : hologram->mSnappedConnectionComponents)
+				{
+					if (!cached->snappedConnections.IsValidIndex(index) || cached->snappedConnections[index] != connection)
+					{
+						isUpToDate = false;
+						break;
+					}
+					++index;
+				}
+			}
+
+			if (!isUpToDate)
+			{
+				cached->snappedConnections.Reset();
+				cached->changeCount = FVLQoLBuildableChanges::GetCount();
+				cached->actors.Reset();
+
+				for (const UFGFactoryConnectionComponent* connection : hologram->mSnappedConnectionComponents)
+				{
+					cached->snappedConnections.Add(connection);
+					if (connection == nullptr)
+						continue;
+
+					const FVector connectorNormal = connection->GetConnectorNormal();
+					if (!IsVerticalConnector(connectorNormal.Z))
+						continue;
+					const FVector connectorLocation = connection->GetConnectorLocation();
+
+					for (auto* otherConnection : TInlineComponentArray<UFGFactoryConnectionComponent*>(connection->GetOuterBuildable()))
+					{
+						if (otherConnection == connection)
+							continue;	// We only care about other connections.
+						UFGFactoryConnectionComponent* connectedTo = otherConnection->GetConnection();
+						if (connectedTo == nullptr)
+							continue;	// Not connected to anything, so there's nothing to clip with.
+						if (!otherConnection->GetConnectorLocation().Equals(connectorLocation))
+							continue;	// Doesn't have the same location, so it won't clip.
+						if (!FVector::Coincident(otherConnection->GetConnectorNormal(), -connectorNormal))
+							continue;	// Not going in the opposite direction.
+						cached->actors.Add(connectedTo->GetOuterBuildable());
+					}
+				}
+			}
 
-				for (auto* otherConnection : TInlineComponentArray<UFGFactoryConnectionComponent*>(connection->GetOuterBuildable()))
+			ignoredActors.Reserve(ignoredActors.Num() + cached->actors.Num());
+			for (const TWeakObjectPtr<AActor>& actor : cached->actors)
+			{
+				if (AActor* ignoredActor = actor.Get())
 				{
-					if (otherConnection == connection)
-						continue;	// We only care about other connections.
-					UFGFactoryConnectionComponent* connectedTo = otherConnection->GetConnection();
-					if (connectedTo == nullptr)
-						continue;	// Not connected to anything, so there's nothing to clip with.
-					if (!otherConnection->GetConnectorLocation().Equals(connectorLocation))
-						continue;	// Doesn't have the same location, so it won't clip.
-					if (!FVector::Coincident(otherConnection->GetConnectorNormal(), -connectorNormal))
-						continue;	// Not going in the opposite direction.
-					ignoredActors.Add(connectedTo->GetOuterBuildable());
+					ignoredActors.Add(ignoredActor);
 				}
 			}
 		});
+
+	FVLQoLBuildableChanges::Install();
 }
 
 void FVerticalLogisticsQoLModule::FixMassDismantleVerticalAttachmentAndLifts()
@@ -494,30 +803,52 @@ void FVerticalLogisticsQoLModule::AllowConnectionToExistingAttachment()
 	SUBSCRIBE_METHOD(UFGFactoryConnectionComponent::FindCompatibleOverlappingConnections,
 		[](auto& scope, UFGFactoryConnectionComponent* component, const FVector& location, const AActor* priorityActor, float radius)
 		{
-			UFGFactoryConnectionComponent* result = scope(component, location, priorityActor, radius);
-			if (result == nullptr)
-				return;
-
 			// Only care about connecting lifts to conveyor attachments.
 			auto* lift = Cast<AFGConveyorLiftHologram>(component->GetOwner());
 			if (lift == nullptr)
 				return;
-			auto* attachment = Cast<AFGBuildableConveyorAttachment>(result->GetOuterBuildable());
-			if (attachment == nullptr)
+
+			const bool useCache = CVarCacheLiftConnectionSearches.GetValueOnGameThread();
+			const FLiftConnectionSearchCache::FKey cacheKey = FLiftConnectionSearchCache::MakeKey(component, location, priorityActor, radius);
+
+			UFGFactoryConnectionComponent* result = nullptr;
+			if (useCache && LiftConnectionSearchCache.Find(cacheKey, result))
+			{
+				scope.Override(result);
 				return;
+			}
 
-			for (auto* attachmentConnection : TInlineComponentArray<UFGFactoryConnectionComponent*>(attachment))
+			result = scope(component, location, priorityActor, radius);
+
+			if (auto* attachment = result ? Cast<AFGBuildableConveyorAttachment>(result->GetOuterBuildable()) : nullptr)
 			{
-				if (component->CanSnapTo(attachmentConnection)
-					&& CanConnectVertically(lift, component, attachmentConnection, radius))
+				for (auto* attachmentConnection : TInlineComponentArray<UFGFactoryConnectionComponent*>(attachment))
 				{
-					// Prioritize vertical connections.
-					scope.Override(attachmentConnection);
-					break;
+					if (component->CanSnapTo(attachmentConnection)
+						&& CanConnectVertically(lift, component, attachmentConnection, radius))
+					{
+						// Prioritize vertical connections.
+						result = attachmentConnection;
+						scope.Override(result);
+						break;
+					}
 				}
 			}
+
+			if (useCache)
+			{
+				LiftConnectionSearchCache.Add(cacheKey, result);
+			}
 		});
 
+	FVLQoLBuildableChanges::Install();
+
+	ConsoleCommands.Add(IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("VLQoL.LiftConnectionCacheStats"),
+		TEXT("Prints and resets the hit and miss counts for the lift connection search cache."),
+		FConsoleCommandWithOutputDeviceDelegate::CreateLambda(
+			[](FOutputDevice& ar) { LiftConnectionSearchCache.PrintStats(ar); })));
+
 	// The base implementation filters out vertical connections because the normal for a lift connection
 	// points out horizontally, which it doesn't see as aligned with vertical connections so it doesn't
 	// allow them.
@@ -786,4 +1117,100 @@ void FVerticalLogisticsQoLModule::NetworkLiftMeshRotationFlag()
 		});
 }
 
+void FVerticalLogisticsQoLModule::ConnectBlueprintsInBulk()
+{
+	// Any connections that a pasted blueprint leaves open get matched up in one go once everything has
+	// been constructed, see FVLQoLBlueprintWiring.
+
+	SUBSCRIBE_UOBJECT_METHOD(AFGBlueprintHologram, Construct,
+		[](auto& scope, AFGBlueprintHologram* blueprint, TArray<AActor*>& out_children, FNetConstructionID constructionID)
+		{
+			const FVLQoLHitchWatchdog::FScope watchdogScope(FVLQoLHitchWatchdog::EHook::BlueprintConstruct);
+
+			AActor* result = scope(blueprint, out_children, constructionID);
+			FVLQoLBlueprintWiring::ConnectConstructedActors(result, out_children);
+		});
+}
+
+void FVerticalLogisticsQoLModule::FuseLiftColumns()
+{
+	// Not a fix as such, but an optional optimization for factories with lots of tall lift manifolds, so
+	// it's off unless it's turned on in the config or with VLQoL.EnableFix. See FVLQoLLiftColumns.
+
+	FVLQoLLiftColumns::Install();
+
+	ConsoleCommands.Add(IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("VLQoL.BenchmarkLiftColumns"),
+		TEXT("Compares the factory tick time with and without fused lift columns. Arguments: [Frames=600]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda(
+			[](const TArray<FString>& args)
+			{
+				int32 frameCount = 600;
+				for (const FString& arg : args)
+				{
+					FParse::Value(*arg, TEXT("Frames="), frameCount);
+				}
+				FVLQoLLiftColumns::StartBenchmark(FMath::Max(frameCount, 1));
+			})));
+}
+
+void FVerticalLogisticsQoLModule::UpgradeLiftColumns()
+{
+	// Upgrading a tall column one lift at a time means one construct message, one lift respawn and one
+	// passthrough repair per lift. The column build mode upgrades all of them from one hologram instead,
+	// see FVLQoLLiftColumnUpgrade.
+
+	SUBSCRIBE_METHOD_VIRTUAL_AFTER(AFGHologram::GetSupportedBuildModes_Implementation, GetDefault<AFGConveyorLiftHologram>(),
+		[](const AFGHologram* hologram, TArray<TSubclassOf<UFGBuildGunModeDescriptor>>& out_buildmodes)
+		{
+			auto* lift = Cast<AFGConveyorLiftHologram>(hologram);
+			if (lift == nullptr || FVLQoLLiftColumnUpgrade::IsColumnLift(lift))
+				return;
+
+			// Make sure that there's a way to get back to the normal behavior.
+			if (out_buildmodes.IsEmpty() && lift->mDefaultBuildMode != nullptr)
+			{
+				out_buildmodes.Add(lift->mDefaultBuildMode);
+			}
+			out_buildmodes.AddUnique(UVLQoLLiftColumnBuildMode::StaticClass());
+		});
+
+	SUBSCRIBE_UOBJECT_METHOD(AFGConveyorLiftHologram, TryUpgrade,
+		[](auto& scope, AFGConveyorLiftHologram* hologram, const FHitResult& hitResult)
+		{
+			if (FVLQoLLiftColumnUpgrade::IsColumnLift(hologram))
+				return;	// One of ours.
+
+			const FVLQoLHitchWatchdog::FScope watchdogScope(FVLQoLHitchWatchdog::EHook::LiftColumnUpgrade);
+
+			const bool isUpgrading = scope(hologram, hitResult);
+			FVLQoLLiftColumnUpgrade::Update(hologram, isUpgrading);
+		});
+
+	SUBSCRIBE_UOBJECT_METHOD(AFGConveyorLiftHologram, Construct,
+		[](auto& scope, AFGConveyorLiftHologram* hologram, TArray<AActor*>& out_children, FNetConstructionID constructionID)
+		{
+			if (!hologram->IsCurrentBuildMode(UVLQoLLiftColumnBuildMode::StaticClass()) || FVLQoLLiftColumnUpgrade::IsColumnLift(hologram))
+				return;
+
+			const FVLQoLHitchWatchdog::FScope watchdogScope(FVLQoLHitchWatchdog::EHook::LiftColumnConstruct);
+
+			// Hold back the passthrough repairs from every lift in the column until they've all been built,
+			// then do them in one go.
+			TArray<AFGBuildableConveyorLift*> deferredRepairs;
+			TArray<AFGBuildableConveyorLift*>* previousRepairs = t_deferredPassthroughRepairs;
+			t_deferredPassthroughRepairs = &deferredRepairs;
+			scope(hologram, out_children, constructionID);
+			t_deferredPassthroughRepairs = previousRepairs;
+
+			for (AFGBuildableConveyorLift* lift : deferredRepairs)
+			{
+				if (IsValid(lift))
+				{
+					RepairPassthroughLinks(lift);
+				}
+			}
+		});
+}
+
 IMPLEMENT_MODULE(FVerticalLogisticsQoLModule, VerticalLogisticsQoL)
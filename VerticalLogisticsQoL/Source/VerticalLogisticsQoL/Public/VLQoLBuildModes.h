@@ -27,3 +27,15 @@ public:
 		mDisplayName = INVTEXT("Vertical (Down)");
 	}
 };
+
+/// Upgrades every lift in the vertical column along with the one being aimed at.
+UCLASS()
+class VERTICALLOGISTICSQOL_API UVLQoLLiftColumnBuildMode : public UFGHologramBuildModeDescriptor
+{
+	GENERATED_BODY()
+public:
+	UVLQoLLiftColumnBuildMode()
+	{
+		mDisplayName = INVTEXT("Whole Column");
+	}
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/Ticker.h"
 #include "Module/GameInstanceModule.h"
 #include "VLQoLGameInstanceModule.generated.h"
 
@@ -19,17 +20,20 @@ public:
 
 	/// Gets the recipe for the vertical version of the given recipe.
 	/// Returns null if the recipe doesn't represent a regular conveyor attachment.
-	TSubclassOf<UFGRecipe> GetVerticalConveyorAttachmentRecipe(TSubclassOf<UFGRecipe> recipe) const
-	{
-		return RegularToVerticalRecipeMap.FindRef(recipe);
-	}
+	/// Finishes patching the conveyor attachments first if that's still in progress.
+	TSubclassOf<UFGRecipe> GetVerticalConveyorAttachmentRecipe(TSubclassOf<UFGRecipe> recipe);
 
 	/// Gets the recipe for the regular (non-vertical) version of the given recipe.
 	/// Returns null if the recipe doesn't represent a vertical conveyor attachment.
-	TSubclassOf<UFGRecipe> GetRegularConveyorAttachmentRecipe(TSubclassOf<UFGRecipe> recipe) const
-	{
-		return VerticalToRegularRecipeMap.FindRef(recipe);
-	}
+	/// Finishes patching the conveyor attachments first if that's still in progress.
+	TSubclassOf<UFGRecipe> GetRegularConveyorAttachmentRecipe(TSubclassOf<UFGRecipe> recipe);
+
+	/// Prints what the mod is keeping resident: its own classes and assets, the conveyor attachment
+	/// classes that it loaded and patched, the recipe maps and the components of any live holograms.
+	void DumpMemoryReport(FOutputDevice& ar) const;
+
+	// UObject
+	virtual void BeginDestroy() override;
 
 	// UGameInstanceModule
 	virtual void DispatchLifecycleEvent(ELifecyclePhase phase) override;
@@ -43,8 +47,43 @@ protected:
 	UPROPERTY(EditDefaultsOnly)
 	TSubclassOf<AFGConveyorAttachmentHologram> HookConveyorAttachmentHologram;
 
+	/// How long the conveyor attachment setup can run for in each frame.
+	UPROPERTY(EditDefaultsOnly)
+	float SetupTimeBudgetMs = 2.0f;
+
 private:
-	void FinishSetup(const FStreamableHandle* loadRequest);
+	struct FOverrideInfo
+	{
+		UClass* recipeClass;
+		UClass* buildableClass;
+	};
+
+	/// Progress of the conveyor attachment setup, which is spread over multiple frames.
+	struct FSetupJob
+	{
+		TArray<UBlueprintGeneratedClass*> pendingClasses;
+		int32 nextClass = 0;
+
+		TArray<TPair<UClass* /* buildableClass */, FOverrideInfo>, TInlineAllocator<64>> floorToLiftOverrides;
+		TMap<UClass* /* buildableClass */, FOverrideInfo, TInlineSetAllocator<64>> liftToFloorOverrides;
+		int32 nextPair = 0;
+
+		double startTime = 0.0;
+		int32 frameCount = 0;
+	};
+
+	void StartSetup();
+	bool TickSetup(float deltaTime);
+	void CompleteSetup();
+	/// Returns true once the setup has finished.
+	bool RunSetup(double endTime);
+	void CheckConveyorAttachment(UBlueprintGeneratedClass* buildableClass);
+	void PatchConveyorAttachment(UClass* buildableClass, const FOverrideInfo& verticalInfo);
+
+	/// Keeps the classes loaded until the setup has finished with them.
+	TSharedPtr<FStreamableHandle> SetupLoadHandle;
+	TUniquePtr<FSetupJob> SetupJob;
+	FTSTicker::FDelegateHandle SetupTickerHandle;
 
 	UPROPERTY()
 	TArray<UObject*> CDOEdits;
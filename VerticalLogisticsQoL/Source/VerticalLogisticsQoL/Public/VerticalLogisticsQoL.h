@@ -1,9 +1,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
 #include "Modules/ModuleManager.h"
 
+class AFGBuildableConveyorLift;
+
 DECLARE_LOG_CATEGORY_EXTERN(LogVerticalLogisticsQoL, Log, All)
+LLM_DECLARE_TAG_API(VerticalLogisticsQoL, VERTICALLOGISTICSQOL_API);
 
 class FVerticalLogisticsQoLModule : public IModuleInterface
 {
@@ -12,6 +16,28 @@ public:
 	virtual void ShutdownModule() override;
 
 private:
+	struct FFix
+	{
+		const TCHAR* Name;
+		void (FVerticalLogisticsQoLModule::*Install)();
+		/// For fixes that only hook holograms, the hologram class to wait for before installing them.
+		UClass* (*DeferUntilHologram)() = nullptr;
+		/// Whether the fix is installed when the config doesn't say either way.
+		bool EnabledByDefault = true;
+		/// For fixes that change what gets replicated, which have to be installed before any actors
+		/// exist and on the server and clients alike, so VLQoL.EnableFix only saves them to the config.
+		bool RequiresRestart = false;
+	};
+
+	/// All of the fixes, in the order that they're installed.
+	static const FFix Fixes[];
+
+	static const FFix* FindFix(const FString& name);
+	static bool IsFixEnabledInConfig(const FFix& fix);
+	void InstallFix(const FFix& fix);
+	void SetFixEnabled(const TArray<FString>& args, bool enabled);
+	void ListFixes() const;
+
 	void FixLostPassthroughLinks();
 	void FixBrokenConnectionsWhenMergingInBlueprintDesigner();
 	void FixHologramLocking();
@@ -25,4 +51,17 @@ private:
 	void PrepareCustomAttachmentHologram();
 	void NetworkVerticalAttachmentFlowDirection();
 	void NetworkLiftMeshRotationFlag();
+	void ConnectBlueprintsInBulk();
+	void FuseLiftColumns();
+	void UpgradeLiftColumns();
+
+	/// Points the passthroughs that a lift is snapped to back at the lift, see FixLostPassthroughLinks.
+	static void RepairPassthroughLinks(AFGBuildableConveyorLift* lift);
+
+	/// Lets FVLQoLLiftTopology make its repairs on the game's lifts.
+	struct FLiftAdapter;
+
+	TSet<const FFix*> InstalledFixes;
+	TSet<const FFix*> DeferredFixes;
+	TArray<IConsoleObject*> ConsoleCommands;
 };
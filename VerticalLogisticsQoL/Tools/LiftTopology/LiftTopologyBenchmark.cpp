@@ -0,0 +1,73 @@
+#include "LiftTopologyModel.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+namespace
+{
+
+/// Builds one model of the benchmark's size and times one kind of edit on it. Each timed edit is
+/// followed by an untimed one that undoes its effect on the size, so that the model stays the size
+/// the benchmark says it is.
+void BenchmarkEdit(benchmark::State& state, FVLQoLLiftTopologyModel::EEdit edit, FVLQoLLiftTopologyModel::EEdit balancingEdit)
+{
+	using FClock = std::chrono::steady_clock;
+
+	std::mt19937_64 random(1);
+	FVLQoLLiftTopologyModel model;
+	model.Generate(random, static_cast<int32_t>(state.range(0)));
+
+	std::vector<FVLQoLLiftTopologyModel::FIndex> lifts;
+	int64_t editCount = 0;
+	for (auto _ : state)
+	{
+		lifts.clear();
+		const FClock::time_point start = FClock::now();
+		editCount += model.RunEdit(edit, random, lifts) ? 1 : 0;
+		state.SetIterationTime(std::chrono::duration<double>(FClock::now() - start).count());
+
+		if (balancingEdit != FVLQoLLiftTopologyModel::EEdit::Count)
+		{
+			model.RunEdit(balancingEdit, random, lifts);
+		}
+	}
+
+	state.counters["Elements"] = model.GetElementCount();
+	state.counters["Edits"] = static_cast<double>(editCount);
+}
+
+void BM_Generate(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		std::mt19937_64 random(1);
+		FVLQoLLiftTopologyModel model;
+		model.Generate(random, static_cast<int32_t>(state.range(0)));
+		benchmark::DoNotOptimize(model.GetElementCount());
+	}
+}
+
+void BM_Split(benchmark::State& state)
+{
+	BenchmarkEdit(state, FVLQoLLiftTopologyModel::EEdit::Split, FVLQoLLiftTopologyModel::EEdit::Merge);
+}
+
+void BM_Merge(benchmark::State& state)
+{
+	BenchmarkEdit(state, FVLQoLLiftTopologyModel::EEdit::Merge, FVLQoLLiftTopologyModel::EEdit::Split);
+}
+
+void BM_Duplicate(benchmark::State& state)
+{
+	BenchmarkEdit(state, FVLQoLLiftTopologyModel::EEdit::Duplicate, FVLQoLLiftTopologyModel::EEdit::Count);
+}
+
+} // namespace
+
+BENCHMARK(BM_Generate)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Split)->RangeMultiplier(10)->Range(1000, 1000000)->UseManualTime();
+BENCHMARK(BM_Merge)->RangeMultiplier(10)->Range(1000, 1000000)->UseManualTime();
+BENCHMARK(BM_Duplicate)->RangeMultiplier(10)->Range(1000, 1000000)->UseManualTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,50 @@
+#include "LiftTopologyModel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Runs random splits, merges and duplications on a model of lifts and passthroughs, checking that the
+// repairs keep every link consistent. Arguments: [Seed=] [Elements=1000000] [Edits=1000000] [Seeds=1]
+// Seeds runs that many seeds in a row, starting from Seed.
+int main(int argc, char** argv)
+{
+	uint64_t seed = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+	int32_t elementCount = 1000000;
+	int64_t editCount = 1000000;
+	int32_t seedCount = 1;
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		if (std::strncmp(arg, "Seed=", 5) == 0)
+			seed = std::strtoull(arg + 5, nullptr, 10);
+		else if (std::strncmp(arg, "Elements=", 9) == 0)
+			elementCount = std::atoi(arg + 9);
+		else if (std::strncmp(arg, "Edits=", 6) == 0)
+			editCount = std::atoll(arg + 6);
+		else if (std::strncmp(arg, "Seeds=", 6) == 0)
+			seedCount = std::atoi(arg + 6);
+		else
+		{
+			std::fprintf(stderr, "Unknown argument %s\n", arg);
+			return 2;
+		}
+	}
+
+	int exitCode = 0;
+	for (int32_t run = 0; run < seedCount; ++run, ++seed)
+	{
+		const FVLQoLLiftTopologyModel::FFuzzResult result = FVLQoLLiftTopologyModel::Fuzz(seed, elementCount, editCount);
+		if (result.Passed)
+		{
+			std::printf("Lift topology fuzz with Seed=%llu passed %lld edits.\n", static_cast<unsigned long long>(seed), static_cast<long long>(result.EditCount));
+		}
+		else
+		{
+			std::printf("Lift topology fuzz with Seed=%llu FAILED. %s\n", static_cast<unsigned long long>(seed), result.Failure.c_str());
+			exitCode = 1;
+		}
+	}
+	return exitCode;
+}
@@ -0,0 +1,17 @@
+#include "LiftTopologyModel.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+// A libFuzzer target: the input picks the edits made to a small model, and any check that fails
+// aborts so that the fuzzer keeps the input.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	const FVLQoLLiftTopologyModel::FFuzzResult result = FVLQoLLiftTopologyModel::FuzzInput(data, size);
+	if (!result.Passed)
+	{
+		std::fprintf(stderr, "Lift topology check failed. %s\n", result.Failure.c_str());
+		std::abort();
+	}
+	return 0;
+}
@@ -0,0 +1,45 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+// Runs the libFuzzer target without libFuzzer, for compilers that don't have it. Each argument is an
+// input file to replay, such as a crash that libFuzzer saved, and with no arguments it runs a few
+// thousand random inputs instead.
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::ifstream file(argv[i], std::ios::binary);
+		if (!file)
+		{
+			std::fprintf(stderr, "Couldn't open %s\n", argv[i]);
+			return 2;
+		}
+		const std::vector<uint8_t> input{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+		LLVMFuzzerTestOneInput(input.data(), input.size());
+		std::printf("Replayed %s.\n", argv[i]);
+	}
+
+	if (argc == 1)
+	{
+		constexpr int32_t InputCount = 4096;
+		std::mt19937_64 random(1);
+		std::vector<uint8_t> input;
+		for (int32_t run = 0; run < InputCount; ++run)
+		{
+			input.resize(std::uniform_int_distribution<size_t>(0, 4096)(random));
+			for (uint8_t& byte : input)
+			{
+				byte = static_cast<uint8_t>(random());
+			}
+			LLVMFuzzerTestOneInput(input.data(), input.size());
+		}
+		std::printf("Ran %i random inputs.\n", InputCount);
+	}
+	return 0;
+}
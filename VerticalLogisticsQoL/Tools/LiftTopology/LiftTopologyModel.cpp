@@ -0,0 +1,603 @@
+#include "LiftTopologyModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+constexpr double StepHeight = 100.0;
+constexpr double MinimumHeight = 200.0;
+constexpr double FloorHeight = 2000.0;
+/// Stops inputs that repeat the same few bytes from running forever.
+constexpr int64_t MaxInputEditCount = 4096;
+
+using EPassthroughSide = FVLQoLLiftTopology::EPassthroughSide;
+using EMergeOrder = FVLQoLLiftTopology::EMergeOrder;
+
+std::string Describe(const char* kind, int32_t index)
+{
+	return std::string(kind) + " " + std::to_string(index);
+}
+
+} // namespace
+
+FVLQoLLiftTopologyModel::FFuzzResult FVLQoLLiftTopologyModel::Fuzz(uint64_t seed, int32_t elementCount, int64_t editCount)
+{
+	FFuzzResult result;
+	std::mt19937_64 random(seed);
+
+	FVLQoLLiftTopologyModel model;
+	model.Generate(random, elementCount);
+	if (!model.CheckAll(result.Failure))
+	{
+		result.Passed = false;
+		result.Failure = "After generating: " + result.Failure;
+		return result;
+	}
+
+	// Checking everything is as slow as generating, so only do it a few times.
+	const int64_t checkAllInterval = std::max<int64_t>(editCount / 8, 1);
+
+	std::vector<FIndex> lifts;
+	for (int64_t i = 0; i < editCount; ++i)
+	{
+		lifts.clear();
+		model.RunRandomEdit(random, lifts);
+		result.EditCount = i + 1;
+
+		std::string failure;
+		bool passed = true;
+		for (const FIndex lift : lifts)
+		{
+			passed = passed && model.CheckLift(lift, failure);
+			for (int32_t connection = 0; passed && connection < 2; ++connection)
+			{
+				const FLift& checkedLift = model.Lifts[lift];
+				if (checkedLift.Passthroughs[connection] != None)
+				{
+					passed = model.CheckPassthrough(checkedLift.Passthroughs[connection], failure);
+				}
+				if (passed && checkedLift.Connections[connection].Kind == EKind::Attachment)
+				{
+					passed = model.CheckAttachment(checkedLift.Connections[connection].Index, failure);
+				}
+			}
+		}
+
+		if (passed && result.EditCount % checkAllInterval == 0)
+		{
+			passed = model.CheckAll(failure);
+		}
+
+		if (!passed)
+		{
+			result.Passed = false;
+			result.Failure = "After edit " + std::to_string(result.EditCount) + ": " + failure;
+			return result;
+		}
+	}
+
+	return result;
+}
+
+FVLQoLLiftTopologyModel::FFuzzResult FVLQoLLiftTopologyModel::FuzzInput(const uint8_t* data, size_t size)
+{
+	FFuzzResult result;
+
+	// The model is always the same, so that the input only has to pick the edits. It's small enough to
+	// check all of it after every edit.
+	std::mt19937_64 generateRandom(1);
+	FVLQoLLiftTopologyModel model;
+	model.Generate(generateRandom, 64);
+
+	FInputRandom random(data, size);
+	std::vector<FIndex> lifts;
+	while (!random.IsEmpty() && result.EditCount < MaxInputEditCount)
+	{
+		lifts.clear();
+		model.RunRandomEdit(random, lifts);
+		++result.EditCount;
+
+		if (!model.CheckAll(result.Failure))
+		{
+			result.Passed = false;
+			result.Failure = "After edit " + std::to_string(result.EditCount) + ": " + result.Failure;
+			return result;
+		}
+	}
+
+	return result;
+}
+
+void FVLQoLLiftTopologyModel::Generate(std::mt19937_64& random, int32_t elementCount)
+{
+	std::uniform_int_distribution<int32_t> floorCounts(2, 6);
+	std::uniform_int_distribution<int32_t> percent(0, 99);
+	std::vector<FIndex> column;
+	std::vector<FIndex> splitLifts;
+
+	// Columns of lifts going up or down through the floors, with a passthrough in each floor and a
+	// vertical attachment part way up about half of the lifts.
+	while (GetElementCount() < elementCount)
+	{
+		const int32_t floorCount = floorCounts(random);
+		const bool goesDown = percent(random) < 25;
+		const bool isInsideBlueprintDesigner = percent(random) < 10;
+
+		column.clear();
+		for (int32_t floor = 0; floor < floorCount; ++floor)
+		{
+			const FIndex lift = AddLift();
+			const double bottomZ = floor * FloorHeight;
+			Lifts[lift].Z[0] = goesDown ? bottomZ + FloorHeight : bottomZ;
+			Lifts[lift].Z[1] = goesDown ? bottomZ : bottomZ + FloorHeight;
+			Lifts[lift].IsInsideBlueprintDesigner = isInsideBlueprintDesigner;
+			column.push_back(lift);
+		}
+
+		for (int32_t floor = 0; floor < floorCount; ++floor)
+		{
+			const FIndex lift = column[floor];
+			const uint8_t bottomConnection = goesDown ? 1 : 0;
+
+			if (floor == 0)
+			{
+				Connect({ EKind::Lift, lift, bottomConnection }, { EKind::External });
+			}
+			else
+			{
+				// The lifts below and above this floor go through a passthrough and connect to each other.
+				const FIndex below = column[floor - 1];
+				const uint8_t belowTopConnection = 1 - bottomConnection;
+				const FIndex passthrough = AddPassthrough();
+				Passthroughs[passthrough].Z = floor * FloorHeight;
+
+				for (const FLink& end : { FLink{ EKind::Lift, below, belowTopConnection }, FLink{ EKind::Lift, lift, bottomConnection } })
+				{
+					FLift& snappedLift = Lifts[end.Index];
+					snappedLift.Passthroughs[end.Connection] = passthrough;
+					const EPassthroughSide side = FVLQoLLiftTopology::GetPassthroughSide(Passthroughs[passthrough].Z, snappedLift.Z[1 - end.Connection]);
+					Passthroughs[passthrough].Snapped[static_cast<int32_t>(side)] = end;
+				}
+
+				if (goesDown)
+				{
+					Connect({ EKind::Lift, lift, 1 }, { EKind::Lift, below, 0 });
+				}
+				else
+				{
+					Connect({ EKind::Lift, below, 1 }, { EKind::Lift, lift, 0 });
+				}
+			}
+
+			if (floor == floorCount - 1)
+			{
+				Connect({ EKind::Lift, lift, static_cast<uint8_t>(1 - bottomConnection) }, { EKind::External });
+			}
+		}
+
+		for (const FIndex lift : column)
+		{
+			if (percent(random) < 50)
+			{
+				splitLifts.clear();
+				TrySplit(lift, (Lifts[lift].Z[0] + Lifts[lift].Z[1]) / 2.0, splitLifts);
+			}
+		}
+	}
+}
+
+FVLQoLLiftTopologyModel::FIndex FVLQoLLiftTopologyModel::AddLift()
+{
+	FIndex lift;
+	if (!FreeLifts.empty())
+	{
+		lift = FreeLifts.back();
+		FreeLifts.pop_back();
+		Lifts[lift] = FLift();
+	}
+	else
+	{
+		lift = static_cast<FIndex>(Lifts.size());
+		Lifts.emplace_back();
+	}
+
+	Lifts[lift].IsAlive = true;
+	++LiftCount;
+	return lift;
+}
+
+FVLQoLLiftTopologyModel::FIndex FVLQoLLiftTopologyModel::AddPassthrough()
+{
+	// Passthroughs are never removed.
+	const FIndex passthrough = static_cast<FIndex>(Passthroughs.size());
+	Passthroughs.emplace_back().IsAlive = true;
+	++PassthroughCount;
+	return passthrough;
+}
+
+FVLQoLLiftTopologyModel::FIndex FVLQoLLiftTopologyModel::AddAttachment()
+{
+	FIndex attachment;
+	if (!FreeAttachments.empty())
+	{
+		attachment = FreeAttachments.back();
+		FreeAttachments.pop_back();
+		Attachments[attachment] = FAttachment();
+	}
+	else
+	{
+		attachment = static_cast<FIndex>(Attachments.size());
+		Attachments.emplace_back();
+	}
+
+	Attachments[attachment].IsAlive = true;
+	++AttachmentCount;
+	return attachment;
+}
+
+void FVLQoLLiftTopologyModel::RemoveLift(FIndex lift)
+{
+	// Anything still connected is disconnected, the same as dismantling. Passthroughs are left as they
+	// are, since the game doesn't clear them either.
+	Disconnect({ EKind::Lift, lift, 0 });
+	Disconnect({ EKind::Lift, lift, 1 });
+	Lifts[lift].IsAlive = false;
+	FreeLifts.push_back(lift);
+	--LiftCount;
+}
+
+void FVLQoLLiftTopologyModel::RemoveAttachment(FIndex attachment)
+{
+	Disconnect({ EKind::Attachment, attachment, 0 });
+	Disconnect({ EKind::Attachment, attachment, 1 });
+	Attachments[attachment].IsAlive = false;
+	FreeAttachments.push_back(attachment);
+	--AttachmentCount;
+}
+
+void FVLQoLLiftTopologyModel::Connect(const FLink& from, const FLink& to)
+{
+	GetConnection(from) = to;
+	if (to.Kind == EKind::Lift || to.Kind == EKind::Attachment)
+	{
+		GetConnection(to) = from;
+	}
+}
+
+void FVLQoLLiftTopologyModel::Disconnect(const FLink& link)
+{
+	FLink& connection = GetConnection(link);
+	if (connection.Kind == EKind::Lift || connection.Kind == EKind::Attachment)
+	{
+		GetConnection(connection) = FLink();
+	}
+	connection = FLink();
+}
+
+void FVLQoLLiftTopologyModel::MoveConnection(const FLink& from, const FLink& to)
+{
+	const FLink connection = GetConnection(from);
+	Disconnect(from);
+	if (connection.Kind != EKind::None)
+	{
+		Connect(to, connection);
+	}
+}
+
+FVLQoLLiftTopologyModel::FLink& FVLQoLLiftTopologyModel::GetConnection(const FLink& link)
+{
+	return const_cast<FLink&>(static_cast<const FVLQoLLiftTopologyModel*>(this)->GetConnection(link));
+}
+
+const FVLQoLLiftTopologyModel::FLink& FVLQoLLiftTopologyModel::GetConnection(const FLink& link) const
+{
+	return link.Kind == EKind::Lift
+		? Lifts[link.Index].Connections[link.Connection]
+		: Attachments[link.Index].Connections[link.Connection];
+}
+
+bool FVLQoLLiftTopologyModel::TrySplit(FIndex lift, double z, std::vector<FIndex>& out_lifts)
+{
+	const double lowZ = std::min(Lifts[lift].Z[0], Lifts[lift].Z[1]);
+	const double highZ = std::max(Lifts[lift].Z[0], Lifts[lift].Z[1]);
+	if (z < lowZ + MinimumHeight || z > highZ - MinimumHeight)
+		return false;	// One of the halves would be too short.
+
+	// Adding every new element first means the vectors won't move after this.
+	const FIndex inputLift = AddLift();
+	const FIndex outputLift = AddLift();
+	const FIndex attachment = AddAttachment();
+	const FLift original = Lifts[lift];
+
+	// The game hands each passthrough over to whichever new lift has that end, but doesn't tell the
+	// passthroughs about it.
+	Lifts[inputLift].Z[0] = original.Z[0];
+	Lifts[inputLift].Z[1] = z;
+	Lifts[inputLift].Passthroughs[0] = original.Passthroughs[0];
+	Lifts[inputLift].IsInsideBlueprintDesigner = original.IsInsideBlueprintDesigner;
+
+	Lifts[outputLift].Z[0] = z;
+	Lifts[outputLift].Z[1] = original.Z[1];
+	Lifts[outputLift].Passthroughs[1] = original.Passthroughs[1];
+	Lifts[outputLift].IsInsideBlueprintDesigner = original.IsInsideBlueprintDesigner;
+
+	MoveConnection({ EKind::Lift, lift, 0 }, { EKind::Lift, inputLift, 0 });
+	MoveConnection({ EKind::Lift, lift, 1 }, { EKind::Lift, outputLift, 1 });
+	Connect({ EKind::Lift, inputLift, 1 }, { EKind::Attachment, attachment, 0 });
+	Connect({ EKind::Attachment, attachment, 1 }, { EKind::Lift, outputLift, 0 });
+	RemoveLift(lift);
+
+	// Then each new lift's BeginPlay runs the repair.
+	FAdapter adapter{ *this };
+	FVLQoLLiftTopology::RepairPassthroughLinks(adapter, inputLift);
+	FVLQoLLiftTopology::RepairPassthroughLinks(adapter, outputLift);
+
+	out_lifts.push_back(inputLift);
+	out_lifts.push_back(outputLift);
+	return true;
+}
+
+bool FVLQoLLiftTopologyModel::TryRemoveAttachment(FIndex attachment, bool swapLifts, std::vector<FIndex>& out_lifts)
+{
+	const FLink input = Attachments[attachment].Connections[0];
+	const FLink output = Attachments[attachment].Connections[1];
+	if (input.Kind != EKind::Lift || output.Kind != EKind::Lift)
+		return false;	// Not between two lifts.
+
+	// The game connects the lifts to each other once the attachment is gone, then merges them. Which
+	// way round it passes them isn't fixed, so try both.
+	RemoveAttachment(attachment);
+	Connect(input, output);
+
+	const FIndex merged = swapLifts ? Merge(output.Index, input.Index) : Merge(input.Index, output.Index);
+	if (merged != None)
+	{
+		out_lifts.push_back(merged);
+	}
+	return merged != None;
+}
+
+FVLQoLLiftTopologyModel::FIndex FVLQoLLiftTopologyModel::Merge(FIndex lift0, FIndex lift1)
+{
+	// Worked out before the merge, the same as the Merge hook does.
+	FAdapter adapter{ *this };
+	FLink input;
+	FLink output;
+	const EMergeOrder order = FVLQoLLiftTopology::FindMergedConnections(adapter, lift0, lift1, input, output);
+	if (order == EMergeOrder::NotConnected)
+		return None;
+
+	const FIndex first = order == EMergeOrder::Lift0First ? lift0 : lift1;
+	const FIndex second = order == EMergeOrder::Lift0First ? lift1 : lift0;
+	const bool isInsideBlueprintDesigner = Lifts[first].IsInsideBlueprintDesigner;
+
+	const FIndex merged = AddLift();
+	Lifts[merged].Z[0] = Lifts[first].Z[0];
+	Lifts[merged].Z[1] = Lifts[second].Z[1];
+	Lifts[merged].Passthroughs[0] = Lifts[first].Passthroughs[0];
+	Lifts[merged].Passthroughs[1] = Lifts[second].Passthroughs[1];
+	Lifts[merged].IsInsideBlueprintDesigner = isInsideBlueprintDesigner;
+
+	// The game connects the merged lift to what the two lifts were connected to, except that the
+	// connections are rejected inside a blueprint designer.
+	const FLink gameInput = Lifts[first].Connections[0];
+	const FLink gameOutput = Lifts[second].Connections[1];
+	RemoveLift(first);
+	RemoveLift(second);
+	if (!isInsideBlueprintDesigner)
+	{
+		if (gameInput.Kind != EKind::None)
+			Connect({ EKind::Lift, merged, 0 }, gameInput);
+		if (gameOutput.Kind != EKind::None)
+			Connect({ EKind::Lift, merged, 1 }, gameOutput);
+	}
+
+	// Then the merged lift's BeginPlay runs the repairs.
+	FVLQoLLiftTopology::RestoreMergedConnections(adapter, merged, input, output);
+	FVLQoLLiftTopology::RepairPassthroughLinks(adapter, merged);
+	return merged;
+}
+
+FVLQoLLiftTopologyModel::FIndex FVLQoLLiftTopologyModel::Duplicate(FIndex lift)
+{
+	const FIndex duplicate = AddLift();
+	const FLift& original = Lifts[lift];
+	FLift& copy = Lifts[duplicate];
+	copy.Z[0] = original.Z[0];
+	copy.Z[1] = original.Z[1];
+	copy.Passthroughs[0] = original.Passthroughs[0];
+	copy.Passthroughs[1] = original.Passthroughs[1];
+	copy.IsInsideBlueprintDesigner = original.IsInsideBlueprintDesigner;
+
+	MoveConnection({ EKind::Lift, lift, 0 }, { EKind::Lift, duplicate, 0 });
+	MoveConnection({ EKind::Lift, lift, 1 }, { EKind::Lift, duplicate, 1 });
+	RemoveLift(lift);
+
+	FAdapter adapter{ *this };
+	FVLQoLLiftTopology::RepairPassthroughLinks(adapter, duplicate);
+	return duplicate;
+}
+
+template <typename TRandom>
+bool FVLQoLLiftTopologyModel::RunEdit(EEdit edit, TRandom& random, std::vector<FIndex>& out_lifts)
+{
+	if (edit == EEdit::Merge)
+	{
+		const FIndex attachment = FindRandom(random, EKind::Attachment);
+		if (attachment == None)
+			return false;
+
+		return TryRemoveAttachment(attachment, (random() & 1) != 0, out_lifts);
+	}
+
+	const FIndex lift = FindRandom(random, EKind::Lift);
+	if (lift == None)
+		return false;
+
+	if (edit == EEdit::Duplicate)
+	{
+		out_lifts.push_back(Duplicate(lift));
+		return true;
+	}
+
+	const double lowZ = std::min(Lifts[lift].Z[0], Lifts[lift].Z[1]) + MinimumHeight;
+	const double highZ = std::max(Lifts[lift].Z[0], Lifts[lift].Z[1]) - MinimumHeight;
+	if (highZ < lowZ)
+		return false;	// Too short to split.
+
+	const int32_t stepCount = static_cast<int32_t>(std::floor((highZ - lowZ) / StepHeight));
+	const double z = lowZ + std::uniform_int_distribution<int32_t>(0, stepCount)(random) * StepHeight;
+	return TrySplit(lift, z, out_lifts);
+}
+
+template <typename TRandom>
+FVLQoLLiftTopologyModel::EEdit FVLQoLLiftTopologyModel::RunRandomEdit(TRandom& random, std::vector<FIndex>& out_lifts)
+{
+	const int32_t roll = std::uniform_int_distribution<int32_t>(0, 99)(random);
+	const EEdit edit = roll < 45 ? EEdit::Split : roll < 90 ? EEdit::Merge : EEdit::Duplicate;
+	return RunEdit(edit, random, out_lifts) ? edit : EEdit::Count;
+}
+
+template <typename TRandom>
+FVLQoLLiftTopologyModel::FIndex FVLQoLLiftTopologyModel::FindRandom(TRandom& random, EKind kind) const
+{
+	const size_t count = kind == EKind::Lift ? Lifts.size() : Attachments.size();
+	if (count == 0)
+		return None;
+
+	// Removed elements are reused straight away, so almost every slot is alive.
+	std::uniform_int_distribution<FIndex> indices(0, static_cast<FIndex>(count) - 1);
+	for (int32_t attempt = 0; attempt < 64; ++attempt)
+	{
+		const FIndex index = indices(random);
+		if (kind == EKind::Lift ? Lifts[index].IsAlive : Attachments[index].IsAlive)
+			return index;
+	}
+	return None;
+}
+
+// The harnesses only use these two sources of random numbers.
+template bool FVLQoLLiftTopologyModel::RunEdit(EEdit, std::mt19937_64&, std::vector<FIndex>&);
+template bool FVLQoLLiftTopologyModel::RunEdit(EEdit, FInputRandom&, std::vector<FIndex>&);
+template FVLQoLLiftTopologyModel::EEdit FVLQoLLiftTopologyModel::RunRandomEdit(std::mt19937_64&, std::vector<FIndex>&);
+template FVLQoLLiftTopologyModel::EEdit FVLQoLLiftTopologyModel::RunRandomEdit(FInputRandom&, std::vector<FIndex>&);
+
+void FVLQoLLiftTopologyModel::FAdapter::SetSnapped(FPassthrough passthrough, EPassthroughSide side, FLift lift, int32_t end)
+{
+	Model.Passthroughs[passthrough].Snapped[static_cast<int32_t>(side)] = { EKind::Lift, lift, static_cast<uint8_t>(end) };
+}
+
+bool FVLQoLLiftTopologyModel::FAdapter::IsSnappedBack(FPassthrough passthrough, FLift lift) const
+{
+	for (const FLink& snapped : Model.Passthroughs[passthrough].Snapped)
+	{
+		if (snapped.Kind == EKind::Lift && snapped.Index == lift)
+			return true;
+	}
+	return false;
+}
+
+void FVLQoLLiftTopologyModel::FAdapter::Connect(FLift lift, int32_t end, const FConnection& connection)
+{
+	Model.Connect({ EKind::Lift, lift, static_cast<uint8_t>(end) }, connection);
+}
+
+bool FVLQoLLiftTopologyModel::CheckLift(FIndex lift, std::string& out_failure) const
+{
+	const FLift& checkedLift = Lifts[lift];
+	if (!checkedLift.IsAlive)
+	{
+		out_failure = Describe("Lift", lift) + " has been removed.";
+		return false;
+	}
+	if (std::abs(checkedLift.Z[1] - checkedLift.Z[0]) < MinimumHeight)
+	{
+		out_failure = Describe("Lift", lift) + " is too short.";
+		return false;
+	}
+
+	for (uint8_t connection = 0; connection < 2; ++connection)
+	{
+		const FLink& link = checkedLift.Connections[connection];
+		if (link.Kind == EKind::Lift || link.Kind == EKind::Attachment)
+		{
+			const bool isAlive = link.Kind == EKind::Lift ? Lifts[link.Index].IsAlive : Attachments[link.Index].IsAlive;
+			if (!isAlive || GetConnection(link) != FLink{ EKind::Lift, lift, connection })
+			{
+				out_failure = Describe("Lift", lift) + " connection " + std::to_string(connection) + " isn't connected back.";
+				return false;
+			}
+		}
+
+		const FIndex passthrough = checkedLift.Passthroughs[connection];
+		if (passthrough != None)
+		{
+			const EPassthroughSide side = FVLQoLLiftTopology::GetPassthroughSide(Passthroughs[passthrough].Z, checkedLift.Z[1 - connection]);
+			if (Passthroughs[passthrough].Snapped[static_cast<int32_t>(side)] != FLink{ EKind::Lift, lift, connection })
+			{
+				out_failure = Describe("Passthrough", passthrough) + " doesn't link back to " + Describe("lift", lift) + ".";
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool FVLQoLLiftTopologyModel::CheckPassthrough(FIndex passthrough, std::string& out_failure) const
+{
+	for (const FLink& snapped : Passthroughs[passthrough].Snapped)
+	{
+		if (snapped.Kind == EKind::None)
+			continue;
+
+		if (snapped.Kind != EKind::Lift || !Lifts[snapped.Index].IsAlive || Lifts[snapped.Index].Passthroughs[snapped.Connection] != passthrough)
+		{
+			out_failure = Describe("Passthrough", passthrough) + " links to a lift that isn't snapped to it.";
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FVLQoLLiftTopologyModel::CheckAttachment(FIndex attachment, std::string& out_failure) const
+{
+	if (!Attachments[attachment].IsAlive)
+	{
+		out_failure = Describe("Attachment", attachment) + " has been removed.";
+		return false;
+	}
+
+	for (uint8_t connection = 0; connection < 2; ++connection)
+	{
+		const FLink& link = Attachments[attachment].Connections[connection];
+		if (link.Kind != EKind::Lift || !Lifts[link.Index].IsAlive || GetConnection(link) != FLink{ EKind::Attachment, attachment, connection })
+		{
+			out_failure = Describe("Attachment", attachment) + " connection " + std::to_string(connection) + " isn't connected to a lift.";
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FVLQoLLiftTopologyModel::CheckAll(std::string& out_failure) const
+{
+	for (FIndex lift = 0; lift < static_cast<FIndex>(Lifts.size()); ++lift)
+	{
+		if (Lifts[lift].IsAlive && !CheckLift(lift, out_failure))
+			return false;
+	}
+	for (FIndex passthrough = 0; passthrough < static_cast<FIndex>(Passthroughs.size()); ++passthrough)
+	{
+		if (!CheckPassthrough(passthrough, out_failure))
+			return false;
+	}
+	for (FIndex attachment = 0; attachment < static_cast<FIndex>(Attachments.size()); ++attachment)
+	{
+		if (Attachments[attachment].IsAlive && !CheckAttachment(attachment, out_failure))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "VLQoLLiftTopology.h"
+
+/// Random numbers read from a fuzzer's input, so that the fuzzer picks the edits. Once the input runs
+/// out it only returns zeros.
+class FInputRandom
+{
+public:
+	using result_type = uint32_t;
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return UINT32_MAX; }
+
+	FInputRandom(const uint8_t* data, size_t size)
+		: Data(data)
+		, Size(size)
+	{
+	}
+
+	result_type operator()()
+	{
+		result_type value = 0;
+		for (int32_t byte = 0; byte < 4 && Size > 0; ++byte, ++Data, --Size)
+		{
+			value |= static_cast<result_type>(*Data) << (byte * 8);
+		}
+		return value;
+	}
+
+	bool IsEmpty() const { return Size == 0; }
+
+private:
+	const uint8_t* Data;
+	size_t Size;
+};
+
+/// A model of lifts, the passthroughs that they go through and the vertical attachments between them,
+/// as plain structs, for working on the topology changes away from the game.
+///
+/// Adding a vertical attachment to a lift splits it, removing one merges the two lifts either side of
+/// it back together, and the game sometimes duplicates a lift to replace it. The model makes the same
+/// changes that the game does, including its bugs: passthroughs are handed over to the new lifts
+/// without being told about them, and merging inside a blueprint designer loses the outer connections.
+/// It then repairs them with the same FVLQoLLiftTopology functions that FixLostPassthroughLinks and
+/// FixBrokenConnectionsWhenMergingInBlueprintDesigner call in the game, through FAdapter.
+///
+/// Fuzz and FuzzInput run edits on a generated model and check that every link is still consistent,
+/// and the benchmarks time the edits. See the CMakeLists.txt next to this for the programs that run
+/// them.
+class FVLQoLLiftTopologyModel
+{
+public:
+	using FIndex = int32_t;
+	static constexpr FIndex None = -1;
+
+	enum class EEdit : uint8_t { Split, Merge, Duplicate, Count };
+
+	struct FFuzzResult
+	{
+		bool Passed = true;
+		int64_t EditCount = 0;
+		std::string Failure;
+	};
+
+	FVLQoLLiftTopologyModel() = default;
+
+	/// Runs random edits on a model of about the given size, checking the elements touched by each
+	/// edit straight away and the whole model every so often.
+	static FFuzzResult Fuzz(uint64_t seed, int32_t elementCount, int64_t editCount);
+
+	/// Runs the edits that a fuzzer's input picks on a small model, checking the whole model after each
+	/// one.
+	static FFuzzResult FuzzInput(const uint8_t* data, size_t size);
+
+	/// Fills the model with columns of lifts until it has about the given number of elements.
+	void Generate(std::mt19937_64& random, int32_t elementCount);
+	int32_t GetElementCount() const { return LiftCount + PassthroughCount + AttachmentCount; }
+
+	/// Makes one edit of the given kind on a random lift or attachment, adding the new lifts to
+	/// out_lifts. Returns false if it couldn't find anything to edit.
+	template <typename TRandom>
+	bool RunEdit(EEdit edit, TRandom& random, std::vector<FIndex>& out_lifts);
+
+	/// Picks a random edit, with splits and merges equally likely so that the model stays about the
+	/// same size. Returns the edit, or EEdit::Count if nothing was done.
+	template <typename TRandom>
+	EEdit RunRandomEdit(TRandom& random, std::vector<FIndex>& out_lifts);
+
+private:
+	enum class EKind : uint8_t { None, Lift, Attachment, External };
+
+	/// What one of an element's connections is connected to. For lifts and attachments, connection 0
+	/// is the input and connection 1 is the output.
+	struct FLink
+	{
+		EKind Kind = EKind::None;
+		FIndex Index = None;
+		uint8_t Connection = 0;
+
+		bool operator==(const FLink& other) const = default;
+	};
+
+	struct FLift
+	{
+		/// The height of each end, in the same order as the connections. Lifts that carry items down
+		/// have their input on top.
+		double Z[2] = {};
+		FLink Connections[2];
+		FIndex Passthroughs[2] = { None, None };
+		bool IsInsideBlueprintDesigner = false;
+		bool IsAlive = false;
+	};
+
+	struct FPassthrough
+	{
+		double Z = 0.0;
+		/// The lift ends snapped to the bottom and top, indexed by EPassthroughSide.
+		FLink Snapped[2];
+		bool IsAlive = false;
+	};
+
+	struct FAttachment
+	{
+		FLink Connections[2];
+		bool IsAlive = false;
+	};
+
+	/// Lets FVLQoLLiftTopology make its repairs on the model.
+	struct FAdapter
+	{
+		using FLift = FIndex;
+		using FPassthrough = FIndex;
+		using FConnection = FLink;
+		static constexpr FPassthrough NoPassthrough = None;
+
+		FVLQoLLiftTopologyModel& Model;
+
+		FPassthrough GetPassthrough(FLift lift, int32_t end) const { return Model.Lifts[lift].Passthroughs[end]; }
+		double GetPassthroughZ(FPassthrough passthrough) const { return Model.Passthroughs[passthrough].Z; }
+		double GetEndZ(FLift lift, int32_t end) const { return Model.Lifts[lift].Z[end]; }
+		bool IsSnappedBack(FPassthrough passthrough, FLift lift) const;
+		void SetSnapped(FPassthrough passthrough, FVLQoLLiftTopology::EPassthroughSide side, FLift lift, int32_t end);
+		FConnection GetConnected(FLift lift, int32_t end) const { return Model.Lifts[lift].Connections[end]; }
+		bool IsConnectedTo(const FConnection& connection, FLift lift) const { return connection.Kind == EKind::Lift && connection.Index == lift; }
+		bool IsValid(const FConnection& connection) const { return connection.Kind != EKind::None; }
+		bool IsConnected(FLift lift, int32_t end) const { return IsValid(GetConnected(lift, end)); }
+		void Connect(FLift lift, int32_t end, const FConnection& connection);
+	};
+
+	FIndex AddLift();
+	FIndex AddPassthrough();
+	FIndex AddAttachment();
+	void RemoveLift(FIndex lift);
+	void RemoveAttachment(FIndex attachment);
+
+	void Connect(const FLink& from, const FLink& to);
+	void Disconnect(const FLink& link);
+	/// Moves whatever is connected to one connection over to another.
+	void MoveConnection(const FLink& from, const FLink& to);
+	FLink& GetConnection(const FLink& link);
+	const FLink& GetConnection(const FLink& link) const;
+
+	// The edits, which return the new lifts so that they can be checked.
+	bool TrySplit(FIndex lift, double z, std::vector<FIndex>& out_lifts);
+	bool TryRemoveAttachment(FIndex attachment, bool swapLifts, std::vector<FIndex>& out_lifts);
+	FIndex Merge(FIndex lift0, FIndex lift1);
+	FIndex Duplicate(FIndex lift);
+
+	template <typename TRandom>
+	FIndex FindRandom(TRandom& random, EKind kind) const;
+
+	bool CheckLift(FIndex lift, std::string& out_failure) const;
+	bool CheckPassthrough(FIndex passthrough, std::string& out_failure) const;
+	bool CheckAttachment(FIndex attachment, std::string& out_failure) const;
+	bool CheckAll(std::string& out_failure) const;
+
+	std::vector<FLift> Lifts;
+	std::vector<FPassthrough> Passthroughs;
+	std::vector<FAttachment> Attachments;
+	std::vector<FIndex> FreeLifts;
+	std::vector<FIndex> FreeAttachments;
+	int32_t LiftCount = 0;
+	int32_t PassthroughCount = 0;
+	int32_t AttachmentCount = 0;
+};